@@ -43,6 +43,19 @@ class LibWebRTC {
   LIB_WEBRTC_API static scoped_refptr<RTCPeerConnectionFactory>
   CreateRTCPeerConnectionFactory();
 
+  /**
+   * @brief Creates a new WebRTC PeerConnectionFactory with the audio device
+   * module described by |audio_options|.
+   *
+   * Servers and CI without audio hardware use a kDummy, kFile or kPull
+   * module, which do not probe the platform audio layer.
+   *
+   * @return A scoped_refptr object that points to the newly created
+   * RTCPeerConnectionFactory.
+   */
+  LIB_WEBRTC_API static scoped_refptr<RTCPeerConnectionFactory>
+  CreateRTCPeerConnectionFactory(const RTCAudioDeviceOptions& audio_options);
+
   /**
    * @brief Terminates the WebRTC PeerConnectionFactory and threads.
    *
@@ -90,6 +90,16 @@ class RTCAudioDevice : public RefCountInterface {
 
   virtual int32_t SpeakerVolume(uint32_t& volume) = 0;
 
+  /**
+   * Runs one tick of a RTCAudioDeviceModuleType::kPull module.
+   *
+   * @param record - tick_ms of interleaved 16 bit audio sent as the
+   *                 microphone input, silence if null.
+   * @param playout - receives tick_ms of the mixed remote audio, may be null.
+   * @return int32_t - 0 if successful, -1 for other modules.
+   */
+  virtual int32_t PullAudio(const int16_t* record, int16_t* playout) = 0;
+
  protected:
   virtual ~RTCAudioDevice() {}
 };
@@ -1,46 +1,45 @@
-#ifndef AUDIO_FRAME_HXX
-#define AUDIO_FRAME_HXX
+#ifndef LIB_WEBRTC_RTC_AUDIO_FRAME_HXX
+#define LIB_WEBRTC_RTC_AUDIO_FRAME_HXX
 
-#include "media_manager_types.h"
+#include "rtc_types.h"
 
-namespace b2bua {
+namespace libwebrtc {
 
-class AudioFrame {
+/**
+ * 10 ms of interleaved 16 bit audio, e.g. the output of RTCAudioMixer.
+ */
+class RTCAudioFrame : public RefCountInterface {
  public:
   /**
-   * @brief Creates a new instance of AudioFrame.
-   * @return AudioFrame*: a pointer to the newly created AudioFrame.
+   * @brief Creates a new, empty instance of RTCAudioFrame.
+   * @return scoped_refptr<RTCAudioFrame>: the newly created frame.
    */
-  MEDIA_MANAGER_API static AudioFrame* Create();
+  LIB_WEBRTC_API static scoped_refptr<RTCAudioFrame> Create();
 
   /**
-   * @brief Creates a new instance of AudioFrame with specified parameters.
+   * @brief Creates a new instance of RTCAudioFrame with specified parameters.
    * @param id: the unique identifier of the frame.
    * @param timestamp: the timestamp of the frame.
-   * @param data: a pointer to the audio data buffer.
+   * @param data: a pointer to the audio data buffer, null for silence.
    * @param samples_per_channel: the number of samples per channel.
    * @param sample_rate_hz: the sample rate in Hz.
    * @param num_channels: the number of audio channels.
-   * @return AudioFrame*: a pointer to the newly created AudioFrame.
+   * @return scoped_refptr<RTCAudioFrame>: the newly created frame.
    */
-  MEDIA_MANAGER_API static AudioFrame* Create(int id,
-                                              uint32_t timestamp,
-                                              const int16_t* data,
-                                              size_t samples_per_channel,
-                                              int sample_rate_hz,
-                                              size_t num_channels = 1);
-
-  /**
-   * @brief Releases the memory of this AudioFrame.
-   */
-  virtual void Release() = 0;
+  LIB_WEBRTC_API static scoped_refptr<RTCAudioFrame> Create(
+      int id,
+      uint32_t timestamp,
+      const int16_t* data,
+      size_t samples_per_channel,
+      int sample_rate_hz,
+      size_t num_channels = 1);
 
  public:
   /**
    * @brief Updates the audio frame with specified parameters.
    * @param id: the unique identifier of the frame.
    * @param timestamp: the timestamp of the frame.
-   * @param data: a pointer to the audio data buffer.
+   * @param data: a pointer to the audio data buffer, null for silence.
    * @param samples_per_channel: the number of samples per channel.
    * @param sample_rate_hz: the sample rate in Hz.
    * @param num_channels: the number of audio channels.
@@ -53,19 +52,20 @@ class AudioFrame {
                            size_t num_channels = 1) = 0;
 
   /**
-   * @brief Copies the contents of another AudioFrame.
-   * @param src: the source AudioFrame to copy from.
+   * @brief Copies the contents of another RTCAudioFrame.
+   * @param src: the source RTCAudioFrame to copy from.
    */
-  virtual void CopyFrom(const AudioFrame& src) = 0;
+  virtual void CopyFrom(const RTCAudioFrame& src) = 0;
 
   /**
-   * @brief Adds another AudioFrame to this one.
-   * @param frame_to_add: the AudioFrame to add.
+   * @brief Adds another RTCAudioFrame of the same format to this one,
+   * saturating at the 16 bit range.
+   * @param frame_to_add: the RTCAudioFrame to add.
    */
-  virtual void Add(const AudioFrame& frame_to_add) = 0;
+  virtual void Add(const RTCAudioFrame& frame_to_add) = 0;
 
   /**
-   * @brief Mutes the audio data in this AudioFrame.
+   * @brief Mutes the audio data in this RTCAudioFrame.
    */
   virtual void Mute() = 0;
 
@@ -73,40 +73,48 @@ class AudioFrame {
    * @brief Returns a pointer to the audio data buffer.
    * @return const int16_t*: a pointer to the audio data buffer.
    */
-  virtual const int16_t* data() = 0;
+  virtual const int16_t* data() const = 0;
+
+  /**
+   * @brief Returns a writable pointer to the audio data buffer.
+   * @return int16_t*: a pointer to the audio data buffer.
+   */
+  virtual int16_t* mutable_data() = 0;
 
   /**
    * @brief Returns the number of samples per channel.
    * @return size_t: the number of samples per channel.
    */
-  virtual size_t samples_per_channel() = 0;
+  virtual size_t samples_per_channel() const = 0;
 
   /**
    * @brief Returns the sample rate in Hz.
    * @return int: the sample rate in Hz.
    */
-  virtual int sample_rate_hz() = 0;
+  virtual int sample_rate_hz() const = 0;
 
   /**
    * @brief Returns the number of audio channels.
    * @return size_t: the number of audio channels.
    */
-  virtual size_t num_channels() = 0;
+  virtual size_t num_channels() const = 0;
 
   /**
-   * @brief Returns the timestamp of the AudioFrame.
-   * @return uint32_t: the timestamp of the AudioFrame.
+   * @brief Returns the timestamp of the RTCAudioFrame.
+   * @return uint32_t: the timestamp of the RTCAudioFrame.
    */
-  virtual uint32_t timestamp() = 0;
+  virtual uint32_t timestamp() const = 0;
 
   /**
-   * @brief Returns the unique identifier of the AudioFrame.
-   * @return int: the unique identifier of the AudioFrame.
+   * @brief Returns the unique identifier of the RTCAudioFrame.
+   * @return int: the unique identifier of the RTCAudioFrame.
    */
+  virtual int id() const = 0;
 
-  virtual int id() = 0;
+ protected:
+  virtual ~RTCAudioFrame() {}
 };
 
-};  // namespace b2bua
+}  // namespace libwebrtc
 
-#endif
+#endif  // LIB_WEBRTC_RTC_AUDIO_FRAME_HXX
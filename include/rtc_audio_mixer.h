@@ -0,0 +1,80 @@
+#ifndef LIB_WEBRTC_RTC_AUDIO_MIXER_HXX
+#define LIB_WEBRTC_RTC_AUDIO_MIXER_HXX
+
+#include "rtc_audio_frame.h"
+#include "rtc_audio_track.h"
+#include "rtc_types.h"
+
+namespace libwebrtc {
+
+/**
+ * Mixes the audio of remote tracks for audio conferences on a server.
+ *
+ * Each Mix() call takes the latest 10 ms of every input, selects the
+ * loudest speakers and sums them. GetMix() then returns the mix a
+ * participant should hear, which leaves out its own voice (N-1). Inputs
+ * that are not selected all hear the same mix, so a round costs one mix
+ * plus one subtraction per selected speaker however many inputs there are.
+ */
+class RTCAudioMixer : public RefCountInterface {
+ public:
+  /**
+   * @brief Creates a mixer.
+   * @param sample_rate: the rate of the mixed audio, inputs are resampled.
+   * @param num_channels: the channel count of the mixed audio.
+   * @param max_speakers: how many of the loudest inputs are mixed.
+   */
+  LIB_WEBRTC_API static scoped_refptr<RTCAudioMixer> Create(
+      int sample_rate = 48000,
+      size_t num_channels = 1,
+      size_t max_speakers = 3);
+
+  /**
+   * @brief Adds the audio of |track| as the input of participant |id|.
+   * @return bool: false if |id| is already used.
+   */
+  virtual bool AddInput(int id, scoped_refptr<RTCAudioTrack> track) = 0;
+
+  /**
+   * @brief Adds an input for participant |id| that is fed with PushAudio(),
+   * for audio that does not arrive on a track.
+   * @return bool: false if |id| is already used.
+   */
+  virtual bool AddInput(int id) = 0;
+
+  /**
+   * @brief Hands the next 10 ms of input |id| to the mixer. |frame| must
+   * have the sample rate of the mixer, it is not resampled. Mono and stereo
+   * are converted to the channels of the mixer, more channels are reduced
+   * to the first two.
+   * @return bool: false for an unknown input, an input added with a track,
+   * or a frame of another rate or length.
+   */
+  virtual bool PushAudio(int id, scoped_refptr<RTCAudioFrame> frame) = 0;
+
+  virtual void RemoveInput(int id) = 0;
+
+  /**
+   * @brief Mixes the next 10 ms.
+   * @return int: the number of speakers in the mix.
+   */
+  virtual int Mix() = 0;
+
+  /**
+   * @brief Writes the last mix without the audio of participant |id| into
+   * |frame|. An unknown |id|, e.g. -1, gets the mix of all speakers.
+   */
+  virtual void GetMix(int id, scoped_refptr<RTCAudioFrame> frame) = 0;
+
+  /**
+   * @brief The ids of the speakers in the last mix, loudest first.
+   */
+  virtual vector<int> active_speakers() = 0;
+
+ protected:
+  virtual ~RTCAudioMixer() {}
+};
+
+}  // namespace libwebrtc
+
+#endif  // LIB_WEBRTC_RTC_AUDIO_MIXER_HXX
@@ -13,6 +13,28 @@ namespace libwebrtc {
  * processing and transmission mechanisms.
  */
 class RTCAudioSource : public RefCountInterface {
+ public:
+  enum SourceType {
+    // Captured by the audio device module.
+    kMicrophone,
+    // Fed by the application with OnData().
+    kCustom
+  };
+
+  virtual SourceType GetSourceType() const = 0;
+
+  /**
+   * Pushes 16 bit interleaved PCM into a kCustom source. Any amount of
+   * audio can be passed, it is cut into 10 ms chunks, resampled and sent
+   * by the tracks of this source without going through the audio device
+   * module. |sample_rate| must be a multiple of 100. Ignored by
+   * microphone sources.
+   */
+  virtual void OnData(const int16_t* audio_data,
+                      int sample_rate,
+                      size_t number_of_channels,
+                      size_t number_of_frames) = 0;
+
  protected:
   /**
    * The destructor for the RTCAudioSource class.
@@ -22,4 +44,4 @@ class RTCAudioSource : public RefCountInterface {
 
 }  // namespace libwebrtc
 
-#endif  // LIB_WEBRTC_RTC_AUDIO_TRACK_HXX
+#endif  // LIB_WEBRTC_RTC_AUDIO_SOURCE_HXX
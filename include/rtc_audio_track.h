@@ -6,6 +6,27 @@
 
 namespace libwebrtc {
 
+/**
+ * Receives the audio of an RTCAudioTrack, e.g. the decoded audio of a
+ * remote track for recording or transcription.
+ */
+class RTCAudioTrackSink {
+ public:
+  /**
+   * Called on the audio thread with 10 ms of interleaved PCM. |audio_data|
+   * points into the buffer of the audio pipeline and is only valid during
+   * the call. Must not block.
+   */
+  virtual void OnData(const void* audio_data,
+                      int bits_per_sample,
+                      int sample_rate,
+                      size_t number_of_channels,
+                      size_t number_of_frames) = 0;
+
+ protected:
+  virtual ~RTCAudioTrackSink() {}
+};
+
 /**
  * The RTCAudioTrack class represents an audio track in WebRTC.
  * Audio tracks are used to transmit audio data over a WebRTC peer connection.
@@ -17,6 +38,24 @@ class RTCAudioTrack : public RTCMediaTrack {
   // volume in [0-10]
   virtual void SetVolume(double volume) = 0;
 
+  /**
+   * Starts delivering the audio of the track to |sink|. With |sample_rate|
+   * 0 the audio is delivered at the rate it was decoded at, otherwise
+   * 16 bit audio is resampled to |sample_rate| first.
+   *
+   * The sink belongs to the track, not to this RTCAudioTrack object: it
+   * keeps receiving audio after the object returned by e.g.
+   * RTCRtpReceiver::track() is released, until RemoveSink() is called on
+   * any object of the same track. The track is kept alive until then.
+   */
+  virtual void AddSink(RTCAudioTrackSink* sink, int sample_rate = 0) = 0;
+
+  /**
+   * Stops delivering audio to |sink|. No OnData() call is running or made
+   * once this returns.
+   */
+  virtual void RemoveSink(RTCAudioTrackSink* sink) = 0;
+
  protected:
   /**
    * The destructor for the RTCAudioTrack class.
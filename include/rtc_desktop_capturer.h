@@ -13,6 +13,7 @@
 namespace libwebrtc {
 
 class DesktopCapturerObserver;
+class DesktopCursorObserver;
 
 /**
  * @brief The interface for capturing desktop media.
@@ -28,6 +29,30 @@ class RTCDesktopCapturer : public RefCountInterface {
    */
   enum CaptureState { CS_RUNNING, CS_STOPPED, CS_FAILED };
 
+  /**
+   * @brief Enumeration for how the capture region is scaled to the output
+   *        size.
+   */
+  enum ScalingPolicy {
+    // Keep the aspect ratio and fit within the output size. Never upscales.
+    SP_FIT,
+    // Keep the aspect ratio and crop the capture region to fill the output.
+    SP_FILL,
+    // Scale to the output size, whatever the aspect ratio.
+    SP_STRETCH
+  };
+
+  /**
+   * @brief Enumeration for how the mouse cursor is captured.
+   */
+  enum CursorMode {
+    // The cursor is drawn into every frame.
+    CM_COMPOSITED,
+    // Frames are captured without the cursor, its shape and position are
+    // reported to the DesktopCursorObserver instead.
+    CM_SEPARATE
+  };
+
  public:
   /**
    * @brief Registers the given observer for desktop capture events.
@@ -69,6 +94,47 @@ class RTCDesktopCapturer : public RefCountInterface {
                              uint32_t w,
                              uint32_t h) = 0;
 
+  /**
+   * @brief Sets the size of the frames produced from the capture region.
+   *
+   * The capture region is scaled while it is converted, so no frame of the
+   * full region is produced when the output is smaller. Takes effect with
+   * the next captured frame.
+   *
+   * @param width The output width, or 0 to send the capture region as is.
+   * @param height The output height, or 0 to send the capture region as is.
+   * @param policy How the capture region is fitted to the output size.
+   */
+  virtual void SetOutputSize(uint32_t width,
+                             uint32_t height,
+                             ScalingPolicy policy) = 0;
+
+  /**
+   * @brief Sets how the mouse cursor is captured. Defaults to CM_COMPOSITED.
+   *
+   * With CM_SEPARATE, cursor moves no longer change the captured frames,
+   * so static content stays static for the encoder. The cursor can then be
+   * sent to the remote side on a data channel and drawn over the video.
+   *
+   * @param mode The cursor mode.
+   *
+   * @return False if capture is running, the mode is not changed then.
+   */
+  virtual bool SetCursorMode(CursorMode mode) = 0;
+
+  /**
+   * @brief Registers the observer of the cursor in CM_SEPARATE mode.
+   *
+   * @param observer Pointer to the observer to be registered.
+   */
+  virtual void RegisterDesktopCursorObserver(
+      DesktopCursorObserver* observer) = 0;
+
+  /**
+   * @brief Deregisters the currently registered cursor observer.
+   */
+  virtual void DeRegisterDesktopCursorObserver() = 0;
+
   /**
    * @brief Stops desktop capture.
    */
@@ -89,6 +155,25 @@ class RTCDesktopCapturer : public RefCountInterface {
    */
   virtual scoped_refptr<MediaSource> source() = 0;
 
+  /**
+   * @brief Retrieves how often captured frames reused a pooled buffer.
+   *
+   * @return The hits and misses of the capturer's frame buffer pool.
+   */
+  virtual RTCFrameBufferPoolStats buffer_pool_stats() = 0;
+
+  /**
+   * @brief Sets the range the capture frame rate adapts within.
+   *
+   * The capturer runs at the rate passed to Start(), or lower when the
+   * encoder asks for fewer frames, and backs off towards |min_fps| while
+   * the captured content does not change. Defaults to 1 to 60 fps.
+   *
+   * @param min_fps The rate used for static content.
+   * @param max_fps The highest rate, whatever Start() asked for.
+   */
+  virtual void SetFramerateRange(uint32_t min_fps, uint32_t max_fps) = 0;
+
   /**
    * @brief Destroys the RTCDesktopCapturer object.
    */
@@ -136,6 +221,48 @@ class DesktopCapturerObserver {
   ~DesktopCapturerObserver() {}
 };
 
+/**
+ * @brief The shape of the mouse cursor.
+ */
+struct RTCDesktopCursorShape {
+  int width = 0;
+  int height = 0;
+  // The point of the image that is at the cursor position.
+  int hotspot_x = 0;
+  int hotspot_y = 0;
+  // BGRA pixels, |width| * 4 bytes per row.
+  vector<uint8_t> data;
+};
+
+/**
+ * @brief Observer interface for the mouse cursor of a desktop capturer in
+ *        CM_SEPARATE mode.
+ *
+ * Called on the capture thread, at most once per cursor poll and only for
+ * changes.
+ */
+class DesktopCursorObserver {
+ public:
+  /**
+   * @brief Called when the cursor image changes.
+   *
+   * @param shape The new cursor image, at the scale of the captured source.
+   */
+  virtual void OnCursorShapeChanged(const RTCDesktopCursorShape& shape) = 0;
+
+  /**
+   * @brief Called when the cursor moves.
+   *
+   * @param x The horizontal cursor position in the sent frames.
+   * @param y The vertical cursor position in the sent frames.
+   * @param visible False when the cursor is outside the capture region.
+   */
+  virtual void OnCursorPositionChanged(int x, int y, bool visible) = 0;
+
+ protected:
+  ~DesktopCursorObserver() {}
+};
+
 }  // namespace libwebrtc
 
 #endif  // LIB_WEBRTC_RTC_DESKTOP_CAPTURER_HXX
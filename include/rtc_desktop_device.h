@@ -8,6 +8,7 @@ namespace libwebrtc {
 class MediaSource;
 class RTCDesktopCapturer;
 class RTCDesktopMediaList;
+class RTCVirtualDesktop;
 
 class RTCDesktopDevice : public RefCountInterface {
  public:
@@ -16,6 +17,25 @@ class RTCDesktopDevice : public RefCountInterface {
   virtual scoped_refptr<RTCDesktopMediaList> GetDesktopMediaList(
       DesktopType type) = 0;
 
+  // Creates a virtual desktop of |width| x |height| BGRA pixels, with
+  // |stride| bytes per row, from the shared memory or memfd |fd| at
+  // |offset|. The memory is mapped read only and |fd| may be closed
+  // afterwards. Returns null if it cannot be mapped.
+  virtual scoped_refptr<RTCVirtualDesktop> CreateVirtualDesktop(
+      int fd,
+      uint64_t offset,
+      int width,
+      int height,
+      int stride) = 0;
+
+  // Creates a virtual desktop that reads the framebuffer at |data|, which
+  // must outlive the desktop and its capturers.
+  virtual scoped_refptr<RTCVirtualDesktop> CreateVirtualDesktop(
+      const uint8_t* data,
+      int width,
+      int height,
+      int stride) = 0;
+
  protected:
   virtual ~RTCDesktopDevice() {}
 };
@@ -18,6 +18,7 @@ class MediaSource : public RefCountInterface {
 
   virtual DesktopType type() const = 0;
 
+  // Captures a new thumbnail, at the size last passed to UpdateSourceList().
   virtual bool UpdateThumbnail() = 0;
 
  protected:
@@ -47,15 +48,24 @@ class RTCDesktopMediaList : public RefCountInterface {
 
   virtual DesktopType type() const = 0;
 
+  // Thumbnails are scaled down to fit |thumbnail_width| x |thumbnail_height|,
+  // keeping the aspect ratio of the source. 0 keeps the source size.
   virtual int32_t UpdateSourceList(bool force_reload = false,
-                                   bool get_thumbnail = true) = 0;
+                                   bool get_thumbnail = true,
+                                   uint32_t thumbnail_width = 320,
+                                   uint32_t thumbnail_height = 180) = 0;
 
   virtual int GetSourceCount() const = 0;
 
   virtual scoped_refptr<MediaSource> GetSource(int index) = 0;
 
   virtual bool GetThumbnail(scoped_refptr<MediaSource> source,
-                            bool notify = false) = 0;
+                            bool notify = false,
+                            uint32_t thumbnail_width = 320,
+                            uint32_t thumbnail_height = 180) = 0;
+
+  // Hits and misses of the frame buffer pools used for thumbnails.
+  virtual RTCFrameBufferPoolStats buffer_pool_stats() = 0;
 
  protected:
   ~RTCDesktopMediaList() {}
@@ -2,6 +2,7 @@
 #define LIB_RTC_FRAME_CYRPTOR_H_
 
 #include "base/refcount.h"
+#include "rtc_data_channel.h"
 #include "rtc_rtp_receiver.h"
 #include "rtc_rtp_sender.h"
 #include "rtc_types.h"
@@ -28,6 +29,13 @@ struct KeyProviderOptions {
         ratchet_window_size(copy.ratchet_window_size) {}
 };
 
+/// A key for one participant, for KeyProvider::SetKeys.
+struct ParticipantKey {
+  string participant_id;
+  int index = 0;
+  vector<uint8_t> key;
+};
+
 /// Shared secret key for frame encryption.
 class KeyProvider : public RefCountInterface {
  public:
@@ -38,6 +46,10 @@ class KeyProvider : public RefCountInterface {
                       int index,
                       vector<uint8_t> key) = 0;
 
+  /// Set the keys of many participants at once, e.g. when a room rotates
+  /// its keys. Returns the number of keys set.
+  virtual int SetKeys(const vector<ParticipantKey> keys) = 0;
+
   virtual vector<uint8_t> RatchetKey(const string participant_id,
                                      int key_index) = 0;
 
@@ -67,6 +79,15 @@ class RTCFrameCryptorObserver {
   virtual ~RTCFrameCryptorObserver() {}
 };
 
+/// Options of a frame cryptor for [RTCDataChannel].
+struct RTCDataChannelCryptorOptions {
+  /// Messages smaller than this are batched, and a batch is encrypted and
+  /// sent as one message once it reaches this size. 0 disables batching.
+  uint32_t batch_max_bytes = 0;
+  /// How long a batch waits for more messages before it is sent.
+  uint32_t batch_max_delay_ms = 5;
+};
+
 /// Frame encryption/decryption.
 ///
 class RTCFrameCryptor : public RefCountInterface {
@@ -110,6 +131,17 @@ class FrameCryptorFactory {
                               scoped_refptr<RTCRtpReceiver> receiver,
                               Algorithm algorithm,
                               scoped_refptr<KeyProvider> key_provider);
+
+  /// Create a frame cyrptor for [RTCDataChannel]. Messages in both
+  /// directions use the keys of |participant_id|. Only AES-GCM is supported,
+  /// null is returned for any other |algorithm|.
+  LIB_WEBRTC_API static scoped_refptr<RTCFrameCryptor>
+  frameCryptorFromDataChannel(const string participant_id,
+                              scoped_refptr<RTCDataChannel> data_channel,
+                              Algorithm algorithm,
+                              scoped_refptr<KeyProvider> key_provider,
+                              const RTCDataChannelCryptorOptions& options =
+                                  RTCDataChannelCryptorOptions());
 };
 
 }  // namespace libwebrtc
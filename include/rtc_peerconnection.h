@@ -138,6 +138,21 @@ typedef fixed_size_function<void(const char* sdp, const char* type)>
 
 typedef fixed_size_function<void(const char* error)> OnGetSdpFailure;
 
+// The audio level of one sender or receiver of a peer connection.
+struct RTCAudioLevel {
+  // RTCRtpSender::id() or RTCRtpReceiver::id().
+  string id;
+  // True for a receiver.
+  bool remote = false;
+  // Linear level in [0, 1], as audioLevel in the stats.
+  double level = 0;
+  // Above the speech threshold, held a short while over pauses.
+  bool voice_activity = false;
+};
+
+typedef fixed_size_function<void(const vector<RTCAudioLevel> levels)>
+    OnAudioLevels;
+
 class RTCPeerConnectionObserver {
  public:
   virtual void OnSignalingState(RTCSignalingState state) = 0;
@@ -234,6 +249,13 @@ class RTCPeerConnection : public RefCountInterface {
   virtual void GetStats(OnStatsCollectorSuccess success,
                         OnStatsCollectorFailure failure) = 0;
 
+  // Reports the levels of all audio senders and receivers every
+  // |interval_ms| on the signaling thread, without building a stats
+  // report. Receivers use the ssrc-audio-level header extension when it is
+  // negotiated. An empty callback stops the reports.
+  virtual void SetAudioLevelCallback(OnAudioLevels callback,
+                                     int interval_ms = 50) = 0;
+
   virtual scoped_refptr<RTCRtpTransceiver> AddTransceiver(
       scoped_refptr<RTCMediaTrack> track,
       scoped_refptr<RTCRtpTransceiverInit> init) = 0;
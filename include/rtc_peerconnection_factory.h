@@ -10,6 +10,7 @@
 #endif
 #include "rtc_media_stream.h"
 #include "rtc_mediaconstraints.h"
+#include "rtc_peerconnection_pool.h"
 #include "rtc_video_device.h"
 #include "rtc_video_source.h"
 
@@ -39,7 +40,9 @@ class RTCPeerConnectionFactory : public RefCountInterface {
   virtual scoped_refptr<RTCDesktopDevice> GetDesktopDevice() = 0;
 #endif
   virtual scoped_refptr<RTCAudioSource> CreateAudioSource(
-      const string audio_source_label) = 0;
+      const string audio_source_label,
+      RTCAudioSource::SourceType source_type =
+          RTCAudioSource::SourceType::kMicrophone) = 0;
 
   virtual scoped_refptr<RTCVideoSource> CreateVideoSource(
       scoped_refptr<RTCVideoCapturer> capturer,
@@ -67,6 +70,20 @@ class RTCPeerConnectionFactory : public RefCountInterface {
 
   virtual scoped_refptr<RTCRtpCapabilities> GetRtpReceiverCapabilities(
       RTCMediaType media_type) = 0;
+
+  virtual scoped_refptr<RTCPeerConnectionPool> CreatePeerConnectionPool(
+      const RTCConfiguration& configuration,
+      scoped_refptr<RTCMediaConstraints> constraints,
+      const RTCPeerConnectionPoolOptions& options) = 0;
+
+  // Generates DTLS certificates on a background thread and hands them to
+  // every peer connection created afterwards, instead of generating a new
+  // one per connection.
+  virtual void EnableCertificateCache(
+      const RTCCertificateCacheOptions& options) = 0;
+
+  // Starts generating the certificate pinned to |tenant| ahead of time.
+  virtual void PreGenerateCertificate(const string tenant) = 0;
 };
 
 }  // namespace libwebrtc
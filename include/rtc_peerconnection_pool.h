@@ -0,0 +1,56 @@
+#ifndef LIB_WEBRTC_RTC_PEERCONNECTION_POOL_HXX
+#define LIB_WEBRTC_RTC_PEERCONNECTION_POOL_HXX
+
+#include "rtc_peerconnection.h"
+#include "rtc_types.h"
+
+namespace libwebrtc {
+
+/**
+ * Options for a pool of pre-created peer connections.
+ */
+struct RTCPeerConnectionPoolOptions {
+  // Number of idle peer connections kept ready.
+  uint32_t size = 4;
+  // Idle connections older than this are closed and replaced, so that their
+  // pre-gathered candidates do not go stale. 0 disables expiry.
+  uint32_t idle_ttl_ms = 60000;
+  // Transceivers added to every pooled connection before it is handed out.
+  // Only useful for the offering side, an answer does not reuse them.
+  uint32_t audio_transceivers = 0;
+  uint32_t video_transceivers = 0;
+};
+
+/**
+ * A pool of peer connections created ahead of time with the same
+ * configuration. Set RTCConfiguration::ice_candidate_pool_size to have the
+ * pooled connections gather candidates while they wait.
+ */
+class RTCPeerConnectionPool : public RefCountInterface {
+ public:
+  /**
+   * Hands out an idle peer connection, or creates one synchronously if the
+   * pool is empty. The pool is refilled in the background on the signaling
+   * thread. Returns null once the pool is drained, or the factory that
+   * created it is terminated.
+   */
+  virtual scoped_refptr<RTCPeerConnection> Acquire() = 0;
+
+  /**
+   * Returns the number of idle peer connections currently in the pool.
+   */
+  virtual uint32_t ready_count() = 0;
+
+  /**
+   * Closes all idle peer connections and stops refilling the pool. No
+   * connections are handed out afterwards.
+   */
+  virtual void Drain() = 0;
+
+ protected:
+  virtual ~RTCPeerConnectionPool() {}
+};
+
+}  // namespace libwebrtc
+
+#endif  // LIB_WEBRTC_RTC_PEERCONNECTION_POOL_HXX
@@ -92,12 +92,52 @@ struct RTCConfiguration {
   bool disable_link_local_networks = false;
   int screencast_min_bitrate = -1;
 
+  // Selects the certificate pinned to this tenant when the factory
+  // certificate cache is enabled. Empty uses the factory-wide certificate.
+  string certificate_tenant;
+
   // private
   bool use_rtp_mux = true;
   uint32_t local_audio_bandwidth = 128;
   uint32_t local_video_bandwidth = 512;
 };
 
+struct RTCCertificateCacheOptions {
+  // Cached certificates older than this are regenerated in the background.
+  // 0 keeps them for the lifetime of the factory.
+  uint32_t rotation_period_ms = 24 * 60 * 60 * 1000;
+  // Generate RSA-2048 certificates instead of ECDSA P-256.
+  bool use_rsa = false;
+};
+
+// The audio device module of a factory, see RTCAudioDeviceOptions.
+enum class RTCAudioDeviceModuleType {
+  // The sound card, through the platform audio layer.
+  kPlatformDefault,
+  // No hardware: records silence and discards the playout, in real time.
+  kDummy,
+  // Records from and plays out to WAV files, in real time.
+  kFile,
+  // Paced by the application with RTCAudioDevice::PullAudio().
+  kPull
+};
+
+struct RTCAudioDeviceOptions {
+  RTCAudioDeviceModuleType type = RTCAudioDeviceModuleType::kPlatformDefault;
+  // kFile: the WAV file recorded audio is read from, silence if empty.
+  string input_file;
+  // kFile: the WAV file the playout is written to, discarded if empty.
+  string output_file;
+  // kFile: starts |input_file| over when it ends.
+  bool loop_input = true;
+  // The format of the audio of the kDummy, kFile and kPull modules. The
+  // format of |input_file| is read from its header.
+  int sample_rate = 48000;
+  int channels = 1;
+  // kPull: the audio one PullAudio() call covers, a multiple of 10 ms.
+  int tick_ms = 10;
+};
+
 struct SdpParseError {
  public:
   // The sdp line that causes the error.
@@ -106,7 +146,16 @@ struct SdpParseError {
   string description;
 };
 
-enum DesktopType { kScreen, kWindow };
+// kVirtual is a framebuffer rendered by the application, see
+// RTCDesktopDevice::CreateVirtualDesktop().
+enum DesktopType { kScreen, kWindow, kVirtual };
+
+struct RTCFrameBufferPoolStats {
+  // Frames written into a buffer reused from the pool.
+  uint64_t hits = 0;
+  // Frames that needed a newly allocated buffer.
+  uint64_t misses = 0;
+};
 
 }  // namespace libwebrtc
 
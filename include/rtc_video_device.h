@@ -16,8 +16,27 @@ class RTCVideoCapturer : public RefCountInterface {
   virtual void StopCapture() = 0;
 };
 
+// A capture mode reported by a camera.
+struct RTCVideoCapability {
+  int32_t width = 0;
+  int32_t height = 0;
+  int32_t max_fps = 0;
+  // The pixel format the camera delivers, e.g. "MJPEG", "NV12" or "YUY2".
+  string format;
+};
+
+// Layout of a file replayed with RTCVideoDevice::CreateFileCapturer().
+enum class RTCVideoFileFormat { kY4M, kI420, kNV12 };
+
 class RTCVideoDevice : public RefCountInterface {
  public:
+  typedef fixed_size_function<void()> OnDeviceChangeCallback;
+  typedef fixed_size_function<void(scoped_refptr<RTCVideoCapturer> capturer)>
+      OnCapturerCreated;
+
+ public:
+  // The device list is cached, and refreshed when a camera is plugged in
+  // or removed.
   virtual uint32_t NumberOfDevices() = 0;
 
   virtual int32_t GetDeviceName(uint32_t deviceNumber,
@@ -34,6 +53,34 @@ class RTCVideoDevice : public RefCountInterface {
                                                  size_t height,
                                                  size_t target_fps) = 0;
 
+  // Like Create(), but opens the device off the calling thread. |callback|
+  // runs on the signaling thread, with null if the device cannot be opened.
+  virtual void CreateAsync(const char* name,
+                           uint32_t index,
+                           size_t width,
+                           size_t height,
+                           size_t target_fps,
+                           OnCapturerCreated callback) = 0;
+
+  // Creates a capturer that replays the Y4M or raw YUV file |path| as a
+  // camera, for load tests. |width| and |height| are only needed for raw
+  // files. |target_fps| 0 uses the rate of a Y4M file, or 30. Capturers of
+  // the same file share one read only mapping of it.
+  virtual scoped_refptr<RTCVideoCapturer> CreateFileCapturer(
+      const char* path,
+      RTCVideoFileFormat format,
+      size_t width,
+      size_t height,
+      size_t target_fps,
+      bool loop = true) = 0;
+
+  // The capture modes of device |index|, empty if there is no such device.
+  virtual vector<RTCVideoCapability> GetCapabilities(uint32_t index) = 0;
+
+  // |listener| is called on the signaling thread when the device list
+  // changes.
+  virtual int32_t OnDeviceChange(OnDeviceChangeCallback listener) = 0;
+
  protected:
   virtual ~RTCVideoDevice() {}
 };
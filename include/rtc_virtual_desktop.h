@@ -0,0 +1,42 @@
+#ifndef LIB_WEBRTC_RTC_VIRTUAL_DESKTOP_HXX
+#define LIB_WEBRTC_RTC_VIRTUAL_DESKTOP_HXX
+
+#include "rtc_desktop_media_list.h"
+#include "rtc_types.h"
+
+namespace libwebrtc {
+
+/**
+ * @brief A desktop that the application renders into a framebuffer, for
+ *        hosts without a display server.
+ *
+ * The framebuffer holds BGRA pixels, like the frames of the other desktop
+ * capturers. It is read in place by the capturer created from this source
+ * with RTCDesktopDevice::CreateDesktopCapturer(), so only the rects marked
+ * dirty are converted and encoded again. Pixels written while a capture
+ * reads them may show up torn in that frame.
+ */
+class RTCVirtualDesktop : public MediaSource {
+ public:
+  /**
+   * @brief Marks a rect of the framebuffer as changed since the last
+   *        capture. Can be called from any thread.
+   */
+  virtual void AddDirtyRect(int x, int y, int width, int height) = 0;
+
+  /**
+   * @brief Marks the whole framebuffer as changed.
+   */
+  virtual void SetDirty() = 0;
+
+  virtual int width() const = 0;
+
+  virtual int height() const = 0;
+
+ protected:
+  virtual ~RTCVirtualDesktop() {}
+};
+
+}  // namespace libwebrtc
+
+#endif  // LIB_WEBRTC_RTC_VIRTUAL_DESKTOP_HXX
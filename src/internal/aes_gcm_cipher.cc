@@ -0,0 +1,155 @@
+#include "src/internal/aes_gcm_cipher.h"
+
+#include <string.h>
+
+#include "rtc_base/logging.h"
+
+namespace libwebrtc {
+
+AesGcmCipher::AesGcmCipher(const std::string participant_id,
+                           rtc::scoped_refptr<webrtc::KeyProvider> key_provider,
+                           std::shared_ptr<KeyRatchetCache> ratchet_cache)
+    : participant_id_(participant_id),
+      key_provider_(key_provider),
+      ratchet_cache_(std::move(ratchet_cache)) {}
+
+AesGcmCipher::~AesGcmCipher() {}
+
+AesGcmCipher::Result AesGcmCipher::Seal(int key_index,
+                                        rtc::ArrayView<const uint8_t> header,
+                                        rtc::ArrayView<const uint8_t> payload,
+                                        const uint8_t* iv,
+                                        rtc::Buffer* out) {
+  std::shared_ptr<webrtc::ParticipantKeyHandler> key_handler;
+  std::shared_ptr<const CachedContext> context =
+      Context(key_index, &key_handler);
+  if (!context) {
+    return Result::kMissingKey;
+  }
+  const EVP_AEAD_CTX* ctx = context->ctx.get();
+
+  const size_t max_overhead = EVP_AEAD_max_overhead(EVP_AEAD_CTX_aead(ctx));
+  out->SetSize(header.size() + payload.size() + max_overhead + kIvSize +
+               kTrailerSize);
+  uint8_t* data = out->data();
+  memcpy(data, header.data(), header.size());
+
+  size_t sealed_size = 0;
+  if (!EVP_AEAD_CTX_seal(ctx, data + header.size(), &sealed_size,
+                         payload.size() + max_overhead, iv, kIvSize,
+                         payload.data(), payload.size(), header.data(),
+                         header.size())) {
+    RTC_LOG(LS_WARNING) << __FUNCTION__ << ": seal failed for "
+                        << participant_id_;
+    return Result::kFailed;
+  }
+
+  size_t offset = header.size() + sealed_size;
+  memcpy(data + offset, iv, kIvSize);
+  offset += kIvSize;
+  data[offset++] = static_cast<uint8_t>(kIvSize);
+  data[offset++] = static_cast<uint8_t>(key_index);
+  out->SetSize(offset);
+  return Result::kOk;
+}
+
+AesGcmCipher::Result AesGcmCipher::Open(rtc::ArrayView<const uint8_t> data,
+                                        size_t header_size,
+                                        rtc::Buffer* out) {
+  if (data.size() < header_size + kIvSize + kTrailerSize ||
+      data[data.size() - 2] != kIvSize) {
+    return Result::kInvalid;
+  }
+
+  const int key_index = data[data.size() - 1];
+  std::shared_ptr<webrtc::ParticipantKeyHandler> key_handler;
+  std::shared_ptr<const CachedContext> context =
+      Context(key_index, &key_handler);
+  if (!context) {
+    return Result::kMissingKey;
+  }
+  const EVP_AEAD_CTX* ctx = context->ctx.get();
+  const size_t max_overhead = EVP_AEAD_max_overhead(EVP_AEAD_CTX_aead(ctx));
+  if (data.size() < header_size + max_overhead + kIvSize + kTrailerSize) {
+    return Result::kInvalid;
+  }
+
+  if (OpenWith(ctx, data, header_size, out)) {
+    return Result::kOk;
+  }
+  if (ratchet_cache_ &&
+      ratchet_cache_->Ratchet(participant_id_, key_index, key_handler.get(),
+                              [&](const EVP_AEAD_CTX* ratcheted) {
+                                return OpenWith(ratcheted, data, header_size,
+                                                out);
+                              }) > 0) {
+    return Result::kKeyRatcheted;
+  }
+  return Result::kFailed;
+}
+
+std::shared_ptr<const AesGcmCipher::CachedContext> AesGcmCipher::Context(
+    int key_index,
+    std::shared_ptr<webrtc::ParticipantKeyHandler>* key_handler) {
+  *key_handler = key_provider_->GetKey(participant_id_);
+  if (!*key_handler) {
+    return nullptr;
+  }
+
+  std::shared_ptr<webrtc::ParticipantKeyHandler::KeySet> key_set =
+      (*key_handler)->GetKeySet(key_index);
+  if (!key_set) {
+    return nullptr;
+  }
+
+  webrtc::MutexLock lock(&mutex_);
+  std::shared_ptr<const CachedContext>& cached = contexts_[key_index];
+  if (cached && cached->key_set == key_set) {
+    return cached;
+  }
+
+  // The key was set or ratcheted since the last use, rebuild the context.
+  // A frame still sealing with the old one keeps it alive.
+  cached.reset();
+  const std::vector<uint8_t>& key = key_set->encryption_key;
+  const EVP_AEAD* aead = nullptr;
+  if (key.size() == 16) {
+    aead = EVP_aead_aes_128_gcm();
+  } else if (key.size() == 32) {
+    aead = EVP_aead_aes_256_gcm();
+  } else {
+    return nullptr;
+  }
+
+  std::shared_ptr<CachedContext> context = std::make_shared<CachedContext>();
+  if (!EVP_AEAD_CTX_init(context->ctx.get(), aead, key.data(), key.size(),
+                         EVP_AEAD_DEFAULT_TAG_LENGTH, nullptr)) {
+    RTC_LOG(LS_WARNING) << __FUNCTION__ << ": EVP_AEAD_CTX_init failed";
+    return nullptr;
+  }
+  context->key_set = key_set;
+  cached = std::move(context);
+  return cached;
+}
+
+bool AesGcmCipher::OpenWith(const EVP_AEAD_CTX* ctx,
+                            rtc::ArrayView<const uint8_t> data,
+                            size_t header_size,
+                            rtc::Buffer* out) const {
+  const size_t sealed_size = data.size() - header_size - kIvSize - kTrailerSize;
+  const uint8_t* iv = data.data() + header_size + sealed_size;
+  out->SetSize(header_size + sealed_size);
+
+  uint8_t* opened = out->data();
+  memcpy(opened, data.data(), header_size);
+  size_t opened_size = 0;
+  if (!EVP_AEAD_CTX_open(ctx, opened + header_size, &opened_size, sealed_size,
+                         iv, kIvSize, data.data() + header_size, sealed_size,
+                         data.data(), header_size)) {
+    return false;
+  }
+  out->SetSize(header_size + opened_size);
+  return true;
+}
+
+}  // namespace libwebrtc
@@ -0,0 +1,88 @@
+#ifndef INTERNAL_AES_GCM_CIPHER_HXX
+#define INTERNAL_AES_GCM_CIPHER_HXX
+
+#include <openssl/aead.h>
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "api/array_view.h"
+#include "api/crypto/frame_crypto_transformer.h"
+#include "api/scoped_refptr.h"
+#include "rtc_base/buffer.h"
+#include "rtc_base/synchronization/mutex.h"
+#include "src/internal/key_ratchet_cache.h"
+
+namespace libwebrtc {
+
+// AES-GCM with the keys of one participant, in the frame cryptor layout:
+//
+//   [header][ciphertext + tag][iv][iv length][key index]
+//
+// where the header is sent in the clear and authenticated. The key handler
+// is looked up on every call, so a handler replaced by the key provider is
+// picked up. The AEAD context of a key set is built once and kept until
+// that key set is replaced. Thread safe: only the context lookup is locked,
+// sealing and opening run concurrently.
+class AesGcmCipher {
+ public:
+  static constexpr size_t kIvSize = 12;
+  static constexpr size_t kTrailerSize = 2;
+
+  enum class Result {
+    kOk,
+    kKeyRatcheted,
+    kMissingKey,
+    kInvalid,
+    kFailed,
+  };
+
+  AesGcmCipher(const std::string participant_id,
+               rtc::scoped_refptr<webrtc::KeyProvider> key_provider,
+               std::shared_ptr<KeyRatchetCache> ratchet_cache);
+  ~AesGcmCipher();
+
+  // Seals |payload| with the key at |key_index| into |out|, which is resized
+  // to the sealed size. |iv| is kIvSize bytes.
+  Result Seal(int key_index,
+              rtc::ArrayView<const uint8_t> header,
+              rtc::ArrayView<const uint8_t> payload,
+              const uint8_t* iv,
+              rtc::Buffer* out);
+
+  // Opens |data| with a header of |header_size| bytes into |out| as
+  // [header][payload]. If the key of the sealed key index does not match,
+  // the keys ratcheted from it are tried. |data| is left untouched.
+  Result Open(rtc::ArrayView<const uint8_t> data,
+              size_t header_size,
+              rtc::Buffer* out);
+
+ private:
+  struct CachedContext {
+    std::shared_ptr<webrtc::ParticipantKeyHandler::KeySet> key_set;
+    bssl::ScopedEVP_AEAD_CTX ctx;
+  };
+
+  // The context of the current key set of |key_index|, null if there is no
+  // key. |key_handler| is set to the handler it came from.
+  std::shared_ptr<const CachedContext> Context(
+      int key_index,
+      std::shared_ptr<webrtc::ParticipantKeyHandler>* key_handler);
+
+  bool OpenWith(const EVP_AEAD_CTX* ctx,
+                rtc::ArrayView<const uint8_t> data,
+                size_t header_size,
+                rtc::Buffer* out) const;
+
+  const std::string participant_id_;
+  const rtc::scoped_refptr<webrtc::KeyProvider> key_provider_;
+  const std::shared_ptr<KeyRatchetCache> ratchet_cache_;
+  webrtc::Mutex mutex_;
+  std::map<int, std::shared_ptr<const CachedContext>> contexts_
+      RTC_GUARDED_BY(mutex_);
+};
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_AES_GCM_CIPHER_HXX
@@ -0,0 +1,74 @@
+#include "src/internal/audio_level_meter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "modules/audio_processing/audio_buffer.h"
+#include "src/internal/audio_mix_util.h"
+
+namespace libwebrtc {
+
+namespace {
+
+const double kFullScale = 32768.0;
+
+}  // namespace
+
+void AudioLevelMeter::Update(const int16_t* samples, size_t length) {
+  const double energy =
+      static_cast<double>(Energy(samples, length)) / (kFullScale * kFullScale);
+  webrtc::MutexLock lock(&mutex_);
+  total_.energy += energy;
+  total_.samples += length;
+}
+
+void AudioLevelMeter::Update(const float* const* channels,
+                             size_t num_channels,
+                             size_t num_frames) {
+  double sum = 0;
+  for (size_t ch = 0; ch < num_channels; ++ch) {
+    const float* samples = channels[ch];
+    for (size_t i = 0; i < num_frames; ++i) {
+      sum += static_cast<double>(samples[i]) * samples[i];
+    }
+  }
+  webrtc::MutexLock lock(&mutex_);
+  total_.energy += sum / (kFullScale * kFullScale);
+  total_.samples += num_channels * num_frames;
+}
+
+AudioLevelMeter::Reading AudioLevelMeter::Read() const {
+  webrtc::MutexLock lock(&mutex_);
+  return total_;
+}
+
+double AudioLevelMeter::Level(const Reading& from, const Reading& to) {
+  if (to.samples <= from.samples) {
+    return -1;
+  }
+  const double mean = (to.energy - from.energy) / (to.samples - from.samples);
+  return std::min(1.0, std::sqrt(std::max(0.0, mean)));
+}
+
+void TrackLevelSink::OnData(const void* audio_data,
+                            int bits_per_sample,
+                            int sample_rate,
+                            size_t number_of_channels,
+                            size_t number_of_frames) {
+  if (bits_per_sample != 16) {
+    return;
+  }
+  meter_.Update(static_cast<const int16_t*>(audio_data),
+                number_of_channels * number_of_frames);
+}
+
+CaptureLevelProcessor::CaptureLevelProcessor(
+    std::shared_ptr<AudioLevelMeter> meter)
+    : meter_(meter) {}
+
+void CaptureLevelProcessor::Process(webrtc::AudioBuffer* audio) {
+  meter_->Update(audio->channels_const(), audio->num_channels(),
+                 audio->num_frames());
+}
+
+}  // namespace libwebrtc
@@ -0,0 +1,76 @@
+#ifndef INTERNAL_AUDIO_LEVEL_METER_HXX
+#define INTERNAL_AUDIO_LEVEL_METER_HXX
+
+#include <memory>
+#include <string>
+
+#include "api/media_stream_interface.h"
+#include "modules/audio_processing/include/audio_processing.h"
+#include "rtc_base/synchronization/mutex.h"
+
+namespace libwebrtc {
+
+// Running energy of an audio stream, as totalAudioEnergy in the stats.
+// Readers keep their previous reading, so any number of them can sample
+// the meter at their own interval.
+class AudioLevelMeter {
+ public:
+  struct Reading {
+    // Sum of the squares of the samples, normalized to [-1, 1].
+    double energy = 0;
+    uint64_t samples = 0;
+  };
+
+  void Update(const int16_t* samples, size_t length);
+
+  // Samples in the int16 range, as the audio processing module keeps them.
+  void Update(const float* const* channels,
+              size_t num_channels,
+              size_t num_frames);
+
+  Reading Read() const;
+
+  // RMS level in [0, 1] between two readings, -1 if no audio came in.
+  static double Level(const Reading& from, const Reading& to);
+
+ private:
+  mutable webrtc::Mutex mutex_;
+  Reading total_ RTC_GUARDED_BY(mutex_);
+};
+
+// Meters what a track hands to its sinks: decoded audio for a remote
+// track, the pushed audio for a custom source. Microphone tracks deliver
+// nothing, their audio goes from the device straight to the send streams.
+class TrackLevelSink : public webrtc::AudioTrackSinkInterface {
+ public:
+  void OnData(const void* audio_data,
+              int bits_per_sample,
+              int sample_rate,
+              size_t number_of_channels,
+              size_t number_of_frames) override;
+
+  AudioLevelMeter* meter() { return &meter_; }
+
+ private:
+  AudioLevelMeter meter_;
+};
+
+// Meters the microphone after echo cancellation and gain control, which
+// is the audio the senders of microphone tracks send.
+class CaptureLevelProcessor : public webrtc::CustomProcessing {
+ public:
+  explicit CaptureLevelProcessor(std::shared_ptr<AudioLevelMeter> meter);
+
+  void Initialize(int sample_rate_hz, int num_channels) override {}
+  void Process(webrtc::AudioBuffer* audio) override;
+  std::string ToString() const override { return "CaptureLevelProcessor"; }
+  void SetRuntimeSetting(
+      webrtc::AudioProcessing::RuntimeSetting setting) override {}
+
+ private:
+  std::shared_ptr<AudioLevelMeter> meter_;
+};
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_AUDIO_LEVEL_METER_HXX
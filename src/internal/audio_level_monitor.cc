@@ -0,0 +1,230 @@
+#include "src/internal/audio_level_monitor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "api/sequence_checker.h"
+#include "api/units/time_delta.h"
+#include "rtc_base/time_utils.h"
+#include "src/internal/push_audio_source.h"
+
+namespace libwebrtc {
+
+namespace {
+
+const int kMinIntervalMs = 10;
+
+// -40 dBov, above the noise floor of a processed microphone.
+const double kVoiceLevel = 0.01;
+
+// Keeps a speaker active over the gaps between words.
+const int64_t kVoiceHangoverMs = 300;
+
+// An RTP level older than this is from a stream that stopped.
+const int64_t kRtpLevelTimeoutMs = 1000;
+
+rtc::scoped_refptr<webrtc::AudioTrackInterface> AudioTrack(
+    rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> track) {
+  if (!track || track->kind() != webrtc::MediaStreamTrackInterface::kAudioKind) {
+    return nullptr;
+  }
+  return rtc::scoped_refptr<webrtc::AudioTrackInterface>(
+      static_cast<webrtc::AudioTrackInterface*>(track.get()));
+}
+
+}  // namespace
+
+AudioLevelMonitor::AudioLevelMonitor(
+    rtc::Thread* signaling_thread,
+    rtc::scoped_refptr<webrtc::PeerConnectionInterface> pc,
+    std::shared_ptr<AudioLevelMeter> capture_meter,
+    OnAudioLevels callback,
+    int interval_ms)
+    : signaling_thread_(signaling_thread),
+      pc_(pc),
+      capture_meter_(capture_meter),
+      callback_(std::move(callback)),
+      interval_ms_(std::max(interval_ms, kMinIntervalMs)) {
+  signaling_thread_->BlockingCall([this] {
+    // The safety flag is bound to the thread that creates it.
+    safety_flag_ = webrtc::PendingTaskSafetyFlag::Create();
+    if (capture_meter_) {
+      capture_last_ = capture_meter_->Read();
+    }
+    signaling_thread_->PostDelayedHighPrecisionTask(
+        webrtc::SafeTask(safety_flag_, [this] { Tick(); }),
+        webrtc::TimeDelta::Millis(interval_ms_));
+  });
+}
+
+AudioLevelMonitor::~AudioLevelMonitor() {
+  Stop();
+}
+
+void AudioLevelMonitor::Stop() {
+  signaling_thread_->BlockingCall([this] {
+    if (stopped_) {
+      return;
+    }
+    stopped_ = true;
+    safety_flag_->SetNotAlive();
+    for (auto& it : senders_) {
+      DetachSink(&it.second);
+    }
+    for (auto& it : receivers_) {
+      DetachSink(&it.second);
+    }
+    // Tick() is done with the peer connection once the callback runs, so
+    // it is released here even when stopped from the callback.
+    pc_ = nullptr;
+  });
+}
+
+void AudioLevelMonitor::Tick() {
+  RTC_DCHECK_RUN_ON(signaling_thread_);
+  const int64_t now_ms = rtc::TimeMillis();
+  std::vector<RTCAudioLevel> levels;
+
+  // One microphone feeds every sender of a microphone track. Those tracks
+  // are metered here, as microphone sources hand no audio to track sinks.
+  double capture_level = -1;
+  if (capture_meter_) {
+    AudioLevelMeter::Reading reading = capture_meter_->Read();
+    capture_level = AudioLevelMeter::Level(capture_last_, reading);
+    capture_last_ = reading;
+  }
+
+  for (auto& it : senders_) {
+    it.second.alive = false;
+  }
+  for (const auto& sender : pc_->GetSenders()) {
+    if (sender->media_type() != cricket::MEDIA_TYPE_AUDIO) {
+      continue;
+    }
+    rtc::scoped_refptr<webrtc::AudioTrackInterface> track =
+        AudioTrack(sender->track());
+    Entry* entry = &senders_[sender->id()];
+    entry->alive = true;
+    double level = SinkLevel(entry, track);
+    // A pushed track is metered by its sink alone, one that got no audio in
+    // this interval is silent whatever the microphone picks up.
+    if (level < 0 && track && track->GetSource() &&
+        !PushAudioSource::IsPushAudioSource(track->GetSource())) {
+      level = capture_level;
+    }
+    if (!track || !track->enabled()) {
+      level = 0;
+    }
+    levels.push_back(Report(sender->id(), false, level, entry, now_ms));
+  }
+
+  for (auto& it : receivers_) {
+    it.second.alive = false;
+  }
+  for (const auto& receiver : pc_->GetReceivers()) {
+    if (receiver->media_type() != cricket::MEDIA_TYPE_AUDIO) {
+      continue;
+    }
+    Entry* entry = &receivers_[receiver->id()];
+    entry->alive = true;
+    double level = RtpLevel(receiver.get(), now_ms);
+    if (level < 0) {
+      // No header extension, meter the decoded audio instead.
+      level = SinkLevel(entry, AudioTrack(receiver->track()));
+    }
+    levels.push_back(Report(receiver->id(), true, level, entry, now_ms));
+  }
+
+  for (auto* entries : {&senders_, &receivers_}) {
+    for (auto it = entries->begin(); it != entries->end();) {
+      if (it->second.alive) {
+        ++it;
+        continue;
+      }
+      DetachSink(&it->second);
+      it = entries->erase(it);
+    }
+  }
+
+  if (!levels.empty()) {
+    callback_(vector<RTCAudioLevel>(levels));
+  }
+  if (stopped_) {
+    // Stopped from the callback.
+    return;
+  }
+  signaling_thread_->PostDelayedHighPrecisionTask(
+      webrtc::SafeTask(safety_flag_, [this] { Tick(); }),
+      webrtc::TimeDelta::Millis(interval_ms_));
+}
+
+double AudioLevelMonitor::SinkLevel(
+    Entry* entry,
+    rtc::scoped_refptr<webrtc::AudioTrackInterface> track) {
+  if (entry->track != track) {
+    DetachSink(entry);
+    entry->track = track;
+  }
+  if (!track) {
+    return -1;
+  }
+  if (!entry->sink) {
+    entry->sink = std::make_unique<TrackLevelSink>();
+    entry->last = entry->sink->meter()->Read();
+    track->AddSink(entry->sink.get());
+  }
+  AudioLevelMeter::Reading reading = entry->sink->meter()->Read();
+  double level = AudioLevelMeter::Level(entry->last, reading);
+  entry->last = reading;
+  return level;
+}
+
+double AudioLevelMonitor::RtpLevel(webrtc::RtpReceiverInterface* receiver,
+                                   int64_t now_ms) {
+  const webrtc::RtpSource* latest = nullptr;
+  std::vector<webrtc::RtpSource> sources = receiver->GetSources();
+  for (const auto& source : sources) {
+    if (source.source_type() != webrtc::RtpSourceType::SSRC ||
+        !source.audio_level()) {
+      continue;
+    }
+    if (!latest || source.timestamp_ms() > latest->timestamp_ms()) {
+      latest = &source;
+    }
+  }
+  if (!latest) {
+    return -1;
+  }
+  if (now_ms - latest->timestamp_ms() > kRtpLevelTimeoutMs) {
+    return 0;
+  }
+  // The extension carries the level in -dBov, 127 is silence.
+  return std::pow(10.0, -static_cast<double>(*latest->audio_level()) / 20.0);
+}
+
+void AudioLevelMonitor::DetachSink(Entry* entry) {
+  if (entry->sink && entry->track) {
+    entry->track->RemoveSink(entry->sink.get());
+  }
+  entry->sink = nullptr;
+  entry->track = nullptr;
+}
+
+RTCAudioLevel AudioLevelMonitor::Report(const std::string& id,
+                                        bool remote,
+                                        double level,
+                                        Entry* entry,
+                                        int64_t now_ms) {
+  RTCAudioLevel report;
+  report.id = id;
+  report.remote = remote;
+  report.level = std::max(0.0, level);
+  if (report.level >= kVoiceLevel) {
+    entry->voice_until_ms = now_ms + kVoiceHangoverMs;
+  }
+  report.voice_activity = now_ms < entry->voice_until_ms;
+  return report;
+}
+
+}  // namespace libwebrtc
@@ -0,0 +1,76 @@
+#ifndef INTERNAL_AUDIO_LEVEL_MONITOR_HXX
+#define INTERNAL_AUDIO_LEVEL_MONITOR_HXX
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "api/peer_connection_interface.h"
+#include "api/task_queue/pending_task_safety_flag.h"
+#include "rtc_base/thread.h"
+#include "rtc_peerconnection.h"
+#include "src/internal/audio_level_meter.h"
+
+namespace libwebrtc {
+
+// Samples the audio level of every sender and receiver of a peer
+// connection at a fixed interval and reports them in one call. Runs on the
+// signaling thread, where the senders and receivers are read without
+// hopping threads.
+class AudioLevelMonitor {
+ public:
+  // |capture_meter| meters the microphone, it may be null.
+  AudioLevelMonitor(rtc::Thread* signaling_thread,
+                    rtc::scoped_refptr<webrtc::PeerConnectionInterface> pc,
+                    std::shared_ptr<AudioLevelMeter> capture_meter,
+                    OnAudioLevels callback,
+                    int interval_ms);
+
+  ~AudioLevelMonitor();
+
+  // No callback runs once this returns, and the peer connection is
+  // released. Can be called from the callback.
+  void Stop();
+
+ private:
+  struct Entry {
+    rtc::scoped_refptr<webrtc::AudioTrackInterface> track;
+    // Attached on demand, see Tick().
+    std::unique_ptr<TrackLevelSink> sink;
+    AudioLevelMeter::Reading last;
+    int64_t voice_until_ms = 0;
+    bool alive = false;
+  };
+
+  void Tick();
+
+  // Level from the sink of |entry|, attached to |track| if needed.
+  double SinkLevel(Entry* entry,
+                   rtc::scoped_refptr<webrtc::AudioTrackInterface> track);
+
+  // Level from the ssrc-audio-level extension, -1 if not negotiated.
+  double RtpLevel(webrtc::RtpReceiverInterface* receiver, int64_t now_ms);
+
+  void DetachSink(Entry* entry);
+
+  RTCAudioLevel Report(const std::string& id,
+                       bool remote,
+                       double level,
+                       Entry* entry,
+                       int64_t now_ms);
+
+  rtc::Thread* const signaling_thread_;
+  rtc::scoped_refptr<webrtc::PeerConnectionInterface> pc_;
+  std::shared_ptr<AudioLevelMeter> capture_meter_;
+  OnAudioLevels callback_;
+  const int interval_ms_;
+  rtc::scoped_refptr<webrtc::PendingTaskSafetyFlag> safety_flag_;
+  bool stopped_ = false;
+  AudioLevelMeter::Reading capture_last_;
+  std::map<std::string, Entry> senders_;
+  std::map<std::string, Entry> receivers_;
+};
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_AUDIO_LEVEL_MONITOR_HXX
@@ -0,0 +1,112 @@
+#include "src/internal/audio_mix_util.h"
+
+#include <algorithm>
+
+#if defined(WEBRTC_HAS_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LIBWEBRTC_HAS_SSE2
+#endif
+
+namespace libwebrtc {
+
+namespace {
+
+inline int16_t Saturate(int32_t value) {
+  return static_cast<int16_t>(
+      std::min<int32_t>(std::max<int32_t>(value, -32768), 32767));
+}
+
+}  // namespace
+
+void AddSaturated(int16_t* dst, const int16_t* src, size_t length) {
+  size_t i = 0;
+#if defined(WEBRTC_HAS_NEON)
+  for (; i + 8 <= length; i += 8) {
+    vst1q_s16(dst + i, vqaddq_s16(vld1q_s16(dst + i), vld1q_s16(src + i)));
+  }
+#elif defined(LIBWEBRTC_HAS_SSE2)
+  for (; i + 8 <= length; i += 8) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_adds_epi16(a, b));
+  }
+#endif
+  for (; i < length; ++i) {
+    dst[i] = Saturate(static_cast<int32_t>(dst[i]) + src[i]);
+  }
+}
+
+void Accumulate(int32_t* acc, const int16_t* src, size_t length) {
+  size_t i = 0;
+#if defined(WEBRTC_HAS_NEON)
+  for (; i + 8 <= length; i += 8) {
+    int16x8_t s = vld1q_s16(src + i);
+    vst1q_s32(acc + i, vaddw_s16(vld1q_s32(acc + i), vget_low_s16(s)));
+    vst1q_s32(acc + i + 4,
+              vaddw_s16(vld1q_s32(acc + i + 4), vget_high_s16(s)));
+  }
+#elif defined(LIBWEBRTC_HAS_SSE2)
+  for (; i + 8 <= length; i += 8) {
+    __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    // Sign extend by unpacking into the high halves and shifting back.
+    __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+    __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+    __m128i* a = reinterpret_cast<__m128i*>(acc + i);
+    _mm_storeu_si128(a, _mm_add_epi32(_mm_loadu_si128(a), lo));
+    _mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1), hi));
+  }
+#endif
+  for (; i < length; ++i) {
+    acc[i] += src[i];
+  }
+}
+
+void SaturateMix(int16_t* dst,
+                 const int32_t* acc,
+                 const int16_t* exclude,
+                 size_t length) {
+  size_t i = 0;
+#if defined(WEBRTC_HAS_NEON)
+  for (; i + 8 <= length; i += 8) {
+    int32x4_t lo = vld1q_s32(acc + i);
+    int32x4_t hi = vld1q_s32(acc + i + 4);
+    if (exclude) {
+      int16x8_t e = vld1q_s16(exclude + i);
+      lo = vsubw_s16(lo, vget_low_s16(e));
+      hi = vsubw_s16(hi, vget_high_s16(e));
+    }
+    vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+  }
+#elif defined(LIBWEBRTC_HAS_SSE2)
+  for (; i + 8 <= length; i += 8) {
+    const __m128i* a = reinterpret_cast<const __m128i*>(acc + i);
+    __m128i lo = _mm_loadu_si128(a);
+    __m128i hi = _mm_loadu_si128(a + 1);
+    if (exclude) {
+      __m128i e =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(exclude + i));
+      lo = _mm_sub_epi32(lo, _mm_srai_epi32(_mm_unpacklo_epi16(e, e), 16));
+      hi = _mm_sub_epi32(hi, _mm_srai_epi32(_mm_unpackhi_epi16(e, e), 16));
+    }
+    // packs saturates to the 16 bit range.
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_packs_epi32(lo, hi));
+  }
+#endif
+  for (; i < length; ++i) {
+    dst[i] = Saturate(acc[i] - (exclude ? exclude[i] : 0));
+  }
+}
+
+uint64_t Energy(const int16_t* samples, size_t length) {
+  uint64_t energy = 0;
+  for (size_t i = 0; i < length; ++i) {
+    energy += static_cast<int64_t>(samples[i]) * samples[i];
+  }
+  return energy;
+}
+
+}  // namespace libwebrtc
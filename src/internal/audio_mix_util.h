@@ -0,0 +1,29 @@
+#ifndef INTERNAL_AUDIO_MIX_UTIL_HXX
+#define INTERNAL_AUDIO_MIX_UTIL_HXX
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace libwebrtc {
+
+// Mixing kernels, vectorized with SSE2 or NEON where available.
+
+// dst[i] = saturate(dst[i] + src[i]).
+void AddSaturated(int16_t* dst, const int16_t* src, size_t length);
+
+// acc[i] += src[i], without saturating.
+void Accumulate(int32_t* acc, const int16_t* src, size_t length);
+
+// dst[i] = saturate(acc[i] - exclude[i]), or saturate(acc[i]) when
+// |exclude| is null.
+void SaturateMix(int16_t* dst,
+                 const int32_t* acc,
+                 const int16_t* exclude,
+                 size_t length);
+
+// Sum of the squared samples.
+uint64_t Energy(const int16_t* samples, size_t length);
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_AUDIO_MIX_UTIL_HXX
@@ -0,0 +1,93 @@
+#include "src/internal/certificate_cache.h"
+
+#include "rtc_base/checks.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/rtc_certificate_generator.h"
+#include "rtc_base/time_utils.h"
+
+namespace libwebrtc {
+
+CertificateCache::CertificateCache() : thread_(rtc::Thread::Create()) {
+  thread_->SetName("certificate_thread", nullptr);
+}
+
+CertificateCache::~CertificateCache() {
+  thread_->Stop();
+}
+
+void CertificateCache::Enable(const rtc::KeyParams& key_params,
+                              uint32_t rotation_period_ms) {
+  webrtc::MutexLock lock(&mutex_);
+  if (!enabled_) {
+    RTC_CHECK(thread_->Start()) << "Failed to start thread";
+    enabled_ = true;
+  }
+  if (key_params_.type() != key_params.type()) {
+    certificates_.clear();
+  }
+  key_params_ = key_params;
+  rotation_period_ms_ = rotation_period_ms;
+  ScheduleGenerate_locked(std::string());
+}
+
+rtc::scoped_refptr<rtc::RTCCertificate> CertificateCache::GetCertificate(
+    const std::string& tenant) {
+  webrtc::MutexLock lock(&mutex_);
+  if (!enabled_) {
+    return nullptr;
+  }
+  auto it = certificates_.find(tenant);
+  if (it == certificates_.end()) {
+    ScheduleGenerate_locked(tenant);
+    return nullptr;
+  }
+
+  if (rotation_period_ms_ > 0 &&
+      rtc::TimeMillis() - it->second.generated_ms >= rotation_period_ms_) {
+    ScheduleGenerate_locked(tenant);
+  }
+  return it->second.certificate;
+}
+
+void CertificateCache::PreGenerate(const std::string& tenant) {
+  webrtc::MutexLock lock(&mutex_);
+  if (enabled_ && certificates_.find(tenant) == certificates_.end()) {
+    ScheduleGenerate_locked(tenant);
+  }
+}
+
+void CertificateCache::ScheduleGenerate_locked(const std::string& tenant) {
+  if (!pending_.insert(tenant).second) {
+    return;
+  }
+  thread_->PostTask([this, tenant] { Generate_c(tenant); });
+}
+
+void CertificateCache::Generate_c(const std::string& tenant) {
+  RTC_DCHECK_RUN_ON(thread_.get());
+  rtc::KeyParams key_params;
+  {
+    webrtc::MutexLock lock(&mutex_);
+    key_params = key_params_;
+  }
+  // Key generation is the expensive part, keep it outside the lock.
+  rtc::scoped_refptr<rtc::RTCCertificate> certificate =
+      rtc::RTCCertificateGenerator::GenerateCertificate(key_params,
+                                                        absl::nullopt);
+
+  webrtc::MutexLock lock(&mutex_);
+  pending_.erase(tenant);
+  if (key_params.type() != key_params_.type()) {
+    // Reconfigured while generating, try again with the new key type.
+    ScheduleGenerate_locked(tenant);
+    return;
+  }
+  if (!certificate) {
+    RTC_LOG(LS_WARNING) << __FUNCTION__ << ": failed for tenant '" << tenant
+                        << "'";
+    return;
+  }
+  certificates_[tenant] = {certificate, rtc::TimeMillis()};
+}
+
+}  // namespace libwebrtc
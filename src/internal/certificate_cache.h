@@ -0,0 +1,61 @@
+#ifndef INTERNAL_CERTIFICATE_CACHE_HXX
+#define INTERNAL_CERTIFICATE_CACHE_HXX
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+#include "api/scoped_refptr.h"
+#include "rtc_base/rtc_certificate.h"
+#include "rtc_base/ssl_identity.h"
+#include "rtc_base/synchronization/mutex.h"
+#include "rtc_base/thread.h"
+
+namespace libwebrtc {
+
+// Keeps DTLS certificates generated on a background thread, keyed by tenant.
+// The empty tenant is the certificate shared by all peer connections of a
+// factory. The cache hands out nothing until it is enabled.
+class CertificateCache {
+ public:
+  CertificateCache();
+  ~CertificateCache();
+
+  // Enables the cache, or changes its settings. Changing the key type drops
+  // the certificates generated so far.
+  void Enable(const rtc::KeyParams& key_params, uint32_t rotation_period_ms);
+
+  // Returns the cached certificate for |tenant|, or nullptr if it has not
+  // been generated yet, in which case generation is started and the caller
+  // should let webrtc generate its own certificate. A certificate past its
+  // rotation period is still returned while its replacement is generated.
+  rtc::scoped_refptr<rtc::RTCCertificate> GetCertificate(
+      const std::string& tenant);
+
+  // Starts generating the certificate for |tenant| if it is not cached.
+  void PreGenerate(const std::string& tenant);
+
+ private:
+  struct Entry {
+    rtc::scoped_refptr<rtc::RTCCertificate> certificate;
+    int64_t generated_ms;
+  };
+
+  void ScheduleGenerate_locked(const std::string& tenant)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  void Generate_c(const std::string& tenant);
+
+  std::unique_ptr<rtc::Thread> thread_;
+  webrtc::Mutex mutex_;
+  bool enabled_ RTC_GUARDED_BY(mutex_) = false;
+  rtc::KeyParams key_params_ RTC_GUARDED_BY(mutex_);
+  uint32_t rotation_period_ms_ RTC_GUARDED_BY(mutex_) = 0;
+  std::map<std::string, Entry> certificates_ RTC_GUARDED_BY(mutex_);
+  std::set<std::string> pending_ RTC_GUARDED_BY(mutex_);
+};
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_CERTIFICATE_CACHE_HXX
@@ -0,0 +1,91 @@
+#include "src/internal/desktop_capture_scheduler.h"
+
+#include <algorithm>
+
+namespace libwebrtc {
+
+namespace {
+
+const uint32_t kDefaultMinFps = 1;
+const uint32_t kDefaultMaxFps = 60;
+
+// Unchanged frames, in seconds at the target rate, before backing off.
+const uint32_t kIdleSecondsBeforeBackoff = 1;
+
+// Capture and conversion may use this share of the interval.
+const int64_t kMaxBusyPercent = 80;
+
+// Weight of a new sample in the smoothed duration, in percent.
+const int64_t kDurationSmoothingPercent = 20;
+
+}  // namespace
+
+DesktopCaptureScheduler::DesktopCaptureScheduler()
+    : min_fps_(kDefaultMinFps),
+      max_fps_(kDefaultMaxFps),
+      requested_fps_(kDefaultMaxFps) {}
+
+DesktopCaptureScheduler::~DesktopCaptureScheduler() {}
+
+void DesktopCaptureScheduler::SetFramerateRange(uint32_t min_fps,
+                                                uint32_t max_fps) {
+  max_fps_ = std::max<uint32_t>(max_fps, 1);
+  min_fps_ = std::min(std::max<uint32_t>(min_fps, 1), max_fps_);
+}
+
+void DesktopCaptureScheduler::SetRequestedFramerate(uint32_t fps) {
+  requested_fps_ = std::max<uint32_t>(fps, 1);
+}
+
+void DesktopCaptureScheduler::SetSinkMaxFramerate(int fps) {
+  sink_max_fps_ = fps;
+}
+
+uint32_t DesktopCaptureScheduler::target_fps() const {
+  uint32_t fps = std::min(requested_fps_, max_fps_);
+  if (sink_max_fps_ > 0) {
+    fps = std::min(fps, static_cast<uint32_t>(sink_max_fps_));
+  }
+  return std::max(fps, min_fps_);
+}
+
+void DesktopCaptureScheduler::OnCaptureDone(int64_t duration_us,
+                                            bool changed) {
+  last_duration_us_ = duration_us;
+  avg_duration_us_ = avg_duration_us_ == 0
+                         ? duration_us
+                         : (avg_duration_us_ * (100 - kDurationSmoothingPercent) +
+                            duration_us * kDurationSmoothingPercent) /
+                               100;
+
+  if (changed) {
+    idle_frames_ = 0;
+    idle_interval_ms_ = 0;
+    return;
+  }
+
+  idle_frames_++;
+  if (idle_frames_ < kIdleSecondsBeforeBackoff * target_fps()) {
+    return;
+  }
+  // Static content, double the interval up to the minimum frame rate.
+  const int64_t max_interval_ms = 1000 / min_fps_;
+  idle_interval_ms_ = std::min(
+      max_interval_ms, std::max(idle_interval_ms_, TargetIntervalMs()) * 2);
+}
+
+int64_t DesktopCaptureScheduler::TargetIntervalMs() const {
+  int64_t interval_ms = 1000 / target_fps();
+  // Leave the thread some room when capturing is expensive.
+  const int64_t busy_interval_ms =
+      avg_duration_us_ * 100 / kMaxBusyPercent / 1000;
+  return std::max(interval_ms, busy_interval_ms);
+}
+
+int64_t DesktopCaptureScheduler::NextDelayMs() const {
+  int64_t interval_ms = std::max(TargetIntervalMs(), idle_interval_ms_);
+  // The interval runs from the start of the last capture.
+  return std::max<int64_t>(interval_ms - last_duration_us_ / 1000, 1);
+}
+
+}  // namespace libwebrtc
@@ -0,0 +1,53 @@
+#ifndef INTERNAL_DESKTOP_CAPTURE_SCHEDULER_HXX
+#define INTERNAL_DESKTOP_CAPTURE_SCHEDULER_HXX
+
+#include <stdint.h>
+
+namespace libwebrtc {
+
+// Picks the delay before the next desktop capture. The frame rate follows
+// the lowest of the requested rate, the rate the sinks want and |max_fps|.
+// While the content does not change it backs off towards |min_fps|, and it
+// returns to the full rate on the first damaged frame. The interval is also
+// stretched when capture and conversion take most of it. Not thread safe.
+class DesktopCaptureScheduler {
+ public:
+  DesktopCaptureScheduler();
+  ~DesktopCaptureScheduler();
+
+  void SetFramerateRange(uint32_t min_fps, uint32_t max_fps);
+
+  // The frame rate passed to Start().
+  void SetRequestedFramerate(uint32_t fps);
+
+  // VideoSinkWants::max_framerate_fps of the sinks, <= 0 for no limit.
+  void SetSinkMaxFramerate(int fps);
+
+  // Reports a capture that took |duration_us|, including conversion.
+  // |changed| is false when the frame had no damage.
+  void OnCaptureDone(int64_t duration_us, bool changed);
+
+  // Delay between the end of the last capture and the next one.
+  int64_t NextDelayMs() const;
+
+  // The current frame rate target, for logging.
+  uint32_t target_fps() const;
+
+ private:
+  int64_t TargetIntervalMs() const;
+
+  uint32_t min_fps_;
+  uint32_t max_fps_;
+  uint32_t requested_fps_;
+  int sink_max_fps_ = 0;
+  // Unchanged frames since the last damaged one.
+  uint32_t idle_frames_ = 0;
+  int64_t idle_interval_ms_ = 0;
+  // Smoothed capture and conversion time.
+  int64_t avg_duration_us_ = 0;
+  int64_t last_duration_us_ = 0;
+};
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_DESKTOP_CAPTURE_SCHEDULER_HXX
@@ -0,0 +1,120 @@
+#include "src/internal/desktop_capture_service.h"
+
+#include <algorithm>
+
+#include "rtc_base/checks.h"
+#include "rtc_base/synchronization/mutex.h"
+#include "rtc_base/time_utils.h"
+#include "system_wrappers/include/cpu_info.h"
+
+namespace libwebrtc {
+
+namespace {
+
+// Ticks due within this window of the earliest one run with it.
+const int64_t kTickSlackMs = 4;
+
+webrtc::Mutex g_service_mutex;
+std::weak_ptr<DesktopCaptureService>* g_service = nullptr;
+
+}  // namespace
+
+std::shared_ptr<DesktopCaptureService> DesktopCaptureService::Get() {
+  webrtc::MutexLock lock(&g_service_mutex);
+  if (!g_service) {
+    g_service = new std::weak_ptr<DesktopCaptureService>();
+  }
+  std::shared_ptr<DesktopCaptureService> service = g_service->lock();
+  if (!service) {
+    service = std::make_shared<DesktopCaptureService>();
+    *g_service = service;
+  }
+  return service;
+}
+
+DesktopCaptureService::DesktopCaptureService()
+    : capture_thread_(rtc::Thread::Create()) {
+  capture_thread_->SetName("desktop_capture_thread", nullptr);
+  RTC_CHECK(capture_thread_->Start()) << "Failed to start thread";
+
+  // The capture thread does the capturing, the rest of the cores convert.
+  int cores = static_cast<int>(webrtc::CpuInfo::DetectNumberOfCores());
+  int num_workers = std::max(1, cores - 1);
+  for (int i = 0; i < num_workers; i++) {
+    std::unique_ptr<rtc::Thread> worker = rtc::Thread::Create();
+    worker->SetName("desktop_convert_thread", nullptr);
+    RTC_CHECK(worker->Start()) << "Failed to start thread";
+    workers_.push_back(std::move(worker));
+  }
+}
+
+DesktopCaptureService::~DesktopCaptureService() {
+  capture_thread_->Stop();
+  for (auto& worker : workers_) {
+    worker->Stop();
+  }
+}
+
+rtc::Thread* DesktopCaptureService::AssignWorkerThread() {
+  return workers_[next_worker_++ % workers_.size()].get();
+}
+
+void DesktopCaptureService::ScheduleTick(Client* client, int64_t delay_ms) {
+  RTC_DCHECK_RUN_ON(capture_thread_.get());
+  due_ms_[client] = rtc::TimeMillis() + std::max<int64_t>(delay_ms, 0);
+  ArmTimer();
+}
+
+void DesktopCaptureService::CancelTick(Client* client) {
+  RTC_DCHECK_RUN_ON(capture_thread_.get());
+  due_ms_.erase(client);
+}
+
+void DesktopCaptureService::ArmTimer() {
+  if (due_ms_.empty()) {
+    return;
+  }
+  int64_t next_ms = due_ms_.begin()->second;
+  for (const auto& it : due_ms_) {
+    next_ms = std::min(next_ms, it.second);
+  }
+  if (timer_ms_ >= 0 && timer_ms_ <= next_ms) {
+    // The armed timer fires first.
+    return;
+  }
+
+  // A timer armed for later is left to expire as stale.
+  timer_ms_ = next_ms;
+  uint64_t generation = ++timer_generation_;
+  capture_thread_->PostDelayedHighPrecisionTask(
+      [this, generation] { OnTimer(generation); },
+      webrtc::TimeDelta::Millis(
+          std::max<int64_t>(next_ms - rtc::TimeMillis(), 0)));
+}
+
+void DesktopCaptureService::OnTimer(uint64_t generation) {
+  RTC_DCHECK_RUN_ON(capture_thread_.get());
+  if (generation != timer_generation_) {
+    return;
+  }
+  timer_ms_ = -1;
+
+  const int64_t deadline_ms = rtc::TimeMillis() + kTickSlackMs;
+  std::vector<Client*> due;
+  for (auto it = due_ms_.begin(); it != due_ms_.end();) {
+    if (it->second <= deadline_ms) {
+      due.push_back(it->first);
+      it = due_ms_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  // Clients schedule their next tick from OnCaptureTick(), or later when
+  // their conversion is done.
+  for (Client* client : due) {
+    client->OnCaptureTick();
+  }
+  ArmTimer();
+}
+
+}  // namespace libwebrtc
@@ -0,0 +1,64 @@
+#ifndef INTERNAL_DESKTOP_CAPTURE_SERVICE_HXX
+#define INTERNAL_DESKTOP_CAPTURE_SERVICE_HXX
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "rtc_base/thread.h"
+
+namespace libwebrtc {
+
+// Runs the capture ticks of all desktop capturers on one thread, and their
+// frame conversions on a pool of worker threads sized to the core count.
+// Ticks that fall due close to each other run in one wakeup, so capturers
+// with the same frame rate settle on a common phase instead of waking the
+// CPU one after the other. Shared by the capturers alive at the same time.
+class DesktopCaptureService {
+ public:
+  class Client {
+   public:
+    // Called on the capture thread when the tick scheduled with
+    // ScheduleTick() is due.
+    virtual void OnCaptureTick() = 0;
+
+   protected:
+    virtual ~Client() {}
+  };
+
+  // Returns the service, creating it if no capturer holds it.
+  static std::shared_ptr<DesktopCaptureService> Get();
+
+  DesktopCaptureService();
+  ~DesktopCaptureService();
+
+  rtc::Thread* capture_thread() { return capture_thread_.get(); }
+
+  // Picks a conversion thread for a new capturer. Capturers are spread
+  // round robin over the pool.
+  rtc::Thread* AssignWorkerThread();
+
+  // Runs the next tick of |client| |delay_ms| from now, replacing the tick
+  // scheduled before. Capture thread only.
+  void ScheduleTick(Client* client, int64_t delay_ms);
+
+  // Cancels the scheduled tick of |client|. Capture thread only.
+  void CancelTick(Client* client);
+
+ private:
+  void ArmTimer();
+  void OnTimer(uint64_t generation);
+
+  std::unique_ptr<rtc::Thread> capture_thread_;
+  std::vector<std::unique_ptr<rtc::Thread>> workers_;
+  std::atomic<size_t> next_worker_{0};
+  // Capture thread only.
+  std::map<Client*, int64_t> due_ms_;
+  int64_t timer_ms_ = -1;
+  uint64_t timer_generation_ = 0;
+};
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_DESKTOP_CAPTURE_SERVICE_HXX
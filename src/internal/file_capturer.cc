@@ -0,0 +1,176 @@
+#include "src/internal/file_capturer.h"
+
+#include <algorithm>
+
+#include "api/make_ref_counted.h"
+#include "api/sequence_checker.h"
+#include "api/units/time_delta.h"
+#include "api/video/i420_buffer.h"
+#include "api/video/nv12_buffer.h"
+#include "common_video/include/video_frame_buffer.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/synchronization/mutex.h"
+#include "rtc_base/time_utils.h"
+#include "third_party/libyuv/include/libyuv.h"
+
+namespace webrtc {
+namespace internal {
+
+namespace {
+
+const double kDefaultFps = 30;
+
+webrtc::Mutex g_thread_mutex;
+std::weak_ptr<rtc::Thread>* g_thread = nullptr;
+
+// The thread that paces every file capturer alive.
+std::shared_ptr<rtc::Thread> GetReplayThread() {
+  webrtc::MutexLock lock(&g_thread_mutex);
+  if (!g_thread) {
+    g_thread = new std::weak_ptr<rtc::Thread>();
+  }
+  std::shared_ptr<rtc::Thread> thread = g_thread->lock();
+  if (!thread) {
+    thread = std::shared_ptr<rtc::Thread>(rtc::Thread::Create().release(),
+                                          [](rtc::Thread* thread) {
+                                            thread->Stop();
+                                            delete thread;
+                                          });
+    thread->SetName("file_capture_thread", nullptr);
+    RTC_CHECK(thread->Start()) << "Failed to start thread";
+    *g_thread = thread;
+  }
+  return thread;
+}
+
+// An NV12 frame in the mapping of a file, which it keeps alive.
+class MappedNV12Buffer : public NV12BufferInterface {
+ public:
+  MappedNV12Buffer(std::shared_ptr<libwebrtc::VideoFileReader> reader,
+                   const uint8_t* data)
+      : reader_(reader), data_(data) {}
+
+  int width() const override { return reader_->width(); }
+  int height() const override { return reader_->height(); }
+  const uint8_t* DataY() const override { return data_; }
+  const uint8_t* DataUV() const override {
+    return data_ + static_cast<size_t>(StrideY()) * height();
+  }
+  int StrideY() const override { return width(); }
+  int StrideUV() const override { return 2 * ChromaWidth(); }
+
+  rtc::scoped_refptr<I420BufferInterface> ToI420() override {
+    rtc::scoped_refptr<I420Buffer> i420 = I420Buffer::Create(width(), height());
+    libyuv::NV12ToI420(DataY(), StrideY(), DataUV(), StrideUV(),
+                       i420->MutableDataY(), i420->StrideY(),
+                       i420->MutableDataU(), i420->StrideU(),
+                       i420->MutableDataV(), i420->StrideV(), width(),
+                       height());
+    return i420;
+  }
+
+ private:
+  std::shared_ptr<libwebrtc::VideoFileReader> reader_;
+  const uint8_t* data_;
+};
+
+}  // namespace
+
+std::shared_ptr<FileCapturer> FileCapturer::Create(
+    std::shared_ptr<libwebrtc::VideoFileReader> reader,
+    size_t target_fps,
+    bool loop) {
+  if (!reader) {
+    return nullptr;
+  }
+  double fps = target_fps > 0 ? static_cast<double>(target_fps) : reader->fps();
+  if (fps <= 0) {
+    fps = kDefaultFps;
+  }
+  return std::make_shared<FileCapturer>(reader, fps, loop);
+}
+
+FileCapturer::FileCapturer(std::shared_ptr<libwebrtc::VideoFileReader> reader,
+                           double fps,
+                           bool loop)
+    : reader_(reader), thread_(GetReplayThread()), fps_(fps), loop_(loop) {}
+
+FileCapturer::~FileCapturer() {
+  StopCapture();
+}
+
+bool FileCapturer::StartCapture() {
+  thread_->BlockingCall([this] {
+    if (started_) {
+      return;
+    }
+    // The safety flag is bound to the thread that creates it.
+    safety_flag_ = PendingTaskSafetyFlag::Create();
+    started_ = true;
+    start_us_ = rtc::TimeMicros();
+    frame_number_ = 0;
+    DeliverFrame();
+  });
+  return true;
+}
+
+bool FileCapturer::CaptureStarted() {
+  return thread_->BlockingCall([this] { return started_; });
+}
+
+void FileCapturer::StopCapture() {
+  thread_->BlockingCall([this] {
+    if (safety_flag_) {
+      safety_flag_->SetNotAlive();
+      safety_flag_ = nullptr;
+    }
+    started_ = false;
+  });
+}
+
+void FileCapturer::DeliverFrame() {
+  RTC_DCHECK_RUN_ON(thread_.get());
+  size_t index = static_cast<size_t>(frame_number_ % reader_->frame_count());
+  if (!loop_ && frame_number_ >= static_cast<int64_t>(reader_->frame_count())) {
+    started_ = false;
+    return;
+  }
+
+  const uint8_t* data = reader_->frame(index);
+  const int width = reader_->width();
+  const int height = reader_->height();
+  std::shared_ptr<libwebrtc::VideoFileReader> reader = reader_;
+  rtc::scoped_refptr<VideoFrameBuffer> buffer;
+  if (reader_->pixel_format() == libwebrtc::VideoFileReader::kNV12) {
+    buffer = rtc::make_ref_counted<MappedNV12Buffer>(reader_, data);
+  } else {
+    const int chroma_width = (width + 1) / 2;
+    const int chroma_height = (height + 1) / 2;
+    const uint8_t* u = data + static_cast<size_t>(width) * height;
+    const uint8_t* v = u + static_cast<size_t>(chroma_width) * chroma_height;
+    buffer = WrapI420Buffer(width, height, data, width, u, chroma_width, v,
+                            chroma_width, [reader] {});
+  }
+
+  // The timestamp is where the frame falls at the target rate, not when the
+  // task happened to run.
+  const int64_t timestamp_us =
+      start_us_ + static_cast<int64_t>(frame_number_ * 1000000 / fps_);
+  OnFrame(VideoFrame::Builder()
+              .set_video_frame_buffer(buffer)
+              .set_rotation(kVideoRotation_0)
+              .set_timestamp_us(timestamp_us)
+              .build());
+
+  ++frame_number_;
+  const int64_t next_us =
+      start_us_ + static_cast<int64_t>(frame_number_ * 1000000 / fps_);
+  const int64_t delay_us = std::max<int64_t>(0, next_us - rtc::TimeMicros());
+  thread_->PostDelayedHighPrecisionTask(
+      SafeTask(safety_flag_, [this] { DeliverFrame(); }),
+      TimeDelta::Micros(delay_us));
+}
+
+}  // namespace internal
+}  // namespace webrtc
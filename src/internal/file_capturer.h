@@ -0,0 +1,57 @@
+#ifndef INTERNAL_FILE_CAPTURER_HXX
+#define INTERNAL_FILE_CAPTURER_HXX
+
+#include <memory>
+
+#include "api/scoped_refptr.h"
+#include "api/task_queue/pending_task_safety_flag.h"
+#include "rtc_base/thread.h"
+#include "src/internal/video_capturer.h"
+#include "src/internal/video_file_reader.h"
+
+namespace webrtc {
+namespace internal {
+
+// Replays a Y4M or raw YUV file as a camera. Frames point into the shared
+// mapping of the file, without a copy, and carry timestamps computed from
+// their index so that runs are reproducible. All file capturers pace their
+// frames on one shared thread.
+class FileCapturer : public VideoCapturer {
+ public:
+  // |target_fps| 0 uses the rate of a Y4M file, or 30.
+  static std::shared_ptr<FileCapturer> Create(
+      std::shared_ptr<libwebrtc::VideoFileReader> reader,
+      size_t target_fps,
+      bool loop);
+
+  FileCapturer(std::shared_ptr<libwebrtc::VideoFileReader> reader,
+               double fps,
+               bool loop);
+  ~FileCapturer() override;
+
+  bool StartCapture() override;
+
+  bool CaptureStarted() override;
+
+  void StopCapture() override;
+
+ private:
+  void DeliverFrame();
+
+  std::shared_ptr<libwebrtc::VideoFileReader> reader_;
+  std::shared_ptr<rtc::Thread> thread_;
+  const double fps_;
+  const bool loop_;
+
+  // Replay thread only.
+  rtc::scoped_refptr<PendingTaskSafetyFlag> safety_flag_;
+  bool started_ = false;
+  int64_t start_us_ = 0;
+  // Frames sent since StartCapture().
+  int64_t frame_number_ = 0;
+};
+
+}  // namespace internal
+}  // namespace webrtc
+
+#endif  // INTERNAL_FILE_CAPTURER_HXX
@@ -0,0 +1,286 @@
+#include "src/internal/frame_cryptor_engine.h"
+
+#include <algorithm>
+
+#include "rtc_base/checks.h"
+#include "rtc_base/helpers.h"
+#include "rtc_base/logging.h"
+
+namespace libwebrtc {
+
+namespace {
+
+constexpr size_t kAudioUnencryptedBytes = 1;
+constexpr size_t kVp8KeyFrameUnencryptedBytes = 10;
+constexpr size_t kVp8DeltaFrameUnencryptedBytes = 3;
+
+// The frames of a stream are transformed on its encoder or decoder thread,
+// so each of those threads reuses one output buffer. SetData() copies out
+// of it.
+rtc::Buffer* FrameBuffer() {
+  thread_local rtc::Buffer buffer;
+  return &buffer;
+}
+
+void WriteUint32(uint8_t* out, uint32_t value) {
+  out[0] = static_cast<uint8_t>(value >> 24);
+  out[1] = static_cast<uint8_t>(value >> 16);
+  out[2] = static_cast<uint8_t>(value >> 8);
+  out[3] = static_cast<uint8_t>(value);
+}
+
+}  // namespace
+
+FrameCryptorEngine::FrameCryptorEngine(
+    const std::string participant_id,
+    webrtc::FrameCryptorTransformer::MediaType type,
+    webrtc::FrameCryptorTransformer::Algorithm algorithm,
+    rtc::scoped_refptr<webrtc::KeyProvider> key_provider,
+    std::vector<uint8_t> uncrypted_magic_bytes,
+    std::shared_ptr<KeyRatchetCache> ratchet_cache)
+    : participant_id_(participant_id),
+      type_(type),
+      algorithm_(algorithm),
+      uncrypted_magic_bytes_(std::move(uncrypted_magic_bytes)),
+      fallback_(new webrtc::FrameCryptorTransformer(participant_id, type,
+                                                    algorithm, key_provider)),
+      cipher_(participant_id, key_provider, std::move(ratchet_cache)),
+      send_count_(rtc::CreateRandomId()) {
+  fallback_->SetFrameCryptorTransformerObserver(this);
+  fallback_->SetEnabled(false);
+}
+
+FrameCryptorEngine::~FrameCryptorEngine() {
+  fallback_->SetFrameCryptorTransformerObserver(nullptr);
+}
+
+void FrameCryptorEngine::SetFrameCryptorTransformerObserver(
+    webrtc::FrameCryptorTransformerObserver* observer) {
+  webrtc::MutexLock lock(&observer_mutex_);
+  observer_ = observer;
+}
+
+void FrameCryptorEngine::SetEnabled(bool enabled) {
+  webrtc::MutexLock lock(&mutex_);
+  enabled_ = enabled;
+  fallback_->SetEnabled(enabled);
+}
+
+void FrameCryptorEngine::SetKeyIndex(int index) {
+  webrtc::MutexLock lock(&mutex_);
+  key_index_ = index;
+  fallback_->SetKeyIndex(index);
+}
+
+void FrameCryptorEngine::RegisterTransformedFrameCallback(
+    rtc::scoped_refptr<webrtc::TransformedFrameCallback> callback) {
+  {
+    webrtc::MutexLock lock(&mutex_);
+    sink_callback_ = callback;
+  }
+  fallback_->RegisterTransformedFrameCallback(callback);
+}
+
+void FrameCryptorEngine::RegisterTransformedFrameSinkCallback(
+    rtc::scoped_refptr<webrtc::TransformedFrameCallback> callback,
+    uint32_t ssrc) {
+  {
+    webrtc::MutexLock lock(&mutex_);
+    sink_callbacks_[ssrc] = callback;
+  }
+  fallback_->RegisterTransformedFrameSinkCallback(callback, ssrc);
+}
+
+void FrameCryptorEngine::UnregisterTransformedFrameCallback() {
+  {
+    webrtc::MutexLock lock(&mutex_);
+    sink_callback_ = nullptr;
+  }
+  fallback_->UnregisterTransformedFrameCallback();
+}
+
+void FrameCryptorEngine::UnregisterTransformedFrameSinkCallback(
+    uint32_t ssrc) {
+  {
+    webrtc::MutexLock lock(&mutex_);
+    sink_callbacks_.erase(ssrc);
+  }
+  fallback_->UnregisterTransformedFrameSinkCallback(ssrc);
+}
+
+void FrameCryptorEngine::OnFrameCryptionStateChanged(
+    const std::string participant_id,
+    webrtc::FrameCryptionState state) {
+  SetState(state);
+}
+
+void FrameCryptorEngine::Transform(
+    std::unique_ptr<webrtc::TransformableFrameInterface> transformable_frame) {
+  switch (transformable_frame->GetDirection()) {
+    case webrtc::TransformableFrameInterface::Direction::kSender:
+      EncryptFrame(std::move(transformable_frame));
+      break;
+    case webrtc::TransformableFrameInterface::Direction::kReceiver:
+      DecryptFrame(std::move(transformable_frame));
+      break;
+    case webrtc::TransformableFrameInterface::Direction::kUnknown:
+      // Leave it to the wrapped transformer, which knows the legacy frames.
+      fallback_->Transform(std::move(transformable_frame));
+      break;
+  }
+}
+
+void FrameCryptorEngine::EncryptFrame(
+    std::unique_ptr<webrtc::TransformableFrameInterface> frame) {
+  rtc::scoped_refptr<webrtc::TransformedFrameCallback> sink_callback;
+  bool enabled = false;
+  int key_index = 0;
+  uint32_t send_count = 0;
+  {
+    webrtc::MutexLock lock(&mutex_);
+    sink_callback = SinkCallback_locked(frame->GetSsrc());
+    enabled = enabled_;
+    key_index = key_index_;
+    if (enabled) {
+      send_count = send_count_++;
+    }
+  }
+  if (!sink_callback) {
+    return;
+  }
+
+  rtc::ArrayView<const uint8_t> data = frame->GetData();
+  if (enabled && !data.empty()) {
+    size_t unencrypted_bytes = 0;
+    if (algorithm_ != webrtc::FrameCryptorTransformer::Algorithm::kAesGcm ||
+        !UnencryptedBytes(frame.get(), &unencrypted_bytes)) {
+      fallback_->Transform(std::move(frame));
+      return;
+    }
+    unencrypted_bytes = std::min(unencrypted_bytes, data.size());
+    uint8_t iv[AesGcmCipher::kIvSize];
+    WriteUint32(iv, frame->GetSsrc());
+    WriteUint32(iv + 4, frame->GetTimestamp());
+    WriteUint32(iv + 8, send_count);
+
+    rtc::Buffer* buffer = FrameBuffer();
+    if (cipher_.Seal(key_index, data.subview(0, unencrypted_bytes),
+                     data.subview(unencrypted_bytes), iv,
+                     buffer) != AesGcmCipher::Result::kOk) {
+      // Missing key, the wrapped transformer reports the state.
+      fallback_->Transform(std::move(frame));
+      return;
+    }
+    frame->SetData(*buffer);
+    SetState(webrtc::FrameCryptionState::kOk);
+  }
+  sink_callback->OnTransformedFrame(std::move(frame));
+}
+
+void FrameCryptorEngine::DecryptFrame(
+    std::unique_ptr<webrtc::TransformableFrameInterface> frame) {
+  rtc::scoped_refptr<webrtc::TransformedFrameCallback> sink_callback;
+  bool enabled = false;
+  {
+    webrtc::MutexLock lock(&mutex_);
+    sink_callback = SinkCallback_locked(frame->GetSsrc());
+    enabled = enabled_;
+  }
+  if (!sink_callback) {
+    return;
+  }
+
+  rtc::ArrayView<const uint8_t> data = frame->GetData();
+  if (!enabled || data.empty()) {
+    sink_callback->OnTransformedFrame(std::move(frame));
+    return;
+  }
+
+  size_t unencrypted_bytes = 0;
+  if (algorithm_ != webrtc::FrameCryptorTransformer::Algorithm::kAesGcm ||
+      HasMagicBytes(data) ||
+      !UnencryptedBytes(frame.get(), &unencrypted_bytes)) {
+    fallback_->Transform(std::move(frame));
+    return;
+  }
+
+  rtc::Buffer* buffer = FrameBuffer();
+  webrtc::FrameCryptionState state = webrtc::FrameCryptionState::kNew;
+  switch (cipher_.Open(data, unencrypted_bytes, buffer)) {
+    case AesGcmCipher::Result::kOk:
+      state = webrtc::FrameCryptionState::kOk;
+      break;
+    case AesGcmCipher::Result::kKeyRatcheted:
+      state = webrtc::FrameCryptionState::kKeyRatcheted;
+      break;
+    case AesGcmCipher::Result::kFailed:
+      // Undecryptable frames are dropped, as the wrapped transformer does.
+      SetState(webrtc::FrameCryptionState::kDecryptionFailed);
+      return;
+    case AesGcmCipher::Result::kMissingKey:
+    case AesGcmCipher::Result::kInvalid:
+      fallback_->Transform(std::move(frame));
+      return;
+  }
+  frame->SetData(*buffer);
+  SetState(state);
+  sink_callback->OnTransformedFrame(std::move(frame));
+}
+
+rtc::scoped_refptr<webrtc::TransformedFrameCallback>
+FrameCryptorEngine::SinkCallback_locked(uint32_t ssrc) {
+  auto it = sink_callbacks_.find(ssrc);
+  if (it != sink_callbacks_.end()) {
+    return it->second;
+  }
+  return sink_callback_;
+}
+
+bool FrameCryptorEngine::UnencryptedBytes(
+    webrtc::TransformableFrameInterface* frame,
+    size_t* unencrypted_bytes) const {
+  if (type_ == webrtc::FrameCryptorTransformer::MediaType::kAudioFrame) {
+    *unencrypted_bytes = kAudioUnencryptedBytes;
+    return true;
+  }
+
+  auto video_frame =
+      static_cast<webrtc::TransformableVideoFrameInterface*>(frame);
+  switch (video_frame->GetMetadata().GetCodec()) {
+    case webrtc::kVideoCodecVP8:
+      *unencrypted_bytes = video_frame->IsKeyFrame()
+                               ? kVp8KeyFrameUnencryptedBytes
+                               : kVp8DeltaFrameUnencryptedBytes;
+      return true;
+    case webrtc::kVideoCodecH264:
+      // Needs NALU parsing, done by the wrapped transformer.
+      return false;
+    default:
+      *unencrypted_bytes = 0;
+      return true;
+  }
+}
+
+bool FrameCryptorEngine::HasMagicBytes(
+    rtc::ArrayView<const uint8_t> data) const {
+  if (uncrypted_magic_bytes_.empty() ||
+      data.size() < uncrypted_magic_bytes_.size()) {
+    return false;
+  }
+  return std::equal(uncrypted_magic_bytes_.begin(),
+                    uncrypted_magic_bytes_.end(),
+                    data.end() - uncrypted_magic_bytes_.size());
+}
+
+void FrameCryptorEngine::SetState(webrtc::FrameCryptionState state) {
+  webrtc::MutexLock lock(&observer_mutex_);
+  if (last_state_ == state) {
+    return;
+  }
+  last_state_ = state;
+  if (observer_) {
+    observer_->OnFrameCryptionStateChanged(participant_id_, state);
+  }
+}
+
+}  // namespace libwebrtc
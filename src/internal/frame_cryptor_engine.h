@@ -0,0 +1,105 @@
+#ifndef INTERNAL_FRAME_CRYPTOR_ENGINE_HXX
+#define INTERNAL_FRAME_CRYPTOR_ENGINE_HXX
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "api/crypto/frame_crypto_transformer.h"
+#include "api/frame_transformer_interface.h"
+#include "api/scoped_refptr.h"
+#include "rtc_base/buffer.h"
+#include "rtc_base/synchronization/mutex.h"
+#include "src/internal/aes_gcm_cipher.h"
+#include "src/internal/key_ratchet_cache.h"
+
+namespace libwebrtc {
+
+// AES-GCM frame transformer that produces the same wire format as
+// webrtc::FrameCryptorTransformer, see AesGcmCipher. The output of each
+// frame is built in a per-thread buffer reused across frames, and frames
+// are sealed and opened outside the lock of the engine. A frame that fails to
+// decrypt is retried with the ratcheted keys of |ratchet_cache|, if any, and
+// dropped when none matches. Frames that need codec specific handling
+// (H264), AES-CBC and missing keys are forwarded to a wrapped
+// webrtc::FrameCryptorTransformer, which reports the state for those paths.
+class FrameCryptorEngine
+    : public rtc::RefCountedObject<webrtc::FrameTransformerInterface>,
+      public webrtc::FrameCryptorTransformerObserver {
+ public:
+  FrameCryptorEngine(const std::string participant_id,
+                     webrtc::FrameCryptorTransformer::MediaType type,
+                     webrtc::FrameCryptorTransformer::Algorithm algorithm,
+                     rtc::scoped_refptr<webrtc::KeyProvider> key_provider,
+                     std::vector<uint8_t> uncrypted_magic_bytes,
+                     std::shared_ptr<KeyRatchetCache> ratchet_cache);
+  ~FrameCryptorEngine() override;
+
+  void SetFrameCryptorTransformerObserver(
+      webrtc::FrameCryptorTransformerObserver* observer);
+
+  void SetEnabled(bool enabled);
+
+  void SetKeyIndex(int index);
+
+  // webrtc::FrameTransformerInterface
+  void Transform(std::unique_ptr<webrtc::TransformableFrameInterface>
+                     transformable_frame) override;
+
+  void RegisterTransformedFrameCallback(
+      rtc::scoped_refptr<webrtc::TransformedFrameCallback> callback) override;
+
+  void RegisterTransformedFrameSinkCallback(
+      rtc::scoped_refptr<webrtc::TransformedFrameCallback> callback,
+      uint32_t ssrc) override;
+
+  void UnregisterTransformedFrameCallback() override;
+
+  void UnregisterTransformedFrameSinkCallback(uint32_t ssrc) override;
+
+  // webrtc::FrameCryptorTransformerObserver, from the wrapped transformer.
+  void OnFrameCryptionStateChanged(const std::string participant_id,
+                                   webrtc::FrameCryptionState state) override;
+
+ private:
+  void EncryptFrame(std::unique_ptr<webrtc::TransformableFrameInterface> frame);
+
+  void DecryptFrame(std::unique_ptr<webrtc::TransformableFrameInterface> frame);
+
+  rtc::scoped_refptr<webrtc::TransformedFrameCallback> SinkCallback_locked(
+      uint32_t ssrc) RTC_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  bool UnencryptedBytes(webrtc::TransformableFrameInterface* frame,
+                        size_t* unencrypted_bytes) const;
+
+  bool HasMagicBytes(rtc::ArrayView<const uint8_t> data) const;
+
+  void SetState(webrtc::FrameCryptionState state);
+
+  const std::string participant_id_;
+  const webrtc::FrameCryptorTransformer::MediaType type_;
+  const webrtc::FrameCryptorTransformer::Algorithm algorithm_;
+  const std::vector<uint8_t> uncrypted_magic_bytes_;
+  rtc::scoped_refptr<webrtc::FrameCryptorTransformer> fallback_;
+  AesGcmCipher cipher_;
+
+  webrtc::Mutex mutex_;
+  bool enabled_ RTC_GUARDED_BY(mutex_) = false;
+  int key_index_ RTC_GUARDED_BY(mutex_) = 0;
+  uint32_t send_count_ RTC_GUARDED_BY(mutex_) = 0;
+  rtc::scoped_refptr<webrtc::TransformedFrameCallback> sink_callback_
+      RTC_GUARDED_BY(mutex_);
+  std::map<uint32_t, rtc::scoped_refptr<webrtc::TransformedFrameCallback>>
+      sink_callbacks_ RTC_GUARDED_BY(mutex_);
+
+  webrtc::Mutex observer_mutex_;
+  webrtc::FrameCryptorTransformerObserver* observer_
+      RTC_GUARDED_BY(observer_mutex_) = nullptr;
+  webrtc::FrameCryptionState last_state_ RTC_GUARDED_BY(observer_mutex_) =
+      webrtc::FrameCryptionState::kNew;
+};
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_FRAME_CRYPTOR_ENGINE_HXX
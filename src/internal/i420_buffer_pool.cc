@@ -0,0 +1,35 @@
+#include "src/internal/i420_buffer_pool.h"
+
+namespace libwebrtc {
+
+I420BufferPool::I420BufferPool(size_t max_buffers)
+    : pool_(/*zero_initialize=*/false, max_buffers) {}
+
+I420BufferPool::~I420BufferPool() {}
+
+rtc::scoped_refptr<webrtc::I420Buffer> I420BufferPool::CreateBuffer(
+    int width,
+    int height) {
+  if (width != width_ || height != height_) {
+    // The pool drops its buffers when the resolution changes.
+    known_buffers_.clear();
+    width_ = width;
+    height_ = height;
+  }
+
+  rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+      pool_.CreateI420Buffer(width, height);
+  if (!buffer) {
+    misses_++;
+    return webrtc::I420Buffer::Create(width, height);
+  }
+
+  if (known_buffers_.insert(buffer.get()).second) {
+    misses_++;
+  } else {
+    hits_++;
+  }
+  return buffer;
+}
+
+}  // namespace libwebrtc
@@ -0,0 +1,46 @@
+#ifndef INTERNAL_I420_BUFFER_POOL_HXX
+#define INTERNAL_I420_BUFFER_POOL_HXX
+
+#include <atomic>
+#include <set>
+
+#include "api/scoped_refptr.h"
+#include "api/video/i420_buffer.h"
+#include "common_video/include/video_frame_buffer_pool.h"
+
+namespace libwebrtc {
+
+// Hands out I420 buffers that are no longer referenced by any frame, so a
+// buffer is never written while an encoder may still read it. When every
+// buffer of the pool is in flight a new one is allocated outside the pool.
+// Must be used on one thread, the stats can be read from any thread.
+class I420BufferPool {
+ public:
+  explicit I420BufferPool(size_t max_buffers);
+  ~I420BufferPool();
+
+  rtc::scoped_refptr<webrtc::I420Buffer> CreateBuffer(int width, int height);
+
+  // Whether |buffer| belongs to the pool, and so keeps its address and
+  // content until it is handed out again at the same resolution.
+  bool IsPooled(const webrtc::I420Buffer* buffer) const {
+    return known_buffers_.count(buffer) > 0;
+  }
+
+  // Buffers reused from the pool, and buffers that had to be allocated.
+  uint64_t hits() const { return hits_; }
+  uint64_t misses() const { return misses_; }
+
+ private:
+  webrtc::VideoFrameBufferPool pool_;
+  // The buffers the pool has handed out at the current resolution.
+  std::set<const webrtc::I420Buffer*> known_buffers_;
+  int width_ = 0;
+  int height_ = 0;
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+};
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_I420_BUFFER_POOL_HXX
@@ -1,7 +1,10 @@
 #include "jpeg_util.h"
 
+// jpeglib.h uses FILE without including stdio.h itself.
 #include <stdio.h>
-#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
 
 extern "C" {
 #if defined(USE_SYSTEM_LIBJPEG)
@@ -14,45 +17,163 @@ extern "C" {
 
 namespace libwebrtc {
 
-std::vector<unsigned char> EncodeRGBToJpeg(const unsigned char* rgb_buf,
-                                           int width,
-                                           int height,
-                                           int color_planes,
-                                           int quality) {
-  std::vector<unsigned char> result;
-  unsigned char* out_buffer = NULL;
-  unsigned long out_size = 0;
-  // Invoking LIBJPEG
+namespace {
+
+// Rows of luma and chroma in one MCU of 4:2:0 data.
+constexpr int kLumaRows = 16;
+constexpr int kChromaRows = 8;
+
+constexpr size_t kInitialOutputSize = 16 * 1024;
+
+// A jpeg_destination_mgr that appends to a std::vector. libjpeg writes into
+// |chunk|, which is appended whenever it is full, so the vector only ever
+// holds encoded bytes.
+struct VectorDestination {
+  struct jpeg_destination_mgr mgr;
+  std::vector<unsigned char>* out;
+  unsigned char chunk[4096];
+};
+
+void InitDestination(j_compress_ptr cinfo) {
+  VectorDestination* dest = reinterpret_cast<VectorDestination*>(cinfo->dest);
+  dest->out->clear();
+  dest->out->reserve(kInitialOutputSize);
+  dest->mgr.next_output_byte = dest->chunk;
+  dest->mgr.free_in_buffer = sizeof(dest->chunk);
+}
+
+boolean EmptyOutputBuffer(j_compress_ptr cinfo) {
+  // Called when the whole chunk is full, |free_in_buffer| is stale.
+  VectorDestination* dest = reinterpret_cast<VectorDestination*>(cinfo->dest);
+  dest->out->insert(dest->out->end(), dest->chunk,
+                    dest->chunk + sizeof(dest->chunk));
+  dest->mgr.next_output_byte = dest->chunk;
+  dest->mgr.free_in_buffer = sizeof(dest->chunk);
+  return TRUE;
+}
+
+void TermDestination(j_compress_ptr cinfo) {
+  VectorDestination* dest = reinterpret_cast<VectorDestination*>(cinfo->dest);
+  dest->out->insert(
+      dest->out->end(), dest->chunk,
+      dest->chunk + sizeof(dest->chunk) - dest->mgr.free_in_buffer);
+}
+
+// Copies |rows| rows of |width| samples into |band|, which is |padded_width|
+// wide. Rows past |height| repeat the last row and samples past |width|
+// repeat the last sample, so the padding of edge MCUs costs no bits.
+void FillBand(const uint8_t* src,
+              int stride,
+              int width,
+              int height,
+              int first_row,
+              int rows,
+              int padded_width,
+              uint8_t* band,
+              JSAMPROW* row_pointers) {
+  for (int i = 0; i < rows; i++) {
+    const uint8_t* src_row =
+        src + static_cast<size_t>(std::min(first_row + i, height - 1)) * stride;
+    uint8_t* dst_row = band + static_cast<size_t>(i) * padded_width;
+    memcpy(dst_row, src_row, width);
+    memset(dst_row + width, src_row[width - 1], padded_width - width);
+    row_pointers[i] = dst_row;
+  }
+}
+
+}  // namespace
+
+struct JpegEncoder::Context {
   struct jpeg_compress_struct cinfo;
   struct jpeg_error_mgr jerr;
-  JSAMPROW row_pointer[1];
-  cinfo.err = jpeg_std_error(&jerr);
-  jpeg_create_compress(&cinfo);
+  VectorDestination dest;
+};
+
+JpegEncoder::JpegEncoder() : context_(new Context()) {
+  context_->cinfo.err = jpeg_std_error(&context_->jerr);
+  jpeg_create_compress(&context_->cinfo);
+  context_->dest.mgr.init_destination = InitDestination;
+  context_->dest.mgr.empty_output_buffer = EmptyOutputBuffer;
+  context_->dest.mgr.term_destination = TermDestination;
+  context_->dest.out = nullptr;
+  context_->cinfo.dest = &context_->dest.mgr;
+}
 
-  jpeg_mem_dest(&cinfo, &out_buffer, &out_size);
+JpegEncoder::~JpegEncoder() {
+  jpeg_destroy_compress(&context_->cinfo);
+}
+
+bool JpegEncoder::EncodeI420(const uint8_t* data_y,
+                             int stride_y,
+                             const uint8_t* data_u,
+                             int stride_u,
+                             const uint8_t* data_v,
+                             int stride_v,
+                             int width,
+                             int height,
+                             int quality,
+                             std::vector<unsigned char>* out) {
+  if (width <= 0 || height <= 0) {
+    return false;
+  }
+
+  struct jpeg_compress_struct& cinfo = context_->cinfo;
+  context_->dest.out = out;
 
   cinfo.image_width = width;
   cinfo.image_height = height;
-  cinfo.input_components = color_planes;
-  cinfo.in_color_space = JCS_EXT_BGR;
+  cinfo.input_components = 3;
+  cinfo.in_color_space = JCS_YCbCr;
   jpeg_set_defaults(&cinfo);
   jpeg_set_quality(&cinfo, quality, TRUE);
+  // The planes are already subsampled 2x2.
+  cinfo.raw_data_in = TRUE;
+#if JPEG_LIB_VERSION >= 70
+  cinfo.do_fancy_downsampling = FALSE;
+#endif
+  cinfo.comp_info[0].h_samp_factor = 2;
+  cinfo.comp_info[0].v_samp_factor = 2;
+  cinfo.comp_info[1].h_samp_factor = 1;
+  cinfo.comp_info[1].v_samp_factor = 1;
+  cinfo.comp_info[2].h_samp_factor = 1;
+  cinfo.comp_info[2].v_samp_factor = 1;
+
+  // Raw data is read in whole MCUs, 16x16 luma and 8x8 chroma samples.
+  const int padded_width = (width + kLumaRows - 1) & ~(kLumaRows - 1);
+  const int chroma_width = (width + 1) / 2;
+  const int chroma_height = (height + 1) / 2;
+  const int padded_chroma_width = padded_width / 2;
+  const size_t luma_size = static_cast<size_t>(padded_width) * kLumaRows;
+  const size_t chroma_size =
+      static_cast<size_t>(padded_chroma_width) * kChromaRows;
+  band_.resize(luma_size + 2 * chroma_size);
+  uint8_t* band_y = band_.data();
+  uint8_t* band_u = band_y + luma_size;
+  uint8_t* band_v = band_u + chroma_size;
+
+  JSAMPROW rows_y[kLumaRows];
+  JSAMPROW rows_u[kChromaRows];
+  JSAMPROW rows_v[kChromaRows];
+  JSAMPARRAY planes[3] = {rows_y, rows_u, rows_v};
 
   jpeg_start_compress(&cinfo, TRUE);
-  int row_stride = width * color_planes;
   while (cinfo.next_scanline < cinfo.image_height) {
-    row_pointer[0] =
-        &((unsigned char*)rgb_buf)[cinfo.next_scanline * row_stride];
-    jpeg_write_scanlines(&cinfo, row_pointer, 1);
+    const int row = static_cast<int>(cinfo.next_scanline);
+    FillBand(data_y, stride_y, width, height, row, kLumaRows, padded_width,
+             band_y, rows_y);
+    FillBand(data_u, stride_u, chroma_width, chroma_height, row / 2,
+             kChromaRows, padded_chroma_width, band_u, rows_u);
+    FillBand(data_v, stride_v, chroma_width, chroma_height, row / 2,
+             kChromaRows, padded_chroma_width, band_v, rows_v);
+    if (jpeg_write_raw_data(&cinfo, planes, kLumaRows) == 0) {
+      jpeg_abort_compress(&cinfo);
+      context_->dest.out = nullptr;
+      return false;
+    }
   }
-
   jpeg_finish_compress(&cinfo);
-  jpeg_destroy_compress(&cinfo);
-  result.resize(out_size);
-  std::copy(out_buffer, out_buffer + out_size, result.begin());
-  free(out_buffer);
-
-  return result;
+  context_->dest.out = nullptr;
+  return true;
 }
 
 }  // namespace libwebrtc
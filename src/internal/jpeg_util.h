@@ -2,15 +2,39 @@
 #define INTERNAL_JPEG_UTIL_HXX
 
 #include <inttypes.h>
+#include <memory>
 #include <vector>
 
 namespace libwebrtc {
-// Encodes the given RGB data into a JPEG image.
-std::vector<unsigned char> EncodeRGBToJpeg(const unsigned char* data,
-                                           int width,
-                                           int height,
-                                           int color_planes,
-                                           int quality);
+
+// Encodes images with one libjpeg compressor, which keeps its allocations
+// between images. The image is appended to the caller's vector in chunks,
+// so the vector keeps its capacity for the next image and is never filled
+// ahead of the encoder. Not thread safe.
+class JpegEncoder {
+ public:
+  JpegEncoder();
+  ~JpegEncoder();
+
+  // Encodes I420 planes into |out|. The planes are handed to libjpeg as
+  // they are, without a conversion to RGB and back.
+  bool EncodeI420(const uint8_t* data_y,
+                  int stride_y,
+                  const uint8_t* data_u,
+                  int stride_u,
+                  const uint8_t* data_v,
+                  int stride_v,
+                  int width,
+                  int height,
+                  int quality,
+                  std::vector<unsigned char>* out);
+
+ private:
+  struct Context;
+  std::unique_ptr<Context> context_;
+  // One band of MCU rows, padded to whole MCUs, for EncodeI420().
+  std::vector<uint8_t> band_;
+};
 }  // namespace libwebrtc
 
 #endif  // INTERNAL_JPEG_UTIL_HXX
@@ -0,0 +1,143 @@
+#include "src/internal/key_ratchet_cache.h"
+
+#include "rtc_base/logging.h"
+
+namespace libwebrtc {
+
+namespace {
+
+constexpr unsigned int kDerivedKeyBits = 128;
+
+}  // namespace
+
+KeyRatchetCache::KeyRatchetCache(int window_size,
+                                 std::vector<uint8_t> ratchet_salt)
+    : window_size_(window_size), ratchet_salt_(std::move(ratchet_salt)) {}
+
+KeyRatchetCache::~KeyRatchetCache() {}
+
+int KeyRatchetCache::Ratchet(
+    const std::string& participant_id,
+    int key_index,
+    webrtc::ParticipantKeyHandler* handler,
+    rtc::FunctionView<bool(const EVP_AEAD_CTX*)> try_key) {
+  if (window_size_ <= 0 || !handler) {
+    return 0;
+  }
+
+  std::shared_ptr<Participant> participant = GetParticipant(participant_id);
+  webrtc::MutexLock lock(&participant->mutex);
+  std::shared_ptr<webrtc::ParticipantKeyHandler::KeySet> base =
+      handler->GetKeySet(key_index);
+  if (!base) {
+    return 0;
+  }
+
+  Ring& ring = SyncRing(participant.get(), key_index, base);
+  for (size_t i = 0; i < static_cast<size_t>(window_size_); i++) {
+    if (i == ring.steps.size()) {
+      std::unique_ptr<Step> step = Derive(
+          handler, i == 0 ? base->material : ring.steps.back()->material);
+      if (!step) {
+        return 0;
+      }
+      ring.steps.push_back(std::move(step));
+    }
+
+    if (try_key(ring.steps[i]->ctx.get())) {
+      handler->SetKeyFromMaterial(ring.steps[i]->material, key_index);
+      // A handler that failed before reports missing keys until told.
+      handler->SetHasValidKey();
+      ring.base = handler->GetKeySet(key_index);
+      ring.steps.erase(ring.steps.begin(), ring.steps.begin() + i + 1);
+      return static_cast<int>(i + 1);
+    }
+  }
+  return 0;
+}
+
+std::vector<uint8_t> KeyRatchetCache::Advance(
+    const std::string& participant_id,
+    int key_index,
+    webrtc::ParticipantKeyHandler* handler) {
+  std::shared_ptr<Participant> participant = GetParticipant(participant_id);
+  webrtc::MutexLock lock(&participant->mutex);
+  std::shared_ptr<webrtc::ParticipantKeyHandler::KeySet> base =
+      handler->GetKeySet(key_index);
+  if (!base) {
+    return std::vector<uint8_t>();
+  }
+
+  Ring& ring = SyncRing(participant.get(), key_index, base);
+  std::unique_ptr<Step> step;
+  if (!ring.steps.empty()) {
+    step = std::move(ring.steps.front());
+    ring.steps.pop_front();
+  } else {
+    step = Derive(handler, base->material);
+    if (!step) {
+      return std::vector<uint8_t>();
+    }
+  }
+  handler->SetKeyFromMaterial(step->material, key_index);
+  handler->SetHasValidKey();
+  ring.base = handler->GetKeySet(key_index);
+  return step->material;
+}
+
+KeyRatchetCache::Ring& KeyRatchetCache::SyncRing(
+    Participant* participant,
+    int key_index,
+    std::shared_ptr<webrtc::ParticipantKeyHandler::KeySet> base) {
+  Ring& ring = participant->rings[key_index];
+  if (ring.base != base) {
+    // Set or ratcheted elsewhere. A key ratcheted once from the cached base
+    // is the first step, so keep the rest of the ring in that case.
+    if (!ring.steps.empty() && ring.steps.front()->material == base->material) {
+      ring.steps.pop_front();
+    } else {
+      ring.steps.clear();
+    }
+    ring.base = base;
+  }
+  return ring;
+}
+
+void KeyRatchetCache::Invalidate(const std::string& participant_id) {
+  webrtc::MutexLock lock(&mutex_);
+  participants_.erase(participant_id);
+}
+
+std::shared_ptr<KeyRatchetCache::Participant> KeyRatchetCache::GetParticipant(
+    const std::string& participant_id) {
+  webrtc::MutexLock lock(&mutex_);
+  std::shared_ptr<Participant>& participant = participants_[participant_id];
+  if (!participant) {
+    participant = std::make_shared<Participant>();
+  }
+  return participant;
+}
+
+std::unique_ptr<KeyRatchetCache::Step> KeyRatchetCache::Derive(
+    webrtc::ParticipantKeyHandler* handler,
+    const std::vector<uint8_t>& material) const {
+  std::unique_ptr<Step> step(new Step());
+  step->material = handler->RatchetKeyMaterial(material);
+  step->key_set =
+      handler->DeriveKeys(step->material, ratchet_salt_, kDerivedKeyBits);
+  if (!step->key_set) {
+    return nullptr;
+  }
+
+  const std::vector<uint8_t>& key = step->key_set->encryption_key;
+  const EVP_AEAD* aead = key.size() == 32 ? EVP_aead_aes_256_gcm()
+                                          : EVP_aead_aes_128_gcm();
+  if (!EVP_AEAD_CTX_init(step->ctx.get(), aead, key.data(), key.size(),
+                         EVP_AEAD_DEFAULT_TAG_LENGTH, nullptr)) {
+    RTC_LOG(LS_WARNING) << __FUNCTION__ << ": EVP_AEAD_CTX_init failed";
+    return nullptr;
+  }
+  return step;
+}
+
+}  // namespace libwebrtc
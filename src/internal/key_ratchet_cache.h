@@ -0,0 +1,88 @@
+#ifndef INTERNAL_KEY_RATCHET_CACHE_HXX
+#define INTERNAL_KEY_RATCHET_CACHE_HXX
+
+#include <openssl/aead.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "api/crypto/frame_crypto_transformer.h"
+#include "api/function_view.h"
+#include "rtc_base/synchronization/mutex.h"
+
+namespace libwebrtc {
+
+// Keys ratcheted ahead of the current key of each participant and key index,
+// with their AEAD contexts ready. A receiver that fails to decrypt walks this
+// ring instead of deriving the same keys again for every frame. Steps are
+// derived on first use, up to the ratchet window size, and the steps past a
+// matching key are kept for the next ratchet.
+class KeyRatchetCache {
+ public:
+  KeyRatchetCache(int window_size, std::vector<uint8_t> ratchet_salt);
+  ~KeyRatchetCache();
+
+  // Tries the keys ratcheted from the current key set of |key_index| in
+  // order. When |try_key| accepts one, |handler| is moved to it and the
+  // number of ratchet steps taken is returned; returns 0 if none matched.
+  int Ratchet(const std::string& participant_id,
+              int key_index,
+              webrtc::ParticipantKeyHandler* handler,
+              rtc::FunctionView<bool(const EVP_AEAD_CTX*)> try_key);
+
+  // Moves |handler| one ratchet step ahead for |key_index|, using the
+  // cached step if there is one, and returns the new key material. Empty if
+  // there is no key.
+  std::vector<uint8_t> Advance(const std::string& participant_id,
+                               int key_index,
+                               webrtc::ParticipantKeyHandler* handler);
+
+  // Drops the steps of |participant_id|, e.g. after a new key was set.
+  void Invalidate(const std::string& participant_id);
+
+  int window_size() const { return window_size_; }
+
+ private:
+  struct Step {
+    std::vector<uint8_t> material;
+    std::shared_ptr<webrtc::ParticipantKeyHandler::KeySet> key_set;
+    bssl::ScopedEVP_AEAD_CTX ctx;
+  };
+
+  struct Ring {
+    std::shared_ptr<webrtc::ParticipantKeyHandler::KeySet> base;
+    std::deque<std::unique_ptr<Step>> steps;
+  };
+
+  // Derivation is slow, so each participant has its own lock.
+  struct Participant {
+    webrtc::Mutex mutex;
+    std::map<int, Ring> rings RTC_GUARDED_BY(mutex);
+  };
+
+  std::shared_ptr<Participant> GetParticipant(
+      const std::string& participant_id);
+
+  // The ring of |key_index|, realigned to the current key set |base|.
+  static Ring& SyncRing(
+      Participant* participant,
+      int key_index,
+      std::shared_ptr<webrtc::ParticipantKeyHandler::KeySet> base)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(participant->mutex);
+
+  std::unique_ptr<Step> Derive(webrtc::ParticipantKeyHandler* handler,
+                               const std::vector<uint8_t>& material) const;
+
+  const int window_size_;
+  const std::vector<uint8_t> ratchet_salt_;
+  webrtc::Mutex mutex_;
+  std::map<std::string, std::shared_ptr<Participant>> participants_
+      RTC_GUARDED_BY(mutex_);
+};
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_KEY_RATCHET_CACHE_HXX
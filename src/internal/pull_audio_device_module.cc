@@ -0,0 +1,107 @@
+#include "src/internal/pull_audio_device_module.h"
+
+#include <string.h>
+
+namespace libwebrtc {
+
+PullAudioDeviceModule::PullAudioDeviceModule(int sample_rate,
+                                             int channels,
+                                             int tick_ms)
+    : sample_rate_(sample_rate),
+      channels_(static_cast<size_t>(channels)),
+      tick_ms_(tick_ms) {
+  silence_.resize(static_cast<size_t>(sample_rate_ / 100) * channels_);
+}
+
+PullAudioDeviceModule::~PullAudioDeviceModule() {}
+
+int32_t PullAudioDeviceModule::Pull(const int16_t* record, int16_t* playout) {
+  webrtc::MutexLock lock(&mutex_);
+  if (!callback_) {
+    return -1;
+  }
+  const size_t frames = static_cast<size_t>(sample_rate_ / 100);
+  const size_t samples = frames * channels_;
+  const size_t bytes_per_frame = channels_ * sizeof(int16_t);
+  // The audio pipeline works in 10 ms chunks.
+  for (int ms = 0; ms < tick_ms_; ms += 10) {
+    if (recording_) {
+      uint32_t new_mic_level = 0;
+      callback_->RecordedDataIsAvailable(
+          record ? record : silence_.data(), frames, bytes_per_frame,
+          channels_, sample_rate_, 0, 0, 0, false, new_mic_level);
+    }
+    if (playout) {
+      if (playing_) {
+        size_t samples_out = 0;
+        int64_t elapsed_time_ms = 0;
+        int64_t ntp_time_ms = 0;
+        callback_->NeedMorePlayData(frames, bytes_per_frame, channels_,
+                                    sample_rate_, playout, samples_out,
+                                    &elapsed_time_ms, &ntp_time_ms);
+      } else {
+        memset(playout, 0, samples * sizeof(int16_t));
+      }
+      playout += samples;
+    }
+    if (record) {
+      record += samples;
+    }
+  }
+  return 0;
+}
+
+int32_t PullAudioDeviceModule::RegisterAudioCallback(
+    webrtc::AudioTransport* callback) {
+  webrtc::MutexLock lock(&mutex_);
+  callback_ = callback;
+  return 0;
+}
+
+int32_t PullAudioDeviceModule::InitPlayout() {
+  playout_initialized_ = true;
+  return 0;
+}
+
+bool PullAudioDeviceModule::PlayoutIsInitialized() const {
+  return playout_initialized_;
+}
+
+int32_t PullAudioDeviceModule::StartPlayout() {
+  playing_ = true;
+  return 0;
+}
+
+int32_t PullAudioDeviceModule::StopPlayout() {
+  playing_ = false;
+  return 0;
+}
+
+bool PullAudioDeviceModule::Playing() const {
+  return playing_;
+}
+
+int32_t PullAudioDeviceModule::InitRecording() {
+  recording_initialized_ = true;
+  return 0;
+}
+
+bool PullAudioDeviceModule::RecordingIsInitialized() const {
+  return recording_initialized_;
+}
+
+int32_t PullAudioDeviceModule::StartRecording() {
+  recording_ = true;
+  return 0;
+}
+
+int32_t PullAudioDeviceModule::StopRecording() {
+  recording_ = false;
+  return 0;
+}
+
+bool PullAudioDeviceModule::Recording() const {
+  return recording_;
+}
+
+}  // namespace libwebrtc
@@ -0,0 +1,57 @@
+#ifndef INTERNAL_PULL_AUDIO_DEVICE_MODULE_HXX
+#define INTERNAL_PULL_AUDIO_DEVICE_MODULE_HXX
+
+#include <atomic>
+#include <vector>
+
+#include "modules/audio_device/include/audio_device.h"
+#include "modules/audio_device/include/audio_device_default.h"
+#include "rtc_base/synchronization/mutex.h"
+
+namespace libwebrtc {
+
+// An audio device module without a thread or hardware of its own. Each
+// Pull() call records and plays out |tick_ms| of audio, so the caller sets
+// the pace, e.g. faster than real time in tests.
+class PullAudioDeviceModule
+    : public webrtc::webrtc_impl::AudioDeviceModuleDefault<
+          webrtc::AudioDeviceModule> {
+ public:
+  PullAudioDeviceModule(int sample_rate, int channels, int tick_ms);
+  ~PullAudioDeviceModule() override;
+
+  // Sends |record|, or silence if null, as the microphone input and fills
+  // |playout| with the mixed remote audio, if not null. Both hold |tick_ms|
+  // of interleaved 16 bit audio. Returns -1 if nothing is registered.
+  int32_t Pull(const int16_t* record, int16_t* playout);
+
+  // webrtc::AudioDeviceModule
+  int32_t RegisterAudioCallback(webrtc::AudioTransport* callback) override;
+  int32_t InitPlayout() override;
+  bool PlayoutIsInitialized() const override;
+  int32_t StartPlayout() override;
+  int32_t StopPlayout() override;
+  bool Playing() const override;
+  int32_t InitRecording() override;
+  bool RecordingIsInitialized() const override;
+  int32_t StartRecording() override;
+  int32_t StopRecording() override;
+  bool Recording() const override;
+
+ private:
+  const int sample_rate_;
+  const size_t channels_;
+  const int tick_ms_;
+  std::atomic<bool> playout_initialized_{false};
+  std::atomic<bool> playing_{false};
+  std::atomic<bool> recording_initialized_{false};
+  std::atomic<bool> recording_{false};
+
+  webrtc::Mutex mutex_;
+  webrtc::AudioTransport* callback_ RTC_GUARDED_BY(mutex_) = nullptr;
+  std::vector<int16_t> silence_ RTC_GUARDED_BY(mutex_);
+};
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_PULL_AUDIO_DEVICE_MODULE_HXX
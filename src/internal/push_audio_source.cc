@@ -0,0 +1,132 @@
+#include "src/internal/push_audio_source.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <set>
+
+#include "api/make_ref_counted.h"
+#include "rtc_base/logging.h"
+
+namespace libwebrtc {
+
+namespace {
+
+// The sources alive, which the audio level monitor tells apart from the
+// microphone sources of the factory without RTTI.
+webrtc::Mutex g_sources_mutex;
+std::set<const webrtc::AudioSourceInterface*>* g_sources = nullptr;
+
+}  // namespace
+
+// static
+rtc::scoped_refptr<PushAudioSource> PushAudioSource::Create() {
+  return rtc::make_ref_counted<PushAudioSource>();
+}
+
+// static
+bool PushAudioSource::IsPushAudioSource(
+    const webrtc::AudioSourceInterface* source) {
+  webrtc::MutexLock lock(&g_sources_mutex);
+  return g_sources && g_sources->count(source) > 0;
+}
+
+PushAudioSource::PushAudioSource() {
+  webrtc::MutexLock lock(&g_sources_mutex);
+  if (!g_sources) {
+    g_sources = new std::set<const webrtc::AudioSourceInterface*>();
+  }
+  g_sources->insert(this);
+}
+
+PushAudioSource::~PushAudioSource() {
+  webrtc::MutexLock lock(&g_sources_mutex);
+  g_sources->erase(this);
+}
+
+void PushAudioSource::AddSink(webrtc::AudioTrackSinkInterface* sink) {
+  webrtc::MutexLock lock(&mutex_);
+  if (std::find(sinks_.begin(), sinks_.end(), sink) == sinks_.end()) {
+    sinks_.push_back(sink);
+  }
+}
+
+void PushAudioSource::RemoveSink(webrtc::AudioTrackSinkInterface* sink) {
+  webrtc::MutexLock lock(&mutex_);
+  sinks_.erase(std::remove(sinks_.begin(), sinks_.end(), sink), sinks_.end());
+}
+
+void PushAudioSource::OnData(const int16_t* audio_data,
+                             int sample_rate,
+                             size_t number_of_channels,
+                             size_t number_of_frames) {
+  if (!audio_data || sample_rate <= 0 || sample_rate % 100 != 0 ||
+      number_of_channels == 0) {
+    RTC_LOG(LS_ERROR) << "PushAudioSource: unsupported audio, "
+                      << sample_rate << " Hz, " << number_of_channels
+                      << " channels";
+    return;
+  }
+
+  webrtc::MutexLock lock(&mutex_);
+  const size_t chunk_frames = static_cast<size_t>(sample_rate / 100);
+  if (sample_rate != sample_rate_ || number_of_channels != channels_) {
+    // A leftover in the old format cannot be joined with the new audio.
+    sample_rate_ = sample_rate;
+    channels_ = number_of_channels;
+    pending_.resize(chunk_frames * number_of_channels);
+    pending_frames_ = 0;
+    resampler_.InitializeIfNeeded(sample_rate, kOutputSampleRate,
+                                  number_of_channels);
+    resampled_.resize(kOutputSampleRate / 100 * number_of_channels);
+  }
+
+  const int16_t* data = audio_data;
+  size_t frames = number_of_frames;
+  if (pending_frames_ > 0) {
+    size_t count = std::min(frames, chunk_frames - pending_frames_);
+    memcpy(&pending_[pending_frames_ * channels_], data,
+           count * channels_ * sizeof(int16_t));
+    pending_frames_ += count;
+    data += count * channels_;
+    frames -= count;
+    if (pending_frames_ < chunk_frames) {
+      return;
+    }
+    DeliverChunk(pending_.data());
+    pending_frames_ = 0;
+  }
+  // Whole chunks are sent from the caller's buffer without a copy.
+  while (frames >= chunk_frames) {
+    DeliverChunk(data);
+    data += chunk_frames * channels_;
+    frames -= chunk_frames;
+  }
+  if (frames > 0) {
+    memcpy(pending_.data(), data, frames * channels_ * sizeof(int16_t));
+    pending_frames_ = frames;
+  }
+}
+
+void PushAudioSource::DeliverChunk(const int16_t* chunk) {
+  if (sinks_.empty()) {
+    return;
+  }
+  const size_t chunk_samples = static_cast<size_t>(sample_rate_ / 100) *
+                               channels_;
+  const int16_t* output = chunk;
+  if (sample_rate_ != kOutputSampleRate) {
+    if (resampler_.Resample(chunk, chunk_samples, resampled_.data(),
+                            resampled_.size()) < 0) {
+      RTC_LOG(LS_ERROR) << "PushAudioSource: resampling failed";
+      return;
+    }
+    output = resampled_.data();
+  }
+  for (webrtc::AudioTrackSinkInterface* sink : sinks_) {
+    sink->OnData(output, 16, kOutputSampleRate, channels_,
+                 kOutputSampleRate / 100);
+  }
+}
+
+}  // namespace libwebrtc
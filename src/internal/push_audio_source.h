@@ -0,0 +1,66 @@
+#ifndef INTERNAL_PUSH_AUDIO_SOURCE_HXX
+#define INTERNAL_PUSH_AUDIO_SOURCE_HXX
+
+#include <vector>
+
+#include "api/media_stream_interface.h"
+#include "api/notifier.h"
+#include "common_audio/resampler/include/push_resampler.h"
+#include "rtc_base/synchronization/mutex.h"
+
+namespace libwebrtc {
+
+// An audio source fed by the application instead of the audio device
+// module. Pushed audio is cut into 10 ms chunks, resampled to
+// kOutputSampleRate and handed to the sinks of the source, which are the
+// send streams of its tracks. Buffers are reused across calls.
+class PushAudioSource
+    : public webrtc::Notifier<webrtc::AudioSourceInterface> {
+ public:
+  // The rate the send streams get, the native rate of Opus.
+  static const int kOutputSampleRate = 48000;
+
+  static rtc::scoped_refptr<PushAudioSource> Create();
+
+  // Whether |source| is a live PushAudioSource, for code that only sees
+  // the tracks. Thread safe.
+  static bool IsPushAudioSource(const webrtc::AudioSourceInterface* source);
+
+  // webrtc::MediaSourceInterface
+  SourceState state() const override { return kLive; }
+  bool remote() const override { return false; }
+
+  // webrtc::AudioSourceInterface
+  const cricket::AudioOptions options() const override {
+    return cricket::AudioOptions();
+  }
+  void AddSink(webrtc::AudioTrackSinkInterface* sink) override;
+  void RemoveSink(webrtc::AudioTrackSinkInterface* sink) override;
+
+  void OnData(const int16_t* audio_data,
+              int sample_rate,
+              size_t number_of_channels,
+              size_t number_of_frames);
+
+ protected:
+  PushAudioSource();
+  ~PushAudioSource() override;
+
+ private:
+  // Resamples one 10 ms chunk and sends it to the sinks.
+  void DeliverChunk(const int16_t* chunk) RTC_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  webrtc::Mutex mutex_;
+  std::vector<webrtc::AudioTrackSinkInterface*> sinks_ RTC_GUARDED_BY(mutex_);
+  int sample_rate_ RTC_GUARDED_BY(mutex_) = 0;
+  size_t channels_ RTC_GUARDED_BY(mutex_) = 0;
+  // The start of a 10 ms chunk left over from the previous call.
+  std::vector<int16_t> pending_ RTC_GUARDED_BY(mutex_);
+  size_t pending_frames_ RTC_GUARDED_BY(mutex_) = 0;
+  webrtc::PushResampler<int16_t> resampler_ RTC_GUARDED_BY(mutex_);
+  std::vector<int16_t> resampled_ RTC_GUARDED_BY(mutex_);
+};
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_PUSH_AUDIO_SOURCE_HXX
@@ -48,13 +48,30 @@ bool VcmCapturer::Init(size_t width,
 
   vcm_->RegisterCaptureDataCallback(this);
 
-  device_info->GetCapability(vcm_->CurrentDeviceName(), 0, capability_);
-
   capability_.width = static_cast<int32_t>(width);
   capability_.height = static_cast<int32_t>(height);
   capability_.maxFPS = static_cast<int32_t>(target_fps);
   capability_.videoType = VideoType::kI420;
 
+  // Ask for a mode the camera produces natively, so that the capture module
+  // does not rescale to the requested size. The best match compares width
+  // and height separately, then the frame rate, then prefers raw formats
+  // close to I420. V4L2 picks the pixel format on its own and only takes the
+  // size and frame rate of the capability.
+  VideoCaptureCapability native;
+  if (device_info->GetBestMatchedCapability(vcm_->CurrentDeviceName(),
+                                            capability_, native) >= 0) {
+    // The module paces the camera to the requested rate where it can.
+    if (native.maxFPS <= 0 || native.maxFPS > capability_.maxFPS) {
+      native.maxFPS = capability_.maxFPS;
+    }
+    capability_ = native;
+  }
+  RTC_LOG(LS_INFO) << "VcmCapturer: capturing " << capability_.width << "x"
+                   << capability_.height << "@" << capability_.maxFPS
+                   << ", video type "
+                   << static_cast<int>(capability_.videoType);
+
   return true;
 }
 
@@ -14,70 +14,267 @@
 
 #include "api/scoped_refptr.h"
 #include "api/video/i420_buffer.h"
+#include "api/video/nv12_buffer.h"
 #include "api/video/video_frame_buffer.h"
 #include "api/video/video_rotation.h"
+#include "media/base/video_common.h"
 
 namespace webrtc {
 namespace internal {
+// Frames of one size queued in the encoders plus the one being scaled.
+const int kScaledBufferPoolSize = 8;
+
+// Frames after which the buffers of a size no sink asks for are released.
+const int64_t kScaledBufferPoolIdleFrames = 90;
+
 VideoCapturer::VideoCapturer() = default;
 VideoCapturer::~VideoCapturer() = default;
 
 void VideoCapturer::OnFrame(const VideoFrame& frame) {
-  int cropped_width = 0;
-  int cropped_height = 0;
-  int out_width = 0;
-  int out_height = 0;
-
-  if (!video_adapter_.AdaptFrameResolution(
-          frame.width(), frame.height(), frame.timestamp_us() * 1000,
-          &cropped_width, &cropped_height, &out_width, &out_height)) {
-    // Drop frame in order to respect frame rate constraint.
-    return;
+  MutexLock lock(&mutex_);
+  outputs_.clear();
+  for (SinkEntry& entry : sinks_) {
+    int cropped_width = 0;
+    int cropped_height = 0;
+    int out_width = 0;
+    int out_height = 0;
+    entry.output = -1;
+    entry.width = 0;
+    entry.height = 0;
+    if (!entry.adapter->AdaptFrameResolution(
+            frame.width(), frame.height(), frame.timestamp_us() * 1000,
+            &cropped_width, &cropped_height, &out_width, &out_height)) {
+      // Drop frame in order to respect frame rate constraint.
+      continue;
+    }
+    entry.width = out_width;
+    entry.height = out_height;
+    if (entry.wants.black_frames) {
+      // Sends a black buffer of the adapted size, nothing to scale.
+      continue;
+    }
+    // Sinks that asked for the same size share one buffer.
+    for (size_t i = 0; i < outputs_.size(); ++i) {
+      const Output& output = outputs_[i];
+      if (output.cropped_width == cropped_width &&
+          output.cropped_height == cropped_height &&
+          output.width == out_width && output.height == out_height) {
+        entry.output = static_cast<int>(i);
+        break;
+      }
+    }
+    if (entry.output < 0) {
+      entry.output = static_cast<int>(outputs_.size());
+      outputs_.push_back(
+          {cropped_width, cropped_height, out_width, out_height, nullptr});
+    }
   }
 
-  if (out_height != frame.height() || out_width != frame.width()) {
-    // Video adapter has requested a down-scale. Allocate a new buffer and
-    // return scaled version.
-    rtc::scoped_refptr<I420Buffer> scaled_buffer =
-        I420Buffer::Create(out_width, out_height);
-    scaled_buffer->ScaleFrom(*frame.video_frame_buffer()->ToI420());
-    broadcaster_.OnFrame(VideoFrame::Builder()
-                             .set_video_frame_buffer(scaled_buffer)
-                             .set_rotation(kVideoRotation_0)
-                             .set_timestamp_us(frame.timestamp_us())
-                             .set_id(frame.id())
-                             .build());
-  } else {
-    // No adaptations needed, just return the frame as is.
-    broadcaster_.OnFrame(frame);
+  const int64_t frame_count = ++frame_count_;
+  ProduceOutputs(frame);
+  buffer_pools_.erase(
+      std::remove_if(buffer_pools_.begin(), buffer_pools_.end(),
+                     [frame_count](const ScaledBufferPool& pool) {
+                       return frame_count - pool.last_used_frame >
+                              kScaledBufferPoolIdleFrames;
+                     }),
+      buffer_pools_.end());
+
+  for (const SinkEntry& entry : sinks_) {
+    if (entry.output < 0) {
+      if (entry.wants.black_frames && entry.width > 0) {
+        entry.sink->OnFrame(
+            VideoFrame::Builder()
+                .set_video_frame_buffer(
+                    GetBlackFrameBuffer(entry.width, entry.height))
+                .set_rotation(frame.rotation())
+                .set_timestamp_us(frame.timestamp_us())
+                .set_timestamp_rtp(frame.timestamp())
+                .set_id(frame.id())
+                .build());
+      }
+      continue;
+    }
+    const Output& output = outputs_[entry.output];
+    if (output.buffer == frame.video_frame_buffer()) {
+      // No adaptations needed, just return the frame as is.
+      entry.sink->OnFrame(frame);
+      continue;
+    }
+    entry.sink->OnFrame(VideoFrame::Builder()
+                            .set_video_frame_buffer(output.buffer)
+                            .set_rotation(frame.rotation())
+                            .set_timestamp_us(frame.timestamp_us())
+                            .set_timestamp_rtp(frame.timestamp())
+                            .set_id(frame.id())
+                            .build());
+  }
+  // Release the buffers so that the pool can reuse them.
+  outputs_.clear();
+}
+
+void VideoCapturer::ProduceOutputs(const VideoFrame& frame) {
+  order_.clear();
+  for (size_t i = 0; i < outputs_.size(); ++i) {
+    order_.push_back(i);
+  }
+  const std::vector<Output>& outputs = outputs_;
+  std::sort(order_.begin(), order_.end(), [&outputs](size_t a, size_t b) {
+    return outputs[a].width * outputs[a].height >
+           outputs[b].width * outputs[b].height;
+  });
+
+  rtc::scoped_refptr<VideoFrameBuffer> source = frame.video_frame_buffer();
+  for (size_t i = 0; i < order_.size(); ++i) {
+    Output& output = outputs_[order_[i]];
+    if (output.width == frame.width() && output.height == frame.height()) {
+      output.buffer = source;
+      continue;
+    }
+    // Scale from the smallest output already produced that covers this one
+    // and shows the same crop, else from the captured frame.
+    const Output* parent = nullptr;
+    for (size_t j = 0; j < i; ++j) {
+      const Output& candidate = outputs_[order_[j]];
+      if (candidate.cropped_width == output.cropped_width &&
+          candidate.cropped_height == output.cropped_height &&
+          candidate.width >= output.width &&
+          candidate.height >= output.height) {
+        parent = &candidate;
+      }
+    }
+    if (parent) {
+      output.buffer =
+          CropAndScale(parent->buffer, 0, 0, parent->width, parent->height,
+                       output.width, output.height);
+    } else {
+      output.buffer = CropAndScale(
+          source, (frame.width() - output.cropped_width) / 2,
+          (frame.height() - output.cropped_height) / 2, output.cropped_width,
+          output.cropped_height, output.width, output.height);
+    }
+  }
+}
+
+rtc::scoped_refptr<VideoFrameBuffer> VideoCapturer::CropAndScale(
+    const rtc::scoped_refptr<VideoFrameBuffer>& source,
+    int offset_x,
+    int offset_y,
+    int cropped_width,
+    int cropped_height,
+    int width,
+    int height) {
+  VideoFrameBufferPool* pool = nullptr;
+  for (ScaledBufferPool& candidate : buffer_pools_) {
+    if (candidate.width == width && candidate.height == height) {
+      pool = candidate.pool.get();
+      candidate.last_used_frame = frame_count_;
+      break;
+    }
+  }
+  if (!pool) {
+    // A pool drops its buffers when asked for another size, so every size
+    // has its own.
+    buffer_pools_.push_back(
+        {width, height, frame_count_,
+         std::make_unique<VideoFrameBufferPool>(/*zero_initialize=*/false,
+                                                kScaledBufferPoolSize)});
+    pool = buffer_pools_.back().pool.get();
+  }
+  // Keep the format of the captured frame when encoders can take it as is.
+  if (source->type() == VideoFrameBuffer::Type::kNV12) {
+    rtc::scoped_refptr<NV12Buffer> nv12 =
+        pool->CreateNV12Buffer(width, height);
+    if (!nv12) {
+      // Every pooled buffer is still held by a sink.
+      nv12 = NV12Buffer::Create(width, height);
+    }
+    nv12->CropAndScaleFrom(*source->GetNV12(), offset_x, offset_y,
+                           cropped_width, cropped_height);
+    return nv12;
   }
+  rtc::scoped_refptr<I420Buffer> i420 =
+      pool->CreateI420Buffer(width, height);
+  if (!i420) {
+    i420 = I420Buffer::Create(width, height);
+  }
+  i420->CropAndScaleFrom(*source->ToI420(), offset_x, offset_y, cropped_width,
+                         cropped_height);
+  return i420;
+}
+
+rtc::scoped_refptr<VideoFrameBuffer> VideoCapturer::GetBlackFrameBuffer(
+    int width,
+    int height) {
+  if (!black_frame_buffer_ || black_frame_buffer_->width() != width ||
+      black_frame_buffer_->height() != height) {
+    black_frame_buffer_ = I420Buffer::Create(width, height);
+    I420Buffer::SetBlack(black_frame_buffer_.get());
+  }
+  return black_frame_buffer_;
 }
 
 rtc::VideoSinkWants VideoCapturer::GetSinkWants() {
-  return broadcaster_.wants();
+  MutexLock lock(&mutex_);
+  rtc::VideoSinkWants wants;
+  if (sinks_.empty()) {
+    return wants;
+  }
+  // Each sink is adapted on its own, the source has to satisfy all of them.
+  wants.max_pixel_count = 0;
+  wants.max_framerate_fps = 0;
+  wants.is_active = false;
+  for (const SinkEntry& entry : sinks_) {
+    wants.rotation_applied |= entry.wants.rotation_applied;
+    wants.is_active |= entry.wants.is_active;
+    // Every sink gets a size that its own alignment divides.
+    wants.resolution_alignment = cricket::LeastCommonMultiple(
+        wants.resolution_alignment, entry.wants.resolution_alignment);
+    wants.max_pixel_count =
+        std::max(wants.max_pixel_count, entry.wants.max_pixel_count);
+    wants.max_framerate_fps =
+        std::max(wants.max_framerate_fps, entry.wants.max_framerate_fps);
+    wants.resolutions.insert(wants.resolutions.end(),
+                             entry.wants.resolutions.begin(),
+                             entry.wants.resolutions.end());
+  }
+  return wants;
 }
 
 void VideoCapturer::AddOrUpdateSink(rtc::VideoSinkInterface<VideoFrame>* sink,
                                     const rtc::VideoSinkWants& wants) {
-  broadcaster_.AddOrUpdateSink(sink, wants);
-  UpdateVideoAdapter();
+  MutexLock lock(&mutex_);
+  auto it = std::find_if(
+      sinks_.begin(), sinks_.end(),
+      [sink](const SinkEntry& entry) { return entry.sink == sink; });
+  if (it == sinks_.end()) {
+    sinks_.push_back(
+        {sink, wants, std::make_unique<cricket::VideoAdapter>(), -1, 0, 0});
+    it = sinks_.end() - 1;
+  }
+  it->wants = wants;
+  ConfigureAdapter(it->adapter.get(), wants);
 }
 
 void VideoCapturer::RemoveSink(rtc::VideoSinkInterface<VideoFrame>* sink) {
-  broadcaster_.RemoveSink(sink);
-  UpdateVideoAdapter();
+  MutexLock lock(&mutex_);
+  sinks_.erase(std::remove_if(sinks_.begin(), sinks_.end(),
+                              [sink](const SinkEntry& entry) {
+                                return entry.sink == sink;
+                              }),
+               sinks_.end());
 }
 
-void VideoCapturer::UpdateVideoAdapter() {
-  rtc::VideoSinkWants wants = broadcaster_.wants();
-
+// static
+void VideoCapturer::ConfigureAdapter(cricket::VideoAdapter* adapter,
+                                     const rtc::VideoSinkWants& wants) {
   if (0 < wants.resolutions.size()) {
     auto size = wants.resolutions.at(0);
     std::pair<int, int> target_aspect_ratiot(size.width, size.height);
-    video_adapter_.OnOutputFormatRequest(
+    adapter->OnOutputFormatRequest(
         target_aspect_ratiot, wants.max_pixel_count, wants.max_framerate_fps);
   } else {
-    video_adapter_.OnSinkWants(wants);
+    adapter->OnSinkWants(wants);
   }
 }
 
@@ -13,14 +13,17 @@
 #include <stddef.h>
 
 #include <memory>
+#include <vector>
 
 #include "api/video/video_frame.h"
 #include "api/video/video_source_interface.h"
+#include "common_video/include/video_frame_buffer_pool.h"
 #include "media/base/video_adapter.h"
 #include "media/base/video_broadcaster.h"
 #include "modules/video_capture/video_capture.h"
 #include "modules/video_capture/video_capture_factory.h"
 #include "pc/video_track_source.h"
+#include "rtc_base/synchronization/mutex.h"
 
 namespace webrtc {
 namespace internal {
@@ -41,14 +44,70 @@ class VideoCapturer : public rtc::VideoSourceInterface<VideoFrame> {
   void RemoveSink(rtc::VideoSinkInterface<VideoFrame>* sink) override;
 
  protected:
+  // Adapts |frame| for every sink. Each distinct size the sinks asked for
+  // is produced once and shared by them, smaller sizes are scaled from the
+  // closest larger one instead of the captured frame.
   void OnFrame(const VideoFrame& frame);
+  // The wants of the most demanding sink.
   rtc::VideoSinkWants GetSinkWants();
 
  private:
-  void UpdateVideoAdapter();
+  struct SinkEntry {
+    rtc::VideoSinkInterface<VideoFrame>* sink;
+    rtc::VideoSinkWants wants;
+    std::unique_ptr<cricket::VideoAdapter> adapter;
+    // Index into |outputs_| for the current frame, -1 to drop it or to
+    // send a black frame.
+    int output;
+    // The adapted size of the current frame.
+    int width;
+    int height;
+  };
 
-  rtc::VideoBroadcaster broadcaster_;
-  cricket::VideoAdapter video_adapter_;
+  // One adapted size of the current frame.
+  struct Output {
+    int cropped_width;
+    int cropped_height;
+    int width;
+    int height;
+    rtc::scoped_refptr<VideoFrameBuffer> buffer;
+  };
+
+  // Buffers for one downscaled size, reused once every sink released them.
+  struct ScaledBufferPool {
+    int width;
+    int height;
+    int64_t last_used_frame;
+    std::unique_ptr<VideoFrameBufferPool> pool;
+  };
+
+  static void ConfigureAdapter(cricket::VideoAdapter* adapter,
+                               const rtc::VideoSinkWants& wants);
+  rtc::scoped_refptr<VideoFrameBuffer> CropAndScale(
+      const rtc::scoped_refptr<VideoFrameBuffer>& source,
+      int offset_x,
+      int offset_y,
+      int cropped_width,
+      int cropped_height,
+      int width,
+      int height) RTC_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Scales the outputs, largest first.
+  void ProduceOutputs(const VideoFrame& frame)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // A black buffer for sinks that asked for black frames, kept while its
+  // size does not change. It is never written after it is filled.
+  rtc::scoped_refptr<VideoFrameBuffer> GetBlackFrameBuffer(int width,
+                                                           int height)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  Mutex mutex_;
+  std::vector<SinkEntry> sinks_ RTC_GUARDED_BY(mutex_);
+  // Kept across frames so that adapting does not allocate.
+  std::vector<Output> outputs_ RTC_GUARDED_BY(mutex_);
+  std::vector<size_t> order_ RTC_GUARDED_BY(mutex_);
+  std::vector<ScaledBufferPool> buffer_pools_ RTC_GUARDED_BY(mutex_);
+  int64_t frame_count_ RTC_GUARDED_BY(mutex_) = 0;
+  rtc::scoped_refptr<I420Buffer> black_frame_buffer_ RTC_GUARDED_BY(mutex_);
 };
 }  // namespace internal
 }  // namespace webrtc
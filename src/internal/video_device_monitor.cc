@@ -0,0 +1,100 @@
+#include "src/internal/video_device_monitor.h"
+
+#if defined(WEBRTC_LINUX)
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "rtc_base/logging.h"
+
+namespace libwebrtc {
+
+VideoDeviceMonitor::VideoDeviceMonitor(std::function<void()> on_change)
+    : on_change_(std::move(on_change)) {}
+
+VideoDeviceMonitor::~VideoDeviceMonitor() {
+#if defined(WEBRTC_LINUX)
+  if (!thread_.empty()) {
+    uint64_t value = 1;
+    if (write(wake_fd_, &value, sizeof(value)) < 0) {
+      RTC_LOG_ERRNO(LS_ERROR) << "VideoDeviceMonitor: failed to wake up";
+    }
+    thread_.Finalize();
+  }
+  if (inotify_fd_ >= 0) {
+    close(inotify_fd_);
+  }
+  if (wake_fd_ >= 0) {
+    close(wake_fd_);
+  }
+#endif
+}
+
+bool VideoDeviceMonitor::Start() {
+#if defined(WEBRTC_LINUX)
+  inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotify_fd_ < 0) {
+    RTC_LOG_ERRNO(LS_WARNING) << "VideoDeviceMonitor: inotify_init1 failed";
+    return false;
+  }
+  // udev creates the node and then sets its permissions, the device can
+  // only be opened after the IN_ATTRIB.
+  if (inotify_add_watch(inotify_fd_, "/dev",
+                        IN_CREATE | IN_DELETE | IN_ATTRIB) < 0) {
+    RTC_LOG_ERRNO(LS_WARNING) << "VideoDeviceMonitor: cannot watch /dev";
+    return false;
+  }
+  wake_fd_ = eventfd(0, EFD_CLOEXEC);
+  if (wake_fd_ < 0) {
+    RTC_LOG_ERRNO(LS_WARNING) << "VideoDeviceMonitor: eventfd failed";
+    return false;
+  }
+  thread_ = rtc::PlatformThread::SpawnJoinable([this] { Run(); },
+                                               "VideoDeviceMonitor");
+  return true;
+#else
+  return false;
+#endif
+}
+
+void VideoDeviceMonitor::Run() {
+#if defined(WEBRTC_LINUX)
+  // Large enough for a burst of events with file names.
+  alignas(struct inotify_event) char buffer[4096];
+  struct pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+  while (true) {
+    if (poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      RTC_LOG_ERRNO(LS_ERROR) << "VideoDeviceMonitor: poll failed";
+      return;
+    }
+    if (fds[1].revents) {
+      return;
+    }
+    bool changed = false;
+    ssize_t length;
+    while ((length = read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+      for (char* p = buffer; p < buffer + length;) {
+        const struct inotify_event* event =
+            reinterpret_cast<const struct inotify_event*>(p);
+        if (event->len > 0 && strncmp(event->name, "video", 5) == 0) {
+          changed = true;
+        }
+        p += sizeof(struct inotify_event) + event->len;
+      }
+    }
+    // Report one change for a burst of events.
+    if (changed) {
+      on_change_();
+    }
+  }
+#endif
+}
+
+}  // namespace libwebrtc
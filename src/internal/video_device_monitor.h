@@ -0,0 +1,33 @@
+#ifndef INTERNAL_VIDEO_DEVICE_MONITOR_HXX
+#define INTERNAL_VIDEO_DEVICE_MONITOR_HXX
+
+#include <functional>
+
+#include "rtc_base/platform_thread.h"
+
+namespace libwebrtc {
+
+// Reports video devices being plugged in or removed. On Linux this watches
+// /dev/video* with inotify on a thread of its own; elsewhere Start() fails
+// and the caller has to poll the device list.
+class VideoDeviceMonitor {
+ public:
+  // |on_change| runs on the monitor thread.
+  explicit VideoDeviceMonitor(std::function<void()> on_change);
+  ~VideoDeviceMonitor();
+
+  bool Start();
+
+ private:
+  void Run();
+
+  std::function<void()> on_change_;
+  int inotify_fd_ = -1;
+  // Wakes the monitor thread up to stop it.
+  int wake_fd_ = -1;
+  rtc::PlatformThread thread_;
+};
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_VIDEO_DEVICE_MONITOR_HXX
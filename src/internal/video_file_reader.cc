@@ -0,0 +1,203 @@
+#include "src/internal/video_file_reader.h"
+
+#if defined(WEBRTC_POSIX)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+
+#include "rtc_base/logging.h"
+#include "rtc_base/synchronization/mutex.h"
+
+namespace libwebrtc {
+
+namespace {
+
+webrtc::Mutex g_readers_mutex;
+// Keyed by path, format and size.
+std::map<std::string, std::weak_ptr<VideoFileReader>>* g_readers = nullptr;
+
+size_t FrameSize(int width, int height) {
+  // I420 and NV12 both have two chroma planes worth of half size samples.
+  size_t chroma = static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2);
+  return static_cast<size_t>(width) * height + 2 * chroma;
+}
+
+}  // namespace
+
+std::shared_ptr<VideoFileReader> VideoFileReader::Open(const std::string& path,
+                                                       Format format,
+                                                       int width,
+                                                       int height) {
+  if (format != kY4M && (width <= 0 || height <= 0)) {
+    RTC_LOG(LS_ERROR) << "VideoFileReader: raw files need a frame size";
+    return nullptr;
+  }
+  std::string key = path + "|" + std::to_string(format);
+  if (format != kY4M) {
+    key += "|" + std::to_string(width) + "x" + std::to_string(height);
+  }
+
+  webrtc::MutexLock lock(&g_readers_mutex);
+  if (!g_readers) {
+    g_readers = new std::map<std::string, std::weak_ptr<VideoFileReader>>();
+  }
+  std::shared_ptr<VideoFileReader> reader = (*g_readers)[key].lock();
+  if (reader) {
+    return reader;
+  }
+  reader = std::make_shared<VideoFileReader>();
+  if (!reader->Map(path)) {
+    g_readers->erase(key);
+    return nullptr;
+  }
+  bool parsed = false;
+  if (format == kY4M) {
+    parsed = reader->ParseY4M();
+  } else {
+    reader->width_ = width;
+    reader->height_ = height;
+    reader->pixel_format_ = format;
+    parsed = reader->IndexRaw();
+  }
+  if (!parsed || reader->frame_offsets_.empty()) {
+    RTC_LOG(LS_ERROR) << "VideoFileReader: no frames in " << path;
+    g_readers->erase(key);
+    return nullptr;
+  }
+  (*g_readers)[key] = reader;
+  return reader;
+}
+
+VideoFileReader::VideoFileReader() {}
+
+VideoFileReader::~VideoFileReader() {
+#if defined(WEBRTC_POSIX)
+  if (data_) {
+    munmap(const_cast<uint8_t*>(data_), size_);
+  }
+#endif
+}
+
+bool VideoFileReader::Map(const std::string& path) {
+#if defined(WEBRTC_POSIX)
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    RTC_LOG_ERRNO(LS_ERROR) << "VideoFileReader: cannot open " << path;
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    RTC_LOG(LS_ERROR) << "VideoFileReader: " << path << " is empty";
+    close(fd);
+    return false;
+  }
+  void* mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                       MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    RTC_LOG_ERRNO(LS_ERROR) << "VideoFileReader: mmap failed";
+    return false;
+  }
+  // Frames are read front to back.
+  madvise(mapping, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+  data_ = static_cast<const uint8_t*>(mapping);
+  size_ = static_cast<size_t>(st.st_size);
+  return true;
+#else
+  RTC_LOG(LS_ERROR) << "VideoFileReader: mapping files is not supported here";
+  return false;
+#endif
+}
+
+bool VideoFileReader::ParseY4M() {
+  const char* begin = reinterpret_cast<const char*>(data_);
+  const char* end = begin + size_;
+  const char* eol = static_cast<const char*>(memchr(begin, '\n', size_));
+  if (!eol || size_ < 10 || memcmp(begin, "YUV4MPEG2 ", 10) != 0) {
+    RTC_LOG(LS_ERROR) << "VideoFileReader: not a Y4M file";
+    return false;
+  }
+  pixel_format_ = kI420;
+  // Parameters are space separated, each tagged by its first letter.
+  for (const char* p = begin + 9; p < eol;) {
+    while (p < eol && *p == ' ') {
+      ++p;
+    }
+    const char* token_end = p;
+    while (token_end < eol && *token_end != ' ') {
+      ++token_end;
+    }
+    if (token_end == p) {
+      break;
+    }
+    std::string value(p + 1, token_end);
+    switch (*p) {
+      case 'W':
+        width_ = atoi(value.c_str());
+        break;
+      case 'H':
+        height_ = atoi(value.c_str());
+        break;
+      case 'F': {
+        int num = 0;
+        int den = 0;
+        if (sscanf(value.c_str(), "%d:%d", &num, &den) == 2 && den > 0) {
+          fps_ = static_cast<double>(num) / den;
+        }
+        break;
+      }
+      case 'C':
+        // Only the 8-bit 4:2:0 variants, which differ in chroma siting.
+        // 420p10, 420p12 and the like store 16-bit samples.
+        if (value != "420" && value != "420jpeg" && value != "420mpeg2" &&
+            value != "420paldv") {
+          RTC_LOG(LS_ERROR) << "VideoFileReader: unsupported colorspace C"
+                            << value;
+          return false;
+        }
+        break;
+      default:
+        break;
+    }
+    p = token_end;
+  }
+  if (width_ <= 0 || height_ <= 0) {
+    return false;
+  }
+
+  const size_t frame_size = FrameSize(width_, height_);
+  const char* p = eol + 1;
+  while (p < end) {
+    // Each frame starts with a "FRAME" line that may carry parameters.
+    const char* frame_eol =
+        static_cast<const char*>(memchr(p, '\n', end - p));
+    if (!frame_eol || frame_eol - p < 5 || memcmp(p, "FRAME", 5) != 0) {
+      break;
+    }
+    size_t offset = frame_eol + 1 - begin;
+    if (size_ - offset < frame_size) {
+      // A truncated last frame is dropped.
+      break;
+    }
+    frame_offsets_.push_back(offset);
+    p = begin + offset + frame_size;
+  }
+  return true;
+}
+
+bool VideoFileReader::IndexRaw() {
+  const size_t frame_size = FrameSize(width_, height_);
+  for (size_t offset = 0; size_ - offset >= frame_size; offset += frame_size) {
+    frame_offsets_.push_back(offset);
+  }
+  return true;
+}
+
+}  // namespace libwebrtc
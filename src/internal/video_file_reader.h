@@ -0,0 +1,60 @@
+#ifndef INTERNAL_VIDEO_FILE_READER_HXX
+#define INTERNAL_VIDEO_FILE_READER_HXX
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace libwebrtc {
+
+// A read only mapping of a Y4M or raw I420/NV12 file. Every capturer that
+// replays the same file shares one mapping, so the frames are in memory
+// once however many publishers send them.
+class VideoFileReader {
+ public:
+  enum Format { kY4M, kI420, kNV12 };
+
+  // Returns the mapping of |path|, mapping the file if nobody uses it yet.
+  // |width| and |height| are only used for raw files, Y4M files carry them
+  // in their header. Returns null if the file cannot be read.
+  static std::shared_ptr<VideoFileReader> Open(const std::string& path,
+                                               Format format,
+                                               int width,
+                                               int height);
+
+  VideoFileReader();
+  ~VideoFileReader();
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+  // kI420 or kNV12, Y4M files hold I420.
+  Format pixel_format() const { return pixel_format_; }
+  // The frame rate of a Y4M file, 0 if the file does not tell.
+  double fps() const { return fps_; }
+  size_t frame_count() const { return frame_offsets_.size(); }
+
+  // The pixels of frame |index|, tightly packed.
+  const uint8_t* frame(size_t index) const {
+    return data_ + frame_offsets_[index];
+  }
+
+ private:
+  bool Map(const std::string& path);
+  bool ParseY4M();
+  bool IndexRaw();
+
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  int width_ = 0;
+  int height_ = 0;
+  Format pixel_format_ = kI420;
+  double fps_ = 0;
+  std::vector<size_t> frame_offsets_;
+};
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_VIDEO_FILE_READER_HXX
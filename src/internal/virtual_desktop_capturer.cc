@@ -0,0 +1,54 @@
+#include "src/internal/virtual_desktop_capturer.h"
+
+#include "rtc_base/checks.h"
+
+namespace libwebrtc {
+
+namespace {
+
+// A frame that reads the framebuffer in place, and keeps it alive.
+class VirtualDesktopFrame : public webrtc::DesktopFrame {
+ public:
+  explicit VirtualDesktopFrame(scoped_refptr<RTCVirtualDesktopImpl> desktop)
+      : webrtc::DesktopFrame(
+            webrtc::DesktopSize(desktop->width(), desktop->height()),
+            desktop->stride(),
+            const_cast<uint8_t*>(desktop->data()),
+            nullptr),
+        desktop_(desktop) {}
+
+ private:
+  scoped_refptr<RTCVirtualDesktopImpl> desktop_;
+};
+
+}  // namespace
+
+VirtualDesktopCapturer::VirtualDesktopCapturer(
+    scoped_refptr<RTCVirtualDesktopImpl> desktop)
+    : desktop_(desktop) {}
+
+VirtualDesktopCapturer::~VirtualDesktopCapturer() {}
+
+void VirtualDesktopCapturer::Start(Callback* callback) {
+  callback_ = callback;
+}
+
+void VirtualDesktopCapturer::CaptureFrame() {
+  RTC_DCHECK(callback_);
+  std::unique_ptr<webrtc::DesktopFrame> frame(
+      new VirtualDesktopFrame(desktop_));
+  desktop_->TakeDirtyRegion(frame->mutable_updated_region());
+  callback_->OnCaptureResult(Result::SUCCESS, std::move(frame));
+}
+
+bool VirtualDesktopCapturer::GetSourceList(SourceList* sources) {
+  sources->push_back(
+      {webrtc::kFullDesktopScreenId, desktop_->name().std_string()});
+  return true;
+}
+
+bool VirtualDesktopCapturer::SelectSource(SourceId id) {
+  return id == webrtc::kFullDesktopScreenId;
+}
+
+}  // namespace libwebrtc
@@ -0,0 +1,31 @@
+#ifndef INTERNAL_VIRTUAL_DESKTOP_CAPTURER_HXX
+#define INTERNAL_VIRTUAL_DESKTOP_CAPTURER_HXX
+
+#include "modules/desktop_capture/desktop_capturer.h"
+#include "src/rtc_virtual_desktop_impl.h"
+
+namespace libwebrtc {
+
+// Captures the framebuffer of an RTCVirtualDesktop. Frames point into the
+// framebuffer, without a copy, and carry the rects marked dirty since the
+// previous capture as their updated region.
+class VirtualDesktopCapturer : public webrtc::DesktopCapturer {
+ public:
+  explicit VirtualDesktopCapturer(
+      scoped_refptr<RTCVirtualDesktopImpl> desktop);
+  ~VirtualDesktopCapturer() override;
+
+  // webrtc::DesktopCapturer
+  void Start(Callback* callback) override;
+  void CaptureFrame() override;
+  bool GetSourceList(SourceList* sources) override;
+  bool SelectSource(SourceId id) override;
+
+ private:
+  scoped_refptr<RTCVirtualDesktopImpl> desktop_;
+  Callback* callback_ = nullptr;
+};
+
+}  // namespace libwebrtc
+
+#endif  // INTERNAL_VIRTUAL_DESKTOP_CAPTURER_HXX
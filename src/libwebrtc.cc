@@ -39,4 +39,14 @@ LibWebRTC::CreateRTCPeerConnectionFactory() {
   return rtc_peerconnection_factory;
 }
 
+scoped_refptr<RTCPeerConnectionFactory>
+LibWebRTC::CreateRTCPeerConnectionFactory(
+    const RTCAudioDeviceOptions& audio_options) {
+  scoped_refptr<RTCPeerConnectionFactory> rtc_peerconnection_factory =
+      scoped_refptr<RTCPeerConnectionFactory>(
+          new RefCountedObject<RTCPeerConnectionFactoryImpl>(audio_options));
+  rtc_peerconnection_factory->Initialize();
+  return rtc_peerconnection_factory;
+}
+
 }  // namespace libwebrtc
@@ -5,8 +5,11 @@ namespace libwebrtc {
 
 AudioDeviceImpl::AudioDeviceImpl(
     rtc::scoped_refptr<webrtc::AudioDeviceModule> audio_device_module,
+    rtc::scoped_refptr<PullAudioDeviceModule> pull_audio_device_module,
     rtc::Thread* worker_thread)
-    : audio_device_module_(audio_device_module), worker_thread_(worker_thread) {
+    : audio_device_module_(audio_device_module),
+      pull_audio_device_module_(pull_audio_device_module),
+      worker_thread_(worker_thread) {
   audio_device_module_->SetAudioDeviceSink(this);
 }
 
@@ -105,6 +108,14 @@ int32_t AudioDeviceImpl::OnDeviceChange(OnDeviceChangeCallback listener) {
   return 0;
 }
 
+int32_t AudioDeviceImpl::PullAudio(const int16_t* record, int16_t* playout) {
+  // Runs on the calling thread, which paces the module.
+  if (!pull_audio_device_module_) {
+    return -1;
+  }
+  return pull_audio_device_module_->Pull(record, playout);
+}
+
 void AudioDeviceImpl::OnDevicesUpdated() {
   if (listener_)
     listener_();
@@ -6,12 +6,14 @@
 #include "rtc_audio_device.h"
 #include "rtc_base/ref_count.h"
 #include "rtc_base/thread.h"
+#include "src/internal/pull_audio_device_module.h"
 
 namespace libwebrtc {
 class AudioDeviceImpl : public RTCAudioDevice, public webrtc::AudioDeviceSink {
  public:
   AudioDeviceImpl(
       rtc::scoped_refptr<webrtc::AudioDeviceModule> audio_device_module,
+      rtc::scoped_refptr<PullAudioDeviceModule> pull_audio_device_module,
       rtc::Thread* worker_thread);
 
   virtual ~AudioDeviceImpl();
@@ -43,11 +45,14 @@ class AudioDeviceImpl : public RTCAudioDevice, public webrtc::AudioDeviceSink {
 
   int32_t OnDeviceChange(OnDeviceChangeCallback listener) override;
 
+  int32_t PullAudio(const int16_t* record, int16_t* playout) override;
+
  protected:
   void OnDevicesUpdated() override;
 
  private:
   rtc::scoped_refptr<webrtc::AudioDeviceModule> audio_device_module_;
+  rtc::scoped_refptr<PullAudioDeviceModule> pull_audio_device_module_;
   rtc::Thread* worker_thread_ = nullptr;
   OnDeviceChangeCallback listener_ = nullptr;
 };
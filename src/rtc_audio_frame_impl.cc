@@ -0,0 +1,62 @@
+#include "rtc_audio_frame_impl.h"
+
+#include "rtc_base/logging.h"
+#include "src/internal/audio_mix_util.h"
+
+namespace libwebrtc {
+
+scoped_refptr<RTCAudioFrame> RTCAudioFrame::Create() {
+  return scoped_refptr<RTCAudioFrame>(new RefCountedObject<RTCAudioFrameImpl>());
+}
+
+scoped_refptr<RTCAudioFrame> RTCAudioFrame::Create(int id,
+                                                   uint32_t timestamp,
+                                                   const int16_t* data,
+                                                   size_t samples_per_channel,
+                                                   int sample_rate_hz,
+                                                   size_t num_channels) {
+  scoped_refptr<RTCAudioFrame> frame = Create();
+  frame->UpdateFrame(id, timestamp, data, samples_per_channel, sample_rate_hz,
+                     num_channels);
+  return frame;
+}
+
+RTCAudioFrameImpl::RTCAudioFrameImpl() {}
+
+RTCAudioFrameImpl::~RTCAudioFrameImpl() {}
+
+void RTCAudioFrameImpl::UpdateFrame(int id,
+                                    uint32_t timestamp,
+                                    const int16_t* data,
+                                    size_t samples_per_channel,
+                                    int sample_rate_hz,
+                                    size_t num_channels) {
+  id_ = id;
+  frame_.UpdateFrame(timestamp, data, samples_per_channel, sample_rate_hz,
+                     webrtc::AudioFrame::kNormalSpeech,
+                     webrtc::AudioFrame::kVadUnknown, num_channels);
+}
+
+void RTCAudioFrameImpl::CopyFrom(const RTCAudioFrame& src) {
+  UpdateFrame(src.id(), src.timestamp(), src.data(), src.samples_per_channel(),
+              src.sample_rate_hz(), src.num_channels());
+}
+
+void RTCAudioFrameImpl::Add(const RTCAudioFrame& frame_to_add) {
+  if (frame_to_add.samples_per_channel() != samples_per_channel() ||
+      frame_to_add.num_channels() != num_channels()) {
+    RTC_LOG(LS_WARNING) << "RTCAudioFrame: cannot add frames of different "
+                           "formats";
+    return;
+  }
+  const RTCAudioFrameImpl& impl =
+      static_cast<const RTCAudioFrameImpl&>(frame_to_add);
+  if (impl.muted()) {
+    return;
+  }
+  // mutable_data() zeroes a muted frame first.
+  AddSaturated(frame_.mutable_data(), impl.data(),
+               samples_per_channel() * num_channels());
+}
+
+}  // namespace libwebrtc
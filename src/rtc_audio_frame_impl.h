@@ -0,0 +1,53 @@
+#ifndef LIB_WEBRTC_AUDIO_FRAME_IMPL_HXX
+#define LIB_WEBRTC_AUDIO_FRAME_IMPL_HXX
+
+#include "rtc_audio_frame.h"
+
+#include "api/audio/audio_frame.h"
+
+namespace libwebrtc {
+
+class RTCAudioFrameImpl : public RTCAudioFrame {
+ public:
+  RTCAudioFrameImpl();
+  virtual ~RTCAudioFrameImpl();
+
+  void UpdateFrame(int id,
+                   uint32_t timestamp,
+                   const int16_t* data,
+                   size_t samples_per_channel,
+                   int sample_rate_hz,
+                   size_t num_channels) override;
+
+  void CopyFrom(const RTCAudioFrame& src) override;
+
+  void Add(const RTCAudioFrame& frame_to_add) override;
+
+  void Mute() override { frame_.Mute(); }
+
+  const int16_t* data() const override { return frame_.data(); }
+
+  int16_t* mutable_data() override { return frame_.mutable_data(); }
+
+  size_t samples_per_channel() const override {
+    return frame_.samples_per_channel();
+  }
+
+  int sample_rate_hz() const override { return frame_.sample_rate_hz(); }
+
+  size_t num_channels() const override { return frame_.num_channels(); }
+
+  uint32_t timestamp() const override { return frame_.timestamp(); }
+
+  int id() const override { return id_; }
+
+  bool muted() const { return frame_.muted(); }
+
+ private:
+  webrtc::AudioFrame frame_;
+  int id_ = -1;
+};
+
+}  // namespace libwebrtc
+
+#endif  // LIB_WEBRTC_AUDIO_FRAME_IMPL_HXX
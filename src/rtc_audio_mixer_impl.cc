@@ -0,0 +1,218 @@
+#include "rtc_audio_mixer_impl.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "rtc_base/logging.h"
+#include "src/internal/audio_mix_util.h"
+
+namespace libwebrtc {
+
+// Weight of the current frame in the smoothed level of a participant.
+const double kLevelAttack = 0.3;
+
+scoped_refptr<RTCAudioMixer> RTCAudioMixer::Create(int sample_rate,
+                                                   size_t num_channels,
+                                                   size_t max_speakers) {
+  if (sample_rate <= 0 || sample_rate % 100 != 0 || num_channels == 0 ||
+      num_channels > 2 || max_speakers == 0) {
+    RTC_LOG(LS_ERROR) << "RTCAudioMixer: unsupported format " << sample_rate
+                      << " Hz, " << num_channels << " channels";
+    return nullptr;
+  }
+  return scoped_refptr<RTCAudioMixer>(new RefCountedObject<RTCAudioMixerImpl>(
+      sample_rate, num_channels, max_speakers));
+}
+
+RTCAudioMixerImpl::Input::Input(size_t samples_per_channel,
+                                size_t num_channels)
+    : samples_per_channel_(samples_per_channel),
+      num_channels_(num_channels),
+      buffer_(samples_per_channel * num_channels) {}
+
+void RTCAudioMixerImpl::Input::OnData(const void* audio_data,
+                                      int bits_per_sample,
+                                      int sample_rate,
+                                      size_t number_of_channels,
+                                      size_t number_of_frames) {
+  // The track resamples to the rate of the mixer.
+  if (bits_per_sample != 16 || number_of_frames != samples_per_channel_) {
+    return;
+  }
+  const int16_t* src = static_cast<const int16_t*>(audio_data);
+  webrtc::MutexLock lock(&mutex_);
+  if (number_of_channels == num_channels_) {
+    memcpy(buffer_.data(), src, buffer_.size() * sizeof(int16_t));
+  } else if (num_channels_ == 2) {
+    // Into a stereo mix: mono is doubled, more channels keep the first two.
+    const size_t right = number_of_channels > 1 ? 1 : 0;
+    for (size_t i = 0; i < number_of_frames; ++i) {
+      const int16_t* frame = src + i * number_of_channels;
+      buffer_[2 * i] = frame[0];
+      buffer_[2 * i + 1] = frame[right];
+    }
+  } else {
+    // Down to mono, from the first two channels.
+    for (size_t i = 0; i < number_of_frames; ++i) {
+      const int16_t* frame = src + i * number_of_channels;
+      buffer_[i] = static_cast<int16_t>((frame[0] + frame[1]) / 2);
+    }
+  }
+  fresh_ = true;
+}
+
+bool RTCAudioMixerImpl::Input::TakeAudio(std::vector<int16_t>* samples) {
+  webrtc::MutexLock lock(&mutex_);
+  if (!fresh_) {
+    return false;
+  }
+  samples->swap(buffer_);
+  fresh_ = false;
+  return true;
+}
+
+RTCAudioMixerImpl::RTCAudioMixerImpl(int sample_rate,
+                                     size_t num_channels,
+                                     size_t max_speakers)
+    : sample_rate_(sample_rate),
+      num_channels_(num_channels),
+      samples_per_channel_(static_cast<size_t>(sample_rate / 100)),
+      max_speakers_(max_speakers),
+      accumulator_(samples_per_channel_ * num_channels_),
+      mix_(samples_per_channel_ * num_channels_) {}
+
+RTCAudioMixerImpl::~RTCAudioMixerImpl() {
+  webrtc::MutexLock lock(&mutex_);
+  for (auto& it : participants_) {
+    if (it.second.track) {
+      it.second.track->RemoveSink(it.second.input.get());
+    }
+  }
+}
+
+RTCAudioMixerImpl::Participant* RTCAudioMixerImpl::CreateParticipant(int id) {
+  if (participants_.find(id) != participants_.end()) {
+    return nullptr;
+  }
+  Participant& participant = participants_[id];
+  participant.input =
+      std::make_unique<Input>(samples_per_channel_, num_channels_);
+  participant.samples.resize(samples_per_channel_ * num_channels_);
+  return &participant;
+}
+
+bool RTCAudioMixerImpl::AddInput(int id, scoped_refptr<RTCAudioTrack> track) {
+  if (!track) {
+    return false;
+  }
+  webrtc::MutexLock lock(&mutex_);
+  Participant* participant = CreateParticipant(id);
+  if (!participant) {
+    return false;
+  }
+  participant->track = track;
+  track->AddSink(participant->input.get(), sample_rate_);
+  return true;
+}
+
+bool RTCAudioMixerImpl::AddInput(int id) {
+  webrtc::MutexLock lock(&mutex_);
+  return CreateParticipant(id) != nullptr;
+}
+
+bool RTCAudioMixerImpl::PushAudio(int id, scoped_refptr<RTCAudioFrame> frame) {
+  if (!frame || frame->sample_rate_hz() != sample_rate_ ||
+      frame->samples_per_channel() != samples_per_channel_ ||
+      frame->num_channels() == 0) {
+    return false;
+  }
+  webrtc::MutexLock lock(&mutex_);
+  auto it = participants_.find(id);
+  if (it == participants_.end() || it->second.track) {
+    return false;
+  }
+  it->second.input->OnData(frame->data(), 16, frame->sample_rate_hz(),
+                           frame->num_channels(),
+                           frame->samples_per_channel());
+  return true;
+}
+
+void RTCAudioMixerImpl::RemoveInput(int id) {
+  webrtc::MutexLock lock(&mutex_);
+  auto it = participants_.find(id);
+  if (it == participants_.end()) {
+    return;
+  }
+  if (it->second.track) {
+    it->second.track->RemoveSink(it->second.input.get());
+  }
+  participants_.erase(it);
+  speakers_.erase(std::remove(speakers_.begin(), speakers_.end(), id),
+                  speakers_.end());
+}
+
+int RTCAudioMixerImpl::Mix() {
+  webrtc::MutexLock lock(&mutex_);
+  const size_t length = samples_per_channel_ * num_channels_;
+
+  ranking_.clear();
+  for (auto& it : participants_) {
+    Participant& participant = it.second;
+    participant.has_audio = participant.input->TakeAudio(&participant.samples);
+    double energy = participant.has_audio
+                        ? static_cast<double>(
+                              Energy(participant.samples.data(), length)) /
+                              length
+                        : 0;
+    participant.level = kLevelAttack * energy +
+                        (1 - kLevelAttack) * participant.level;
+    if (participant.has_audio && participant.level > 0) {
+      ranking_.emplace_back(participant.level, it.first);
+    }
+  }
+
+  // Top-K loudest, only the K are sorted.
+  size_t count = std::min(max_speakers_, ranking_.size());
+  std::partial_sort(ranking_.begin(), ranking_.begin() + count, ranking_.end(),
+                    [](const std::pair<double, int>& a,
+                       const std::pair<double, int>& b) {
+                      return a.first > b.first;
+                    });
+
+  std::fill(accumulator_.begin(), accumulator_.end(), 0);
+  speakers_.clear();
+  for (size_t i = 0; i < count; ++i) {
+    int id = ranking_[i].second;
+    Accumulate(accumulator_.data(), participants_[id].samples.data(), length);
+    speakers_.push_back(id);
+  }
+  SaturateMix(mix_.data(), accumulator_.data(), nullptr, length);
+  timestamp_ += static_cast<uint32_t>(samples_per_channel_);
+  return static_cast<int>(count);
+}
+
+void RTCAudioMixerImpl::GetMix(int id, scoped_refptr<RTCAudioFrame> frame) {
+  if (!frame) {
+    return;
+  }
+  webrtc::MutexLock lock(&mutex_);
+  const size_t length = samples_per_channel_ * num_channels_;
+  frame->UpdateFrame(id, timestamp_, nullptr, samples_per_channel_,
+                     sample_rate_, num_channels_);
+  if (std::find(speakers_.begin(), speakers_.end(), id) == speakers_.end()) {
+    // Not in the mix, hears every selected speaker.
+    memcpy(frame->mutable_data(), mix_.data(), length * sizeof(int16_t));
+    return;
+  }
+  // Takes the participant's own voice out of the wide sum.
+  SaturateMix(frame->mutable_data(), accumulator_.data(),
+              participants_[id].samples.data(), length);
+}
+
+vector<int> RTCAudioMixerImpl::active_speakers() {
+  webrtc::MutexLock lock(&mutex_);
+  return vector<int>(speakers_);
+}
+
+}  // namespace libwebrtc
@@ -0,0 +1,89 @@
+#ifndef LIB_WEBRTC_AUDIO_MIXER_IMPL_HXX
+#define LIB_WEBRTC_AUDIO_MIXER_IMPL_HXX
+
+#include "rtc_audio_mixer.h"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "rtc_base/synchronization/mutex.h"
+
+namespace libwebrtc {
+
+class RTCAudioMixerImpl : public RTCAudioMixer {
+ public:
+  RTCAudioMixerImpl(int sample_rate, size_t num_channels, size_t max_speakers);
+  virtual ~RTCAudioMixerImpl();
+
+  bool AddInput(int id, scoped_refptr<RTCAudioTrack> track) override;
+
+  bool AddInput(int id) override;
+
+  bool PushAudio(int id, scoped_refptr<RTCAudioFrame> frame) override;
+
+  void RemoveInput(int id) override;
+
+  int Mix() override;
+
+  void GetMix(int id, scoped_refptr<RTCAudioFrame> frame) override;
+
+  vector<int> active_speakers() override;
+
+ private:
+  // Receives the audio of one track on the audio thread and keeps the
+  // latest 10 ms for the next Mix().
+  class Input : public RTCAudioTrackSink {
+   public:
+    Input(size_t samples_per_channel, size_t num_channels);
+
+    void OnData(const void* audio_data,
+                int bits_per_sample,
+                int sample_rate,
+                size_t number_of_channels,
+                size_t number_of_frames) override;
+
+    // Copies the audio received since the last call into |samples|.
+    // Returns false if there is none.
+    bool TakeAudio(std::vector<int16_t>* samples);
+
+   private:
+    const size_t samples_per_channel_;
+    const size_t num_channels_;
+    webrtc::Mutex mutex_;
+    std::vector<int16_t> buffer_ RTC_GUARDED_BY(mutex_);
+    bool fresh_ RTC_GUARDED_BY(mutex_) = false;
+  };
+
+  struct Participant {
+    // Null for an input fed with PushAudio().
+    scoped_refptr<RTCAudioTrack> track;
+    std::unique_ptr<Input> input;
+    std::vector<int16_t> samples;
+    bool has_audio = false;
+    // Smoothed energy, so that short pauses do not drop a speaker.
+    double level = 0;
+  };
+
+  Participant* CreateParticipant(int id) RTC_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const int sample_rate_;
+  const size_t num_channels_;
+  const size_t samples_per_channel_;
+  const size_t max_speakers_;
+
+  webrtc::Mutex mutex_;
+  std::map<int, Participant> participants_ RTC_GUARDED_BY(mutex_);
+  // Sum of the selected speakers, kept wide so that a speaker can be taken
+  // out again before saturating.
+  std::vector<int32_t> accumulator_ RTC_GUARDED_BY(mutex_);
+  // Saturated |accumulator_|, the mix for everybody who is not selected.
+  std::vector<int16_t> mix_ RTC_GUARDED_BY(mutex_);
+  std::vector<int> speakers_ RTC_GUARDED_BY(mutex_);
+  std::vector<std::pair<double, int>> ranking_ RTC_GUARDED_BY(mutex_);
+  uint32_t timestamp_ RTC_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace libwebrtc
+
+#endif  // LIB_WEBRTC_AUDIO_MIXER_IMPL_HXX
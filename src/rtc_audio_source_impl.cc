@@ -3,8 +3,9 @@
 namespace libwebrtc {
 
 RTCAudioSourceImpl::RTCAudioSourceImpl(
-    rtc::scoped_refptr<webrtc::AudioSourceInterface> rtc_audio_source)
-    : rtc_audio_source_(rtc_audio_source) {
+    rtc::scoped_refptr<webrtc::AudioSourceInterface> rtc_audio_source,
+    rtc::scoped_refptr<PushAudioSource> push_source)
+    : rtc_audio_source_(rtc_audio_source), push_source_(push_source) {
   RTC_LOG(LS_INFO) << __FUNCTION__ << ": ctor ";
 }
 
@@ -12,4 +13,15 @@ RTCAudioSourceImpl::~RTCAudioSourceImpl() {
   RTC_LOG(LS_INFO) << __FUNCTION__ << ": dtor ";
 }
 
+void RTCAudioSourceImpl::OnData(const int16_t* audio_data,
+                                int sample_rate,
+                                size_t number_of_channels,
+                                size_t number_of_frames) {
+  if (!push_source_) {
+    return;
+  }
+  push_source_->OnData(audio_data, sample_rate, number_of_channels,
+                       number_of_frames);
+}
+
 }  // namespace libwebrtc
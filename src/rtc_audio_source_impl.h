@@ -12,22 +12,36 @@
 #include "pc/media_session.h"
 #include "rtc_base/logging.h"
 #include "rtc_base/synchronization/mutex.h"
+#include "src/internal/push_audio_source.h"
 
 namespace libwebrtc {
 
 class RTCAudioSourceImpl : public RTCAudioSource {
  public:
+  // |push_source| is the same source as |rtc_audio_source| for kCustom
+  // sources, null for microphone sources.
   RTCAudioSourceImpl(
-      rtc::scoped_refptr<webrtc::AudioSourceInterface> rtc_audio_source);
+      rtc::scoped_refptr<webrtc::AudioSourceInterface> rtc_audio_source,
+      rtc::scoped_refptr<PushAudioSource> push_source);
 
   virtual ~RTCAudioSourceImpl();
 
+  SourceType GetSourceType() const override {
+    return push_source_ ? kCustom : kMicrophone;
+  }
+
+  void OnData(const int16_t* audio_data,
+              int sample_rate,
+              size_t number_of_channels,
+              size_t number_of_frames) override;
+
   rtc::scoped_refptr<webrtc::AudioSourceInterface> rtc_audio_source() {
     return rtc_audio_source_;
   }
 
  private:
   rtc::scoped_refptr<webrtc::AudioSourceInterface> rtc_audio_source_;
+  rtc::scoped_refptr<PushAudioSource> push_source_;
 };
 
 }  // namespace libwebrtc
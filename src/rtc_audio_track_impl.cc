@@ -1,7 +1,61 @@
 #include "rtc_audio_track_impl.h"
 
+#include <map>
+#include <memory>
+
 namespace libwebrtc {
 
+namespace {
+
+// The sinks added to one track, through any of its wrappers. The track is
+// kept alive while it has sinks.
+struct TrackSinks {
+  rtc::scoped_refptr<webrtc::AudioTrackInterface> track;
+  std::map<RTCAudioTrackSink*, std::unique_ptr<AudioSinkAdapter>> adapters;
+};
+
+webrtc::Mutex g_sinks_mutex;
+std::map<const webrtc::AudioTrackInterface*, TrackSinks>* g_sinks = nullptr;
+
+}  // namespace
+
+AudioSinkAdapter::AudioSinkAdapter(RTCAudioTrackSink* sink, int sample_rate)
+    : sink_(sink), sample_rate_(sample_rate) {}
+
+AudioSinkAdapter::~AudioSinkAdapter() {}
+
+void AudioSinkAdapter::OnData(const void* audio_data,
+                              int bits_per_sample,
+                              int sample_rate,
+                              size_t number_of_channels,
+                              size_t number_of_frames) {
+  if (sample_rate_ == 0 || sample_rate_ == sample_rate ||
+      bits_per_sample != 16) {
+    // Hand the buffer of the pipeline over as is.
+    sink_->OnData(audio_data, bits_per_sample, sample_rate, number_of_channels,
+                  number_of_frames);
+    return;
+  }
+
+  resampler_.InitializeIfNeeded(sample_rate, sample_rate_, number_of_channels);
+  const size_t out_frames =
+      number_of_frames * static_cast<size_t>(sample_rate_) / sample_rate;
+  // Only grows, the buffer is reused for every chunk.
+  if (resampled_.size() < out_frames * number_of_channels) {
+    resampled_.resize(out_frames * number_of_channels);
+  }
+  int samples = resampler_.Resample(
+      static_cast<const int16_t*>(audio_data),
+      number_of_frames * number_of_channels, resampled_.data(),
+      resampled_.size());
+  if (samples < 0) {
+    return;
+  }
+  sink_->OnData(resampled_.data(), bits_per_sample, sample_rate_,
+                number_of_channels,
+                static_cast<size_t>(samples) / number_of_channels);
+}
+
 AudioTrackImpl::AudioTrackImpl(
     rtc::scoped_refptr<webrtc::AudioTrackInterface> audio_track)
     : rtc_track_(audio_track) {
@@ -18,4 +72,54 @@ void AudioTrackImpl::SetVolume(double volume) {
   rtc_track_->GetSource()->SetVolume(volume);
 }
 
+void AudioTrackImpl::AddSink(RTCAudioTrackSink* sink, int sample_rate) {
+  if (!sink) {
+    return;
+  }
+  webrtc::MutexLock lock(&g_sinks_mutex);
+  if (!g_sinks) {
+    g_sinks = new std::map<const webrtc::AudioTrackInterface*, TrackSinks>();
+  }
+  TrackSinks& sinks = (*g_sinks)[rtc_track_.get()];
+  sinks.track = rtc_track_;
+  auto it = sinks.adapters.find(sink);
+  if (it != sinks.adapters.end()) {
+    // Replaces the adapter to change the rate.
+    rtc_track_->RemoveSink(it->second.get());
+    sinks.adapters.erase(it);
+  }
+  std::unique_ptr<AudioSinkAdapter> adapter =
+      std::make_unique<AudioSinkAdapter>(sink, sample_rate);
+  rtc_track_->AddSink(adapter.get());
+  sinks.adapters[sink] = std::move(adapter);
+}
+
+void AudioTrackImpl::RemoveSink(RTCAudioTrackSink* sink) {
+  // Released outside the lock, the last reference to a remote track is
+  // dropped on the signaling thread.
+  rtc::scoped_refptr<webrtc::AudioTrackInterface> track;
+  {
+    webrtc::MutexLock lock(&g_sinks_mutex);
+    if (!g_sinks) {
+      return;
+    }
+    auto sinks = g_sinks->find(rtc_track_.get());
+    if (sinks == g_sinks->end()) {
+      return;
+    }
+    auto it = sinks->second.adapters.find(sink);
+    if (it == sinks->second.adapters.end()) {
+      return;
+    }
+    // The track holds its sink lock while delivering, the adapter is idle
+    // once it is removed.
+    rtc_track_->RemoveSink(it->second.get());
+    sinks->second.adapters.erase(it);
+    if (sinks->second.adapters.empty()) {
+      track = std::move(sinks->second.track);
+      g_sinks->erase(sinks);
+    }
+  }
+}
+
 }  // namespace libwebrtc
@@ -13,8 +13,36 @@
 #include "rtc_base/logging.h"
 #include "rtc_base/synchronization/mutex.h"
 
+#include <vector>
+
 namespace libwebrtc {
 
+// Forwards the audio of a track to one RTCAudioTrackSink. Registered with
+// the track on its own, so OnData() takes no lock; the resampler state is
+// only touched on the audio thread.
+class AudioSinkAdapter : public webrtc::AudioTrackSinkInterface {
+ public:
+  AudioSinkAdapter(RTCAudioTrackSink* sink, int sample_rate);
+  ~AudioSinkAdapter() override;
+
+  // webrtc::AudioTrackSinkInterface
+  void OnData(const void* audio_data,
+              int bits_per_sample,
+              int sample_rate,
+              size_t number_of_channels,
+              size_t number_of_frames) override;
+
+ private:
+  RTCAudioTrackSink* sink_;
+  // 0 to deliver the audio as decoded.
+  const int sample_rate_;
+  webrtc::PushResampler<int16_t> resampler_;
+  std::vector<int16_t> resampled_;
+};
+
+// Wraps a webrtc audio track. Every call of track() on a sender or
+// receiver, or of GetAudioTracks() on a stream, returns a new wrapper, so
+// the sinks are kept per underlying track rather than per wrapper.
 class AudioTrackImpl : public RTCAudioTrack {
  public:
   AudioTrackImpl(rtc::scoped_refptr<webrtc::AudioTrackInterface> audio_track);
@@ -23,6 +51,10 @@ class AudioTrackImpl : public RTCAudioTrack {
 
   virtual void SetVolume(double volume) override;
 
+  virtual void AddSink(RTCAudioTrackSink* sink, int sample_rate) override;
+
+  virtual void RemoveSink(RTCAudioTrackSink* sink) override;
+
   virtual const string kind() const override { return kind_; }
 
   virtual const string id() const override { return id_; }
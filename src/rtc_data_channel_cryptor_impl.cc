@@ -0,0 +1,370 @@
+#include "rtc_data_channel_cryptor_impl.h"
+
+#include <openssl/rand.h>
+
+#include "rtc_frame_cryptor_impl.h"
+
+#include "rtc_base/checks.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/thread.h"
+
+namespace libwebrtc {
+
+namespace {
+
+constexpr uint8_t kHeaderVersion = 0x10;
+constexpr uint8_t kHeaderVersionMask = 0xf0;
+constexpr uint8_t kHeaderBinary = 0x01;
+constexpr uint8_t kHeaderBatch = 0x02;
+
+// Flags and size of each message in a batch.
+constexpr size_t kBatchEntryHeaderSize = 5;
+
+void WriteUint32(uint8_t* out, uint32_t value) {
+  out[0] = static_cast<uint8_t>(value >> 24);
+  out[1] = static_cast<uint8_t>(value >> 16);
+  out[2] = static_cast<uint8_t>(value >> 8);
+  out[3] = static_cast<uint8_t>(value);
+}
+
+uint32_t ReadUint32(const uint8_t* in) {
+  return (static_cast<uint32_t>(in[0]) << 24) |
+         (static_cast<uint32_t>(in[1]) << 16) |
+         (static_cast<uint32_t>(in[2]) << 8) | static_cast<uint32_t>(in[3]);
+}
+
+// Batch flushes of every cryptor are posted here. Never stopped: a flush
+// task may hold the last reference to its cryptor.
+rtc::Thread* GetFlushThread() {
+  static rtc::Thread* const thread = [] {
+    std::unique_ptr<rtc::Thread> thread = rtc::Thread::Create();
+    thread->SetName("datachannel_cryptor_thread", nullptr);
+    RTC_CHECK(thread->Start()) << "Failed to start thread";
+    return thread.release();
+  }();
+  return thread;
+}
+
+}  // namespace
+
+scoped_refptr<RTCFrameCryptor> FrameCryptorFactory::frameCryptorFromDataChannel(
+    const string participant_id,
+    scoped_refptr<RTCDataChannel> data_channel,
+    Algorithm algorithm,
+    scoped_refptr<KeyProvider> key_provider,
+    const RTCDataChannelCryptorOptions& options) {
+  if (algorithm != Algorithm::kAesGcm) {
+    // The remote side would try to open the messages with its own
+    // algorithm, so none is substituted.
+    RTC_LOG(LS_ERROR) << __FUNCTION__ << ": only AES-GCM is supported";
+    return nullptr;
+  }
+  return new RefCountedObject<RTCDataChannelCryptorImpl>(
+      participant_id, key_provider, data_channel, options);
+}
+
+RTCDataChannelCryptorImpl::RTCDataChannelCryptorImpl(
+    const string participant_id,
+    scoped_refptr<KeyProvider> key_provider,
+    scoped_refptr<RTCDataChannel> data_channel,
+    const RTCDataChannelCryptorOptions& options)
+    : participant_id_(participant_id),
+      data_channel_(static_cast<RTCDataChannelImpl*>(data_channel.get())),
+      cryptor_(rtc::make_ref_counted<DataChannelCryptor>(
+          participant_id, key_provider, data_channel_, options)) {
+  data_channel_->SetTransformer(cryptor_);
+}
+
+RTCDataChannelCryptorImpl::~RTCDataChannelCryptorImpl() {
+  // Messages in flight finish with the channel's reference to the cryptor.
+  data_channel_->SetTransformer(nullptr);
+  cryptor_->Detach();
+}
+
+bool RTCDataChannelCryptorImpl::SetEnabled(bool enabled) {
+  return cryptor_->SetEnabled(enabled);
+}
+
+bool RTCDataChannelCryptorImpl::enabled() const {
+  return cryptor_->enabled();
+}
+
+bool RTCDataChannelCryptorImpl::SetKeyIndex(int index) {
+  return cryptor_->SetKeyIndex(index);
+}
+
+int RTCDataChannelCryptorImpl::key_index() const {
+  return cryptor_->key_index();
+}
+
+void RTCDataChannelCryptorImpl::RegisterRTCFrameCryptorObserver(
+    RTCFrameCryptorObserver* observer) {
+  cryptor_->RegisterObserver(observer);
+}
+
+void RTCDataChannelCryptorImpl::DeRegisterRTCFrameCryptorObserver() {
+  cryptor_->RegisterObserver(nullptr);
+}
+
+DataChannelCryptor::DataChannelCryptor(
+    const string participant_id,
+    scoped_refptr<KeyProvider> key_provider,
+    scoped_refptr<RTCDataChannelImpl> data_channel,
+    const RTCDataChannelCryptorOptions& options)
+    : participant_id_(participant_id),
+      options_(options),
+      key_provider_(key_provider),
+      data_channel_(data_channel),
+      cipher_(participant_id.std_string(),
+              static_cast<DefaultKeyProviderImpl*>(key_provider.get())
+                  ->rtc_key_provider(),
+              static_cast<DefaultKeyProviderImpl*>(key_provider.get())
+                  ->ratchet_cache()) {
+  // The iv is this random prefix followed by a message counter, so that
+  // senders sharing a key do not reuse ivs.
+  RAND_bytes(iv_prefix_, sizeof(iv_prefix_));
+}
+
+void DataChannelCryptor::Detach() {
+  RegisterObserver(nullptr);
+  Flush();
+}
+
+void DataChannelCryptor::RegisterObserver(RTCFrameCryptorObserver* observer) {
+  webrtc::MutexLock lock(&observer_mutex_);
+  observer_ = observer;
+}
+
+bool DataChannelCryptor::SetEnabled(bool enabled) {
+  RTCFrameCryptionState state = kNew;
+  {
+    webrtc::MutexLock lock(&mutex_);
+    if (!enabled) {
+      state = Flush_locked();
+    }
+    enabled_ = enabled;
+  }
+  SetState(state);
+  SendQueued();
+  return true;
+}
+
+bool DataChannelCryptor::enabled() const {
+  webrtc::MutexLock lock(&mutex_);
+  return enabled_;
+}
+
+bool DataChannelCryptor::SetKeyIndex(int index) {
+  RTCFrameCryptionState state = kNew;
+  {
+    webrtc::MutexLock lock(&mutex_);
+    // A pending batch belongs to the previous key.
+    state = Flush_locked();
+    key_index_ = index;
+  }
+  SetState(state);
+  SendQueued();
+  return true;
+}
+
+int DataChannelCryptor::key_index() const {
+  webrtc::MutexLock lock(&mutex_);
+  return key_index_;
+}
+
+void DataChannelCryptor::TransformSend(const uint8_t* data,
+                                       uint32_t size,
+                                       bool binary) {
+  RTCFrameCryptionState state = kNew;
+  bool schedule_flush = false;
+  {
+    webrtc::MutexLock lock(&mutex_);
+    if (!enabled_) {
+      // Queued too, to stay in order with the sealed messages.
+      queued_.emplace_back(rtc::CopyOnWriteBuffer(data, size), binary);
+    } else if (options_.batch_max_bytes > 0 &&
+               size + kBatchEntryHeaderSize < options_.batch_max_bytes) {
+      const size_t offset = batch_.size();
+      batch_.SetSize(offset + kBatchEntryHeaderSize + size);
+      uint8_t* entry = batch_.data() + offset;
+      entry[0] = binary ? kHeaderBinary : 0;
+      WriteUint32(entry + 1, size);
+      memcpy(entry + kBatchEntryHeaderSize, data, size);
+
+      if (batch_.size() >= options_.batch_max_bytes) {
+        state = Flush_locked();
+      } else if (!flush_pending_) {
+        flush_pending_ = schedule_flush = true;
+      }
+    } else {
+      // Keep the order of the messages sent so far.
+      state = Flush_locked();
+      uint8_t header = kHeaderVersion | (binary ? kHeaderBinary : 0);
+      RTCFrameCryptionState sealed =
+          Seal_locked(header, rtc::ArrayView<const uint8_t>(data, size));
+      if (sealed != kNew) {
+        state = sealed;
+      }
+    }
+  }
+
+  if (schedule_flush) {
+    rtc::scoped_refptr<DataChannelCryptor> self(this);
+    GetFlushThread()->PostDelayedTask(
+        [self] { self->Flush(); },
+        webrtc::TimeDelta::Millis(options_.batch_max_delay_ms));
+  }
+  SetState(state);
+  SendQueued();
+}
+
+void DataChannelCryptor::TransformReceived(const webrtc::DataBuffer& buffer) {
+  rtc::ArrayView<const uint8_t> data(buffer.data.cdata(), buffer.data.size());
+  RTCFrameCryptionState state = kOk;
+  bool enabled;
+  {
+    webrtc::MutexLock lock(&mutex_);
+    enabled = enabled_;
+  }
+
+  if (!enabled) {
+    data_channel_->DeliverMessage(buffer.data.data<char>(),
+                                  buffer.data.size(), buffer.binary);
+    return;
+  }
+
+  if (!buffer.binary || data.empty() ||
+      (data[0] & kHeaderVersionMask) != kHeaderVersion) {
+    state = kDecryptionFailed;
+  } else {
+    switch (cipher_.Open(data, 1, &received_)) {
+      case AesGcmCipher::Result::kOk:
+        state = kOk;
+        break;
+      case AesGcmCipher::Result::kKeyRatcheted:
+        state = kKeyRatcheted;
+        break;
+      case AesGcmCipher::Result::kMissingKey:
+        state = kMissingKey;
+        break;
+      case AesGcmCipher::Result::kInvalid:
+      case AesGcmCipher::Result::kFailed:
+        state = kDecryptionFailed;
+        break;
+    }
+  }
+
+  SetState(state);
+  if (state != kOk && state != kKeyRatcheted) {
+    return;
+  }
+  Deliver(rtc::ArrayView<const uint8_t>(received_).subview(1), received_[0]);
+}
+
+void DataChannelCryptor::Flush() {
+  RTCFrameCryptionState state;
+  {
+    webrtc::MutexLock lock(&mutex_);
+    flush_pending_ = false;
+    state = Flush_locked();
+  }
+  SetState(state);
+  SendQueued();
+}
+
+RTCFrameCryptionState DataChannelCryptor::Flush_locked() {
+  if (batch_.empty()) {
+    return kNew;
+  }
+  RTCFrameCryptionState state =
+      Seal_locked(kHeaderVersion | kHeaderBatch, batch_);
+  batch_.Clear();
+  return state;
+}
+
+RTCFrameCryptionState DataChannelCryptor::Seal_locked(
+    uint8_t header,
+    rtc::ArrayView<const uint8_t> payload) {
+  uint8_t iv[AesGcmCipher::kIvSize];
+  memcpy(iv, iv_prefix_, sizeof(iv_prefix_));
+  WriteUint32(iv + sizeof(iv_prefix_), send_count_++);
+
+  AesGcmCipher::Result result =
+      cipher_.Seal(key_index_, rtc::ArrayView<const uint8_t>(&header, 1),
+                   payload, iv, &sealed_);
+  if (result != AesGcmCipher::Result::kOk) {
+    return result == AesGcmCipher::Result::kMissingKey ? kMissingKey
+                                                       : kEncryptionFailed;
+  }
+  queued_.emplace_back(rtc::CopyOnWriteBuffer(sealed_.data(), sealed_.size()),
+                       true);
+  return kOk;
+}
+
+void DataChannelCryptor::SendQueued() {
+  {
+    webrtc::MutexLock lock(&mutex_);
+    if (sending_) {
+      return;
+    }
+    sending_ = true;
+  }
+  // Messages queued by other threads meanwhile are sent by this loop, in
+  // the order they were sealed.
+  std::deque<webrtc::DataBuffer> sending;
+  while (true) {
+    {
+      webrtc::MutexLock lock(&mutex_);
+      if (queued_.empty()) {
+        sending_ = false;
+        return;
+      }
+      sending.swap(queued_);
+    }
+    for (const webrtc::DataBuffer& buffer : sending) {
+      data_channel_->SendRaw(buffer);
+    }
+    sending.clear();
+  }
+}
+
+void DataChannelCryptor::Deliver(rtc::ArrayView<const uint8_t> payload,
+                                 uint8_t header) {
+  if (!(header & kHeaderBatch)) {
+    data_channel_->DeliverMessage(reinterpret_cast<const char*>(payload.data()),
+                                  static_cast<int>(payload.size()),
+                                  header & kHeaderBinary);
+    return;
+  }
+
+  size_t offset = 0;
+  while (offset + kBatchEntryHeaderSize <= payload.size()) {
+    const uint8_t* entry = payload.data() + offset;
+    const uint32_t size = ReadUint32(entry + 1);
+    offset += kBatchEntryHeaderSize;
+    if (size > payload.size() - offset) {
+      RTC_LOG(LS_WARNING) << __FUNCTION__ << ": truncated batch";
+      return;
+    }
+    data_channel_->DeliverMessage(
+        reinterpret_cast<const char*>(payload.data() + offset),
+        static_cast<int>(size), entry[0] & kHeaderBinary);
+    offset += size;
+  }
+}
+
+void DataChannelCryptor::SetState(RTCFrameCryptionState state) {
+  if (state == kNew) {
+    return;
+  }
+  webrtc::MutexLock lock(&observer_mutex_);
+  if (last_state_ == state) {
+    return;
+  }
+  last_state_ = state;
+  if (observer_) {
+    observer_->OnFrameCryptionStateChanged(participant_id_, state);
+  }
+}
+
+}  // namespace libwebrtc
@@ -0,0 +1,121 @@
+#ifndef LIB_RTC_DATA_CHANNEL_CYRPTOR_IMPL_H_
+#define LIB_RTC_DATA_CHANNEL_CYRPTOR_IMPL_H_
+
+#include "rtc_data_channel_impl.h"
+#include "rtc_frame_cryptor.h"
+
+#include <deque>
+
+#include "rtc_base/buffer.h"
+#include "rtc_base/synchronization/mutex.h"
+#include "src/internal/aes_gcm_cipher.h"
+
+namespace libwebrtc {
+
+// Encrypts the messages of a data channel with AesGcmCipher. Each message is
+// sent as
+//
+//   [header byte][ciphertext + tag][iv][iv length][key index]
+//
+// where the header byte carries the binary flag, or marks a batch of small
+// messages sealed together, each prefixed with its flags and a 32-bit size.
+//
+// Installed on the channel, which keeps it alive while it transforms a
+// message. It holds the channel in turn, until the channel closes or the
+// RTCDataChannelCryptorImpl that installed it goes away and removes it. No
+// lock is held while sending or delivering: sending blocks on the
+// signaling thread, which delivers received messages.
+class DataChannelCryptor : public DataChannelTransformer {
+ public:
+  DataChannelCryptor(const string participant_id,
+                     scoped_refptr<KeyProvider> key_provider,
+                     scoped_refptr<RTCDataChannelImpl> data_channel,
+                     const RTCDataChannelCryptorOptions& options);
+
+  // Sends the pending batch and stops delivering state changes.
+  void Detach();
+
+  void RegisterObserver(RTCFrameCryptorObserver* observer);
+
+  bool SetEnabled(bool enabled);
+  bool enabled() const;
+  bool SetKeyIndex(int index);
+  int key_index() const;
+
+  void TransformSend(const uint8_t* data, uint32_t size, bool binary) override;
+
+  void TransformReceived(const webrtc::DataBuffer& buffer) override;
+
+ private:
+  void Flush();
+
+  // Seal and queue the messages in order, returning the resulting state or
+  // kNew if there was nothing to seal.
+  RTCFrameCryptionState Flush_locked() RTC_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  RTCFrameCryptionState Seal_locked(uint8_t header,
+                                    rtc::ArrayView<const uint8_t> payload)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Sends the queued messages unless another caller already is.
+  void SendQueued();
+
+  void Deliver(rtc::ArrayView<const uint8_t> payload, uint8_t header);
+
+  void SetState(RTCFrameCryptionState state);
+
+  const string participant_id_;
+  const RTCDataChannelCryptorOptions options_;
+  const scoped_refptr<KeyProvider> key_provider_;
+  const scoped_refptr<RTCDataChannelImpl> data_channel_;
+  // Thread safe, the key handler is looked up per message.
+  AesGcmCipher cipher_;
+  uint8_t iv_prefix_[AesGcmCipher::kIvSize - 4];
+
+  mutable webrtc::Mutex mutex_;
+  bool enabled_ RTC_GUARDED_BY(mutex_) = false;
+  int key_index_ RTC_GUARDED_BY(mutex_) = 0;
+  uint32_t send_count_ RTC_GUARDED_BY(mutex_) = 0;
+  rtc::Buffer batch_ RTC_GUARDED_BY(mutex_);
+  bool flush_pending_ RTC_GUARDED_BY(mutex_) = false;
+  rtc::Buffer sealed_ RTC_GUARDED_BY(mutex_);
+  std::deque<webrtc::DataBuffer> queued_ RTC_GUARDED_BY(mutex_);
+  bool sending_ RTC_GUARDED_BY(mutex_) = false;
+  // Only touched by TransformReceived(), which the channel serializes.
+  rtc::Buffer received_;
+
+  webrtc::Mutex observer_mutex_;
+  RTCFrameCryptorObserver* observer_ RTC_GUARDED_BY(observer_mutex_) =
+      nullptr;
+  RTCFrameCryptionState last_state_ RTC_GUARDED_BY(observer_mutex_) = kNew;
+};
+
+class RTCDataChannelCryptorImpl : public RTCFrameCryptor {
+ public:
+  RTCDataChannelCryptorImpl(
+      const string participant_id,
+      scoped_refptr<KeyProvider> key_provider,
+      scoped_refptr<RTCDataChannel> data_channel,
+      const RTCDataChannelCryptorOptions& options);
+  ~RTCDataChannelCryptorImpl();
+
+  void RegisterRTCFrameCryptorObserver(
+      RTCFrameCryptorObserver* observer) override;
+
+  void DeRegisterRTCFrameCryptorObserver() override;
+
+  bool SetEnabled(bool enabled) override;
+  bool enabled() const override;
+  bool SetKeyIndex(int index) override;
+  int key_index() const override;
+  const string participant_id() const override { return participant_id_; }
+
+ private:
+  const string participant_id_;
+  scoped_refptr<RTCDataChannelImpl> data_channel_;
+  rtc::scoped_refptr<DataChannelCryptor> cryptor_;
+};
+
+}  // namespace libwebrtc
+
+#endif  // LIB_RTC_DATA_CHANNEL_CYRPTOR_IMPL_H_
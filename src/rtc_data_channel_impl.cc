@@ -12,11 +12,43 @@ RTCDataChannelImpl::RTCDataChannelImpl(
 void RTCDataChannelImpl::Send(const uint8_t* data,
                               uint32_t size,
                               bool binary /*= false*/) {
+  rtc::scoped_refptr<DataChannelTransformer> transformer;
+  {
+    webrtc::MutexLock lock(crit_sect_.get());
+    transformer = transformer_;
+  }
+  // Sending blocks on the signaling thread, which takes the lock in
+  // OnMessage(), so it must run unlocked.
+  if (transformer) {
+    transformer->TransformSend(data, size, binary);
+    return;
+  }
   rtc::CopyOnWriteBuffer copyOnWriteBuffer(data, size);
   webrtc::DataBuffer buffer(copyOnWriteBuffer, binary);
   rtc_data_channel_->Send(buffer);
 }
 
+void RTCDataChannelImpl::SetTransformer(
+    rtc::scoped_refptr<DataChannelTransformer> transformer) {
+  webrtc::MutexLock lock(crit_sect_.get());
+  if (closed_) {
+    // Would hold a transformer that is never released, see OnStateChange().
+    return;
+  }
+  transformer_ = transformer;
+}
+
+void RTCDataChannelImpl::SendRaw(const webrtc::DataBuffer& buffer) {
+  rtc_data_channel_->Send(buffer);
+}
+
+void RTCDataChannelImpl::DeliverMessage(const char* buffer,
+                                        int length,
+                                        bool binary) {
+  if (observer_)
+    observer_->OnMessage(buffer, length, binary);
+}
+
 void RTCDataChannelImpl::Close() {
   rtc_data_channel_->UnregisterObserver();
   rtc_data_channel_->Close();
@@ -41,6 +73,8 @@ int RTCDataChannelImpl::id() const {
 }
 
 void RTCDataChannelImpl::OnStateChange() {
+  // Released last, it may hold the last reference to this channel.
+  rtc::scoped_refptr<DataChannelTransformer> transformer;
   webrtc::DataChannelInterface::DataState state = rtc_data_channel_->state();
   switch (state) {
     case webrtc::DataChannelInterface::kConnecting:
@@ -52,9 +86,15 @@ void RTCDataChannelImpl::OnStateChange() {
     case webrtc::DataChannelInterface::kClosing:
       state_ = RTCDataChannelClosing;
       break;
-    case webrtc::DataChannelInterface::kClosed:
+    case webrtc::DataChannelInterface::kClosed: {
       state_ = RTCDataChannelClosed;
+      // No message is sent or received any more. A transformer holds the
+      // channel too, dropping it breaks that cycle.
+      webrtc::MutexLock lock(crit_sect_.get());
+      closed_ = true;
+      transformer = std::move(transformer_);
       break;
+    }
     default:
       break;
   }
@@ -68,9 +108,17 @@ RTCDataChannelState RTCDataChannelImpl::state() {
 }
 
 void RTCDataChannelImpl::OnMessage(const webrtc::DataBuffer& buffer) {
-  if (observer_)
-    observer_->OnMessage(buffer.data.data<char>(), buffer.data.size(),
-                         buffer.binary);
+  rtc::scoped_refptr<DataChannelTransformer> transformer;
+  {
+    webrtc::MutexLock lock(crit_sect_.get());
+    transformer = transformer_;
+  }
+  // Unlocked, the observer may reply with Send() from its callback.
+  if (transformer) {
+    transformer->TransformReceived(buffer);
+    return;
+  }
+  DeliverMessage(buffer.data.data<char>(), buffer.data.size(), buffer.binary);
 }
 
 }  // namespace libwebrtc
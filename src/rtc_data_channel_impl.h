@@ -2,12 +2,34 @@
 #define LIB_WEBRTC_RTC_DATA_CHANNEL_IMPL_HXX
 
 #include "api/data_channel_interface.h"
+#include "api/scoped_refptr.h"
+#include "rtc_base/ref_count.h"
 #include "rtc_base/synchronization/mutex.h"
 #include "rtc_data_channel.h"
 #include "rtc_types.h"
 
 namespace libwebrtc {
 
+// Transforms the messages of a data channel, e.g. to encrypt them. Called
+// without the channel's lock; the channel holds a reference for the duration
+// of each call, so the transformer outlives calls in flight when it is
+// detached. The channel drops its transformer once it is closed.
+class DataChannelTransformer : public rtc::RefCountInterface {
+ public:
+  // Called for every message sent by the application. The transformer sends
+  // the result through RTCDataChannelImpl::SendRaw().
+  virtual void TransformSend(const uint8_t* data,
+                             uint32_t size,
+                             bool binary) = 0;
+
+  // Called for every message received from the remote peer. The transformer
+  // hands the result to RTCDataChannelImpl::DeliverMessage().
+  virtual void TransformReceived(const webrtc::DataBuffer& buffer) = 0;
+
+ protected:
+  virtual ~DataChannelTransformer() {}
+};
+
 class RTCDataChannelImpl : public RTCDataChannel,
                            public webrtc::DataChannelObserver {
  public:
@@ -34,6 +56,12 @@ class RTCDataChannelImpl : public RTCDataChannel,
     return rtc_data_channel_;
   }
 
+  void SetTransformer(rtc::scoped_refptr<DataChannelTransformer> transformer);
+
+  void SendRaw(const webrtc::DataBuffer& buffer);
+
+  void DeliverMessage(const char* buffer, int length, bool binary);
+
  protected:
   virtual void OnStateChange() override;
 
@@ -42,6 +70,8 @@ class RTCDataChannelImpl : public RTCDataChannel,
  private:
   rtc::scoped_refptr<webrtc::DataChannelInterface> rtc_data_channel_;
   RTCDataChannelObserver* observer_ = nullptr;
+  rtc::scoped_refptr<DataChannelTransformer> transformer_;
+  bool closed_ = false;
   std::unique_ptr<webrtc::Mutex> crit_sect_;
   RTCDataChannelState state_;
   string label_;
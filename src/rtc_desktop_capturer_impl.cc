@@ -16,8 +16,15 @@
 
 #include "rtc_desktop_capturer_impl.h"
 
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+
 #include "api/sequence_checker.h"
 #include "rtc_base/checks.h"
+#include "rtc_base/time_utils.h"
+#include "src/internal/virtual_desktop_capturer.h"
 #include "third_party/libyuv/include/libyuv.h"
 #ifdef WEBRTC_WIN
 #include "modules/desktop_capture/win/window_capture_utils.h"
@@ -27,18 +34,29 @@ namespace libwebrtc {
 
 enum { kCaptureDelay = 33, kCaptureMessageId = 1000 };
 
+// How often an unchanged desktop is sent again, so that the encoder keeps
+// producing frames for receivers that join or lose packets.
+const int64_t kStaticFrameRepeatMs = 1000;
+
+// How often the cursor is polled in CM_SEPARATE mode.
+const int kCursorIntervalMs = 33;
+
+// One buffer being filled, one queued and one read by the encoder.
+const size_t kBufferPoolSize = 3;
+
 RTCDesktopCapturerImpl::RTCDesktopCapturerImpl(
     DesktopType type,
     webrtc::DesktopCapturer::SourceId source_id,
     rtc::Thread* signaling_thread,
     scoped_refptr<MediaSource> source)
-    : thread_(rtc::Thread::Create()),
+    : service_(DesktopCaptureService::Get()),
+      thread_(service_->capture_thread()),
+      convert_thread_(service_->AssignWorkerThread()),
+      buffer_pool_(kBufferPoolSize),
       source_id_(source_id),
       signaling_thread_(signaling_thread),
       source_(source) {
-  RTC_DCHECK(thread_);
   type_ = type;
-  thread_->Start();
   options_ = webrtc::DesktopCaptureOptions::CreateDefault();
   options_.set_detect_updated_region(true);
 #ifdef WEBRTC_WIN
@@ -49,20 +67,94 @@ RTCDesktopCapturerImpl::RTCDesktopCapturerImpl(
     options_.set_allow_pipewire(true);
   }
 #endif
- thread_->BlockingCall([this, type] {
-    if (type == kScreen) {
-      capturer_ = std::make_unique<webrtc::DesktopAndCursorComposer>(
-          webrtc::DesktopCapturer::CreateScreenCapturer(options_), options_);
-    } else {
-      capturer_ = std::make_unique<webrtc::DesktopAndCursorComposer>(
-          webrtc::DesktopCapturer::CreateWindowCapturer(options_), options_);
-    }
+  // The safety flag is bound to the thread that creates it.
+  thread_->BlockingCall([this] {
+    safety_flag_ = webrtc::PendingTaskSafetyFlag::Create();
+    CreateCapturer();
   });
 }
 
 RTCDesktopCapturerImpl::~RTCDesktopCapturerImpl() {
-  thread_->Stop();
+  thread_->BlockingCall([this] {
+    safety_flag_->SetNotAlive();
+    if (cursor_safety_flag_) {
+      cursor_safety_flag_->SetNotAlive();
+    }
+    service_->CancelTick(this);
+    cursor_monitor_.reset();
+    cursor_.reset();
+    capturer_.reset();
+  });
+  // A conversion in flight still uses this capturer.
+  convert_thread_->BlockingCall([] {});
+}
+
+void RTCDesktopCapturerImpl::CreateCapturer() {
+  RTC_DCHECK_RUN_ON(thread_);
+  cursor_monitor_.reset();
   capturer_.reset();
+  capturer_started_ = false;
+  if (type_ == kVirtual) {
+    // A virtual desktop has no cursor of its own.
+    capturer_ = std::make_unique<VirtualDesktopCapturer>(
+        static_cast<RTCVirtualDesktopImpl*>(source_.get()));
+    return;
+  }
+  options_.set_prefer_cursor_embedded(cursor_mode_ == CM_COMPOSITED);
+  std::unique_ptr<webrtc::DesktopCapturer> capturer;
+  if (type_ == kScreen) {
+    capturer = webrtc::DesktopCapturer::CreateScreenCapturer(options_);
+  } else {
+    capturer = webrtc::DesktopCapturer::CreateWindowCapturer(options_);
+  }
+  if (cursor_mode_ == CM_COMPOSITED) {
+    capturer_ = std::make_unique<webrtc::DesktopAndCursorComposer>(
+        std::move(capturer), options_);
+    return;
+  }
+
+  capturer_ = std::move(capturer);
+  if (type_ == kScreen) {
+    // Positions are relative to the captured screen.
+    cursor_monitor_.reset(webrtc::MouseCursorMonitor::CreateForScreen(
+        options_,
+        source_id_ != -1 ? source_id_ : webrtc::kFullDesktopScreenId));
+  } else if (source_id_ != -1) {
+    cursor_monitor_.reset(
+        webrtc::MouseCursorMonitor::CreateForWindow(options_, source_id_));
+  }
+  if (cursor_monitor_) {
+    cursor_monitor_->Init(this, webrtc::MouseCursorMonitor::SHAPE_AND_POSITION);
+  }
+}
+
+bool RTCDesktopCapturerImpl::SetCursorMode(CursorMode mode) {
+  if (capture_state_ == CS_RUNNING) {
+    return false;
+  }
+  thread_->BlockingCall([this, mode] {
+    if (cursor_mode_ != mode) {
+      cursor_mode_ = mode;
+      CreateCapturer();
+    }
+  });
+  return true;
+}
+
+void RTCDesktopCapturerImpl::RegisterDesktopCursorObserver(
+    DesktopCursorObserver* observer) {
+  thread_->BlockingCall([this, observer] {
+    cursor_observer_ = observer;
+    // Report the current cursor to the new observer.
+    cursor_position_sent_ = false;
+    if (cursor_) {
+      NotifyCursorShape();
+    }
+  });
+}
+
+void RTCDesktopCapturerImpl::DeRegisterDesktopCursorObserver() {
+  thread_->BlockingCall([this] { cursor_observer_ = nullptr; });
 }
 
 RTCDesktopCapturerImpl::CaptureState RTCDesktopCapturerImpl::Start(uint32_t fps,
@@ -92,34 +184,53 @@ RTCDesktopCapturerImpl::CaptureState RTCDesktopCapturerImpl::Start(
     return capture_state_;
   }
 
-  if (fps >= 60) {
-    capture_delay_ = uint32_t(1000.0 / 60.0);
-  } else {
-    capture_delay_ = uint32_t(1000.0 / fps);
-  }
 
-  if (source_id_ != -1) {
-    if (!capturer_->SelectSource(source_id_)) {
-      capture_state_ = CS_FAILED;
-      return capture_state_;
-    }
-    if (type_ == kWindow) {
-      if (!capturer_->FocusOnSelectedSource()) {
-        capture_state_ = CS_FAILED;
-        return capture_state_;
+  bool started = thread_->BlockingCall([this, fps] {
+    if (source_id_ != -1) {
+      if (!capturer_->SelectSource(source_id_)) {
+        return false;
+      }
+      if (type_ == kWindow && !capturer_->FocusOnSelectedSource()) {
+        return false;
       }
     }
+    // The crop rect may have changed, start with a full conversion.
+    full_conversion_ = true;
+    scheduler_.SetRequestedFramerate(fps);
+    // A capturer keeps its callback across Stop() and Start().
+    if (!capturer_started_) {
+      capturer_->Start(this);
+      capturer_started_ = true;
+    }
+    capture_state_ = CS_RUNNING;
+    service_->ScheduleTick(this, 0);
+    cursor_safety_flag_ = webrtc::PendingTaskSafetyFlag::Create();
+    CaptureCursor();
+    return true;
+  });
+  if (!started) {
+    capture_state_ = CS_FAILED;
+    return capture_state_;
   }
-
-  thread_->BlockingCall([this] { capturer_->Start(this); });
-  capture_state_ = CS_RUNNING;
-  thread_->PostTask([this] { CaptureFrame(); });
   if (observer_) {
     signaling_thread_->BlockingCall([&, this]() { observer_->OnStart(this); });
   }
   return capture_state_;
 }
 
+void RTCDesktopCapturerImpl::SetOutputSize(uint32_t width,
+                                           uint32_t height,
+                                           ScalingPolicy policy) {
+  thread_->PostTask(
+      webrtc::SafeTask(safety_flag_, [this, width, height, policy] {
+        output_width_ = width;
+        output_height_ = height;
+        scaling_policy_ = policy;
+        // The crop rect or the output changed, start with a full conversion.
+        full_conversion_ = true;
+      }));
+}
+
 void RTCDesktopCapturerImpl::Stop() {
   if (observer_) {
     if (!signaling_thread_->IsCurrent()) {
@@ -129,6 +240,15 @@ void RTCDesktopCapturerImpl::Stop() {
     }
   }
   capture_state_ = CS_STOPPED;
+  // Posted rather than blocking, Stop() may be called from an observer
+  // callback that the capture thread waits for. It runs before the tasks of
+  // a following Start().
+  thread_->PostTask(webrtc::SafeTask(safety_flag_, [this] {
+    service_->CancelTick(this);
+    if (cursor_safety_flag_) {
+      cursor_safety_flag_->SetNotAlive();
+    }
+  }));
 }
 
 bool RTCDesktopCapturerImpl::IsRunning() {
@@ -173,56 +293,450 @@ void RTCDesktopCapturerImpl::OnCaptureResult(
     return;
   }
 
+  const webrtc::DesktopRect crop_rect = CropRect(frame->size());
+  if (crop_rect.is_empty()) {
+    return;
+  }
+  const webrtc::DesktopSize output_size = OutputSize(crop_rect);
+  cursor_crop_rect_ = crop_rect;
+  cursor_output_size_ = output_size;
+  const bool full = full_conversion_;
+  full_conversion_ = false;
+
+  // Converted on the worker thread of this capturer while the capture
+  // thread serves the other capturers. The next capture waits for it, as
+  // capturers reuse their frame buffers.
+  converting_ = true;
+  convert_thread_->PostTask([this, frame = std::move(frame), crop_rect,
+                             output_size, full]() mutable {
+    bool changed = ConvertFrame(std::move(frame), crop_rect, output_size, full);
+    thread_->PostTask(webrtc::SafeTask(safety_flag_, [this, changed] {
+      converting_ = false;
+      FinishCapture(changed);
+    }));
+  });
+}
+
+bool RTCDesktopCapturerImpl::ConvertFrame(
+    std::unique_ptr<webrtc::DesktopFrame> frame,
+    const webrtc::DesktopRect& crop_rect,
+    const webrtc::DesktopSize& output_size,
+    bool full) {
+  RTC_DCHECK_RUN_ON(convert_thread_);
+  bool changed = false;
   int width = frame->size().width();
   int height = frame->size().height();
 #ifdef WEBRTC_WIN
   webrtc::DesktopRect rect_ = webrtc::DesktopRect::MakeWH(width, height);
 
-  if (type_ != kScreen) {
+  if (type_ == kWindow) {
     webrtc::GetWindowRect(reinterpret_cast<HWND>(source_id_), &rect_);
   }
 
   __try
 #endif
   {
-    width = w_ > 0 ? w_ : width;
-    height = h_ > 0 ? h_ : height;
-    if (!i420_buffer_ || !i420_buffer_.get() ||
-        i420_buffer_->width() * i420_buffer_->height() != width * height) {
-      i420_buffer_ = webrtc::I420Buffer::Create(width, height);
+    int64_t now_ms = rtc::TimeMillis();
+    const bool scaled = !output_size.equals(crop_rect.size());
+    width = output_size.width();
+    height = output_size.height();
+
+    bool incremental = false;
+    if (!full && i420_buffer_ && i420_buffer_->width() == width &&
+        i420_buffer_->height() == height) {
+#ifdef WEBRTC_WIN
+      // Window frames are converted with the window rect, see below.
+      incremental = type_ != kWindow || scaled;
+#else
+      incremental = true;
+#endif
+      incremental = incremental && last_frame_size_.equals(frame->size());
+      if (scaled) {
+        incremental = incremental && scaled_frame_ &&
+                      scaled_frame_->size().equals(output_size);
+      }
     }
+    last_frame_size_ = frame->size();
 
-    libyuv::ConvertToI420(frame->data(), 0, i420_buffer_->MutableDataY(),
-                          i420_buffer_->StrideY(), i420_buffer_->MutableDataU(),
-                          i420_buffer_->StrideU(), i420_buffer_->MutableDataV(),
-                          i420_buffer_->StrideV(), x_, y_,
+    // The damaged part of the crop rect, in output coordinates.
+    webrtc::DesktopRegion updated_region;
+    if (incremental) {
+      webrtc::DesktopRegion damage(frame->updated_region());
+      damage.IntersectWith(crop_rect);
+      for (webrtc::DesktopRegion::Iterator it(damage); !it.IsAtEnd();
+           it.Advance()) {
+        if (scaled) {
+          updated_region.AddRect(ScaleRect(*frame, crop_rect, it.rect()));
+        } else {
+          webrtc::DesktopRect rect = it.rect();
+          rect.Translate(-crop_rect.left(), -crop_rect.top());
+          updated_region.AddRect(rect);
+        }
+      }
+    }
+
+    if (incremental && updated_region.is_empty()) {
+      if (now_ms - last_frame_ms_ < kStaticFrameRepeatMs) {
+        return false;
+      }
+      // Nothing changed, the previous buffer is sent again as is.
+      last_frame_ms_ = now_ms;
+      OnFrame(webrtc::VideoFrame(i420_buffer_, 0, now_ms,
+                                 webrtc::kVideoRotation_0));
+      return false;
+    }
+
+    // The previous buffer may still be read by the encoder, so every frame
+    // is written into a buffer that is no longer referenced.
+    rtc::scoped_refptr<webrtc::I420Buffer> buffer =
+        buffer_pool_.CreateBuffer(width, height);
+    if (incremental) {
+      const webrtc::DesktopFrame& argb = scaled ? *scaled_frame_ : *frame;
+      const webrtc::DesktopVector origin =
+          scaled ? webrtc::DesktopVector() : crop_rect.top_left();
+      // The buffer already holds an older frame. Bring the part that changed
+      // since then up to date from the previous frame, and convert only the
+      // damaged part of the crop rect.
+      webrtc::DesktopRegion stale_region;
+      auto stale = stale_regions_.find(buffer.get());
+      if (stale != stale_regions_.end()) {
+        stale_region.Swap(&stale->second);
+      } else {
+        stale_region.SetRect(webrtc::DesktopRect::MakeSize(output_size));
+      }
+      stale_region.Subtract(updated_region);
+      for (webrtc::DesktopRegion::Iterator it(stale_region); !it.IsAtEnd();
+           it.Advance()) {
+        CopyRect(*i420_buffer_, it.rect(), buffer.get());
+      }
+      for (webrtc::DesktopRegion::Iterator it(updated_region); !it.IsAtEnd();
+           it.Advance()) {
+        ConvertRect(argb, origin, it.rect(), buffer.get());
+      }
+    } else if (scaled) {
+      // Scale straight from the capture, so the crop rect is never converted
+      // at its own size.
+      if (!scaled_frame_ || !scaled_frame_->size().equals(output_size)) {
+        scaled_frame_.reset(new webrtc::BasicDesktopFrame(output_size));
+      }
+      webrtc::DesktopRect rect = ScaleRect(*frame, crop_rect, crop_rect);
+      ConvertRect(*scaled_frame_, webrtc::DesktopVector(), rect, buffer.get());
+    } else {
+      libyuv::ConvertToI420(frame->data(), 0, buffer->MutableDataY(),
+                            buffer->StrideY(), buffer->MutableDataU(),
+                            buffer->StrideU(), buffer->MutableDataV(),
+                            buffer->StrideV(), crop_rect.left(),
+                            crop_rect.top(),
 #ifdef WEBRTC_WIN
-                          rect_.width(), rect_.height(),
+                            rect_.width(), rect_.height(),
 #else
-                          width, height,
+                            frame->stride() /
+                                webrtc::DesktopFrame::kBytesPerPixel,
+                            frame->size().height(),
 #endif
-                          width, height, libyuv::kRotate0, libyuv::FOURCC_ARGB);
+                            width, height, libyuv::kRotate0,
+                            libyuv::FOURCC_ARGB);
+    }
 
-    OnFrame(webrtc::VideoFrame(i420_buffer_, 0, rtc::TimeMillis(),
+    if (incremental) {
+      for (auto& entry : stale_regions_) {
+        entry.second.AddRegion(updated_region);
+      }
+    } else {
+      // Every other buffer holds a frame of another size or crop.
+      stale_regions_.clear();
+    }
+    if (buffer_pool_.IsPooled(buffer.get())) {
+      stale_regions_[buffer.get()].Clear();
+    } else {
+      stale_regions_.erase(buffer.get());
+    }
+    i420_buffer_ = buffer;
+    changed = true;
+    last_frame_ms_ = now_ms;
+    OnFrame(webrtc::VideoFrame(i420_buffer_, 0, now_ms,
                                webrtc::kVideoRotation_0));
   }
 #ifdef WEBRTC_WIN
   __except (filterException(GetExceptionCode(), GetExceptionInformation())) {
   }
 #endif
+  return changed;
+}
+
+RTCFrameBufferPoolStats RTCDesktopCapturerImpl::buffer_pool_stats() {
+  RTCFrameBufferPoolStats stats;
+  stats.hits = buffer_pool_.hits();
+  stats.misses = buffer_pool_.misses();
+  return stats;
+}
+
+webrtc::DesktopRect RTCDesktopCapturerImpl::CropRect(
+    const webrtc::DesktopSize& frame_size) const {
+  webrtc::DesktopRect crop_rect = webrtc::DesktopRect::MakeXYWH(
+      x_, y_, w_ > 0 ? w_ : frame_size.width(),
+      h_ > 0 ? h_ : frame_size.height());
+  crop_rect.IntersectWith(webrtc::DesktopRect::MakeSize(frame_size));
+  if (scaling_policy_ != SP_FILL || !output_width_ || !output_height_ ||
+      crop_rect.is_empty()) {
+    return crop_rect;
+  }
+
+  // Trim the longer side so that the crop rect has the output aspect ratio.
+  const int64_t width = crop_rect.width();
+  const int64_t height = crop_rect.height();
+  if (width * output_height_ > height * output_width_) {
+    int trimmed = static_cast<int>(height * output_width_ / output_height_);
+    return webrtc::DesktopRect::MakeXYWH(
+        crop_rect.left() + (crop_rect.width() - trimmed) / 2, crop_rect.top(),
+        trimmed, crop_rect.height());
+  }
+  int trimmed = static_cast<int>(width * output_height_ / output_width_);
+  return webrtc::DesktopRect::MakeXYWH(
+      crop_rect.left(), crop_rect.top() + (crop_rect.height() - trimmed) / 2,
+      crop_rect.width(), trimmed);
 }
 
+webrtc::DesktopSize RTCDesktopCapturerImpl::OutputSize(
+    const webrtc::DesktopRect& crop_rect) const {
+  if (!output_width_ || !output_height_) {
+    return crop_rect.size();
+  }
+
+  int64_t width = output_width_;
+  int64_t height = output_height_;
+  if (scaling_policy_ == SP_FIT) {
+    if (crop_rect.width() <= width && crop_rect.height() <= height) {
+      return crop_rect.size();
+    }
+    if (crop_rect.width() * height > crop_rect.height() * width) {
+      height = crop_rect.height() * width / crop_rect.width();
+    } else {
+      width = crop_rect.width() * height / crop_rect.height();
+    }
+  }
+  // Even sizes, so that chroma covers the whole frame.
+  return webrtc::DesktopSize(std::max(2, static_cast<int>(width) & ~1),
+                             std::max(2, static_cast<int>(height) & ~1));
+}
 
-void RTCDesktopCapturerImpl::CaptureFrame() {
-  RTC_DCHECK_RUN_ON(thread_.get());
+bool RTCDesktopCapturerImpl::AlignRect(const webrtc::DesktopRect& rect,
+                                       const webrtc::DesktopSize& size,
+                                       webrtc::DesktopRect* aligned) const {
+  // Chroma is subsampled 2x2, so whole 2x2 blocks are written.
+  int left = std::max(rect.left(), 0) & ~1;
+  int top = std::max(rect.top(), 0) & ~1;
+  int right = std::min((rect.right() + 1) & ~1, size.width());
+  int bottom = std::min((rect.bottom() + 1) & ~1, size.height());
+  *aligned = webrtc::DesktopRect::MakeLTRB(left, top, right, bottom);
+  return !aligned->is_empty();
+}
+
+webrtc::DesktopRect RTCDesktopCapturerImpl::ScaleRect(
+    const webrtc::DesktopFrame& frame,
+    const webrtc::DesktopRect& crop_rect,
+    const webrtc::DesktopRect& rect) {
+  const webrtc::DesktopSize& size = scaled_frame_->size();
+  const int64_t src_width = crop_rect.width();
+  const int64_t src_height = crop_rect.height();
+  const int64_t left = rect.left() - crop_rect.left();
+  const int64_t top = rect.top() - crop_rect.top();
+  const int64_t right = rect.right() - crop_rect.left();
+  const int64_t bottom = rect.bottom() - crop_rect.top();
+  // The output pixels |rect| contributes to, with one more on every side
+  // for the filter taps.
+  webrtc::DesktopRect scaled = webrtc::DesktopRect::MakeLTRB(
+      static_cast<int>(left * size.width() / src_width) - 1,
+      static_cast<int>(top * size.height() / src_height) - 1,
+      static_cast<int>((right * size.width() + src_width - 1) / src_width) + 1,
+      static_cast<int>((bottom * size.height() + src_height - 1) /
+                       src_height) +
+          1);
+  webrtc::DesktopRect dst;
+  if (!AlignRect(scaled, size, &dst)) {
+    return dst;
+  }
+
+  // Only |dst| is written, but it is sampled as part of the whole crop rect
+  // so that it matches the pixels around it.
+  libyuv::ARGBScaleClip(frame.GetFrameDataAtPos(crop_rect.top_left()),
+                        frame.stride(), crop_rect.width(), crop_rect.height(),
+                        scaled_frame_->data(), scaled_frame_->stride(),
+                        size.width(), size.height(), dst.left(), dst.top(),
+                        dst.width(), dst.height(), libyuv::kFilterBox);
+  return dst;
+}
+
+void RTCDesktopCapturerImpl::ConvertRect(const webrtc::DesktopFrame& frame,
+                                         const webrtc::DesktopVector& origin,
+                                         const webrtc::DesktopRect& rect,
+                                         webrtc::I420Buffer* buffer) {
+  webrtc::DesktopRect dst;
+  if (!AlignRect(rect,
+                 webrtc::DesktopSize(buffer->width(), buffer->height()),
+                 &dst)) {
+    return;
+  }
+
+  libyuv::ARGBToI420(
+      frame.GetFrameDataAtPos(origin.add(dst.top_left())), frame.stride(),
+      buffer->MutableDataY() + dst.top() * buffer->StrideY() + dst.left(),
+      buffer->StrideY(),
+      buffer->MutableDataU() + dst.top() / 2 * buffer->StrideU() +
+          dst.left() / 2,
+      buffer->StrideU(),
+      buffer->MutableDataV() + dst.top() / 2 * buffer->StrideV() +
+          dst.left() / 2,
+      buffer->StrideV(), dst.width(), dst.height());
+}
+
+void RTCDesktopCapturerImpl::CopyRect(const webrtc::I420Buffer& src,
+                                      const webrtc::DesktopRect& rect,
+                                      webrtc::I420Buffer* buffer) {
+  webrtc::DesktopRect dst;
+  if (!AlignRect(rect,
+                 webrtc::DesktopSize(buffer->width(), buffer->height()),
+                 &dst)) {
+    return;
+  }
+
+  libyuv::I420Copy(
+      src.DataY() + dst.top() * src.StrideY() + dst.left(), src.StrideY(),
+      src.DataU() + dst.top() / 2 * src.StrideU() + dst.left() / 2,
+      src.StrideU(),
+      src.DataV() + dst.top() / 2 * src.StrideV() + dst.left() / 2,
+      src.StrideV(),
+      buffer->MutableDataY() + dst.top() * buffer->StrideY() + dst.left(),
+      buffer->StrideY(),
+      buffer->MutableDataU() + dst.top() / 2 * buffer->StrideU() +
+          dst.left() / 2,
+      buffer->StrideU(),
+      buffer->MutableDataV() + dst.top() / 2 * buffer->StrideV() +
+          dst.left() / 2,
+      buffer->StrideV(), dst.width(), dst.height());
+}
+
+void RTCDesktopCapturerImpl::OnCaptureTick() {
+  RTC_DCHECK_RUN_ON(thread_);
+  if (capture_state_ != CS_RUNNING || converting_) {
+    // A tick is scheduled again once the conversion is done.
+    return;
+  }
+  capture_start_us_ = rtc::TimeMicros();
+  capturer_->CaptureFrame();
+  if (!converting_) {
+    FinishCapture(false);
+  }
+}
+
+void RTCDesktopCapturerImpl::FinishCapture(bool changed) {
+  RTC_DCHECK_RUN_ON(thread_);
+  scheduler_.OnCaptureDone(rtc::TimeMicros() - capture_start_us_, changed);
   if (capture_state_ == CS_RUNNING) {
-    capturer_->CaptureFrame();
-    thread_->PostDelayedHighPrecisionTask(
-      [this]() {
-        CaptureFrame();
-      },
-      webrtc::TimeDelta::Millis(capture_delay_));
+    service_->ScheduleTick(this, scheduler_.NextDelayMs());
+  }
+}
+
+void RTCDesktopCapturerImpl::CaptureCursor() {
+  RTC_DCHECK_RUN_ON(thread_);
+  if (capture_state_ != CS_RUNNING || !cursor_monitor_) {
+    return;
+  }
+  // Polled on its own, so that the cursor keeps moving smoothly while the
+  // frame rate backs off for static content.
+  cursor_monitor_->Capture();
+  thread_->PostDelayedTask(
+      webrtc::SafeTask(cursor_safety_flag_, [this]() { CaptureCursor(); }),
+      webrtc::TimeDelta::Millis(kCursorIntervalMs));
+}
+
+void RTCDesktopCapturerImpl::OnMouseCursor(webrtc::MouseCursor* cursor) {
+  RTC_DCHECK_RUN_ON(thread_);
+  cursor_.reset(cursor);
+  if (cursor_observer_) {
+    NotifyCursorShape();
+  }
+}
+
+void RTCDesktopCapturerImpl::NotifyCursorShape() {
+  if (!cursor_->image()) {
+    return;
+  }
+
+  const webrtc::DesktopFrame& image = *cursor_->image();
+  const size_t row_size =
+      image.size().width() * webrtc::DesktopFrame::kBytesPerPixel;
+  std::vector<uint8_t> data(row_size * image.size().height());
+  for (int y = 0; y < image.size().height(); y++) {
+    memcpy(data.data() + y * row_size,
+           image.GetFrameDataAtPos(webrtc::DesktopVector(0, y)), row_size);
+  }
+
+  RTCDesktopCursorShape shape;
+  shape.width = image.size().width();
+  shape.height = image.size().height();
+  shape.hotspot_x = cursor_->hotspot().x();
+  shape.hotspot_y = cursor_->hotspot().y();
+  shape.data = data;
+  cursor_observer_->OnCursorShapeChanged(shape);
+}
+
+void RTCDesktopCapturerImpl::OnMouseCursorPosition(
+    const webrtc::DesktopVector& position) {
+  RTC_DCHECK_RUN_ON(thread_);
+  if (!cursor_observer_ || cursor_crop_rect_.is_empty()) {
+    return;
+  }
+
+  // Map to the coordinates of the sent frames.
+  const webrtc::DesktopRect& crop_rect = cursor_crop_rect_;
+  const bool visible = crop_rect.Contains(position);
+  const int x = static_cast<int>(
+      static_cast<int64_t>(position.x() - crop_rect.left()) *
+      cursor_output_size_.width() / crop_rect.width());
+  const int y = static_cast<int>(
+      static_cast<int64_t>(position.y() - crop_rect.top()) *
+      cursor_output_size_.height() / crop_rect.height());
+  if (cursor_position_sent_ && x == cursor_x_ && y == cursor_y_ &&
+      visible == cursor_visible_) {
+    return;
+  }
+  cursor_position_sent_ = true;
+  cursor_x_ = x;
+  cursor_y_ = y;
+  cursor_visible_ = visible;
+  cursor_observer_->OnCursorPositionChanged(x, y, visible);
+}
+
+void RTCDesktopCapturerImpl::SetFramerateRange(uint32_t min_fps,
+                                               uint32_t max_fps) {
+  thread_->PostTask(webrtc::SafeTask(safety_flag_, [this, min_fps, max_fps] {
+    scheduler_.SetFramerateRange(min_fps, max_fps);
+  }));
+}
+
+void RTCDesktopCapturerImpl::AddOrUpdateSink(
+    rtc::VideoSinkInterface<webrtc::VideoFrame>* sink,
+    const rtc::VideoSinkWants& wants) {
+  VideoCapturer::AddOrUpdateSink(sink, wants);
+  UpdateSinkWants();
+}
+
+void RTCDesktopCapturerImpl::RemoveSink(
+    rtc::VideoSinkInterface<webrtc::VideoFrame>* sink) {
+  VideoCapturer::RemoveSink(sink);
+  UpdateSinkWants();
+}
+
+void RTCDesktopCapturerImpl::UpdateSinkWants() {
+  int max_framerate_fps = GetSinkWants().max_framerate_fps;
+  if (max_framerate_fps == std::numeric_limits<int>::max()) {
+    max_framerate_fps = 0;
   }
+  thread_->PostTask(
+      webrtc::SafeTask(safety_flag_, [this, max_framerate_fps] {
+        scheduler_.SetSinkMaxFramerate(max_framerate_fps);
+      }));
 }
 
 }  // namespace libwebrtc
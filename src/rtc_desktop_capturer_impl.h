@@ -17,23 +17,34 @@
 #ifndef LIBWEBRTC_RTC_DESKTOP_CAPTURER_IMPL_HXX
 #define LIBWEBRTC_RTC_DESKTOP_CAPTURER_IMPL_HXX
 
+#include <map>
+
 #include "include/rtc_desktop_capturer.h"
 #include "include/rtc_types.h"
 
+#include "api/task_queue/pending_task_safety_flag.h"
 #include "api/video/i420_buffer.h"
 #include "api/video/video_frame.h"
 #include "modules/desktop_capture/desktop_and_cursor_composer.h"
 #include "modules/desktop_capture/desktop_capture_options.h"
 #include "modules/desktop_capture/desktop_capturer.h"
 #include "modules/desktop_capture/desktop_frame.h"
+#include "modules/desktop_capture/desktop_region.h"
+#include "modules/desktop_capture/mouse_cursor.h"
+#include "modules/desktop_capture/mouse_cursor_monitor.h"
 #include "rtc_base/thread.h"
+#include "src/internal/desktop_capture_scheduler.h"
+#include "src/internal/desktop_capture_service.h"
+#include "src/internal/i420_buffer_pool.h"
 #include "src/internal/vcm_capturer.h"
 #include "src/internal/video_capturer.h"
 
 namespace libwebrtc {
 
 class RTCDesktopCapturerImpl : public RTCDesktopCapturer,
+                               public DesktopCaptureService::Client,
                                public webrtc::DesktopCapturer::Callback,
+                               public webrtc::MouseCursorMonitor::Callback,
                                public webrtc::internal::VideoCapturer {
  public:
   RTCDesktopCapturerImpl(DesktopType type,
@@ -56,28 +67,127 @@ class RTCDesktopCapturerImpl : public RTCDesktopCapturer,
                      uint32_t w,
                      uint32_t h) override;
 
+  void SetOutputSize(uint32_t width,
+                     uint32_t height,
+                     ScalingPolicy policy) override;
+
   void Stop() override;
 
   bool IsRunning() override;
 
   scoped_refptr<MediaSource> source() override { return source_; }
 
+  RTCFrameBufferPoolStats buffer_pool_stats() override;
+
+  void SetFramerateRange(uint32_t min_fps, uint32_t max_fps) override;
+
+  bool SetCursorMode(CursorMode mode) override;
+
+  void RegisterDesktopCursorObserver(DesktopCursorObserver* observer) override;
+
+  void DeRegisterDesktopCursorObserver() override;
+
+  // rtc::VideoSourceInterface
+  void AddOrUpdateSink(rtc::VideoSinkInterface<webrtc::VideoFrame>* sink,
+                       const rtc::VideoSinkWants& wants) override;
+  void RemoveSink(rtc::VideoSinkInterface<webrtc::VideoFrame>* sink) override;
+
  protected:
   virtual void OnCaptureResult(
       webrtc::DesktopCapturer::Result result,
       std::unique_ptr<webrtc::DesktopFrame> frame) override;
 
+  // DesktopCaptureService::Client
+  void OnCaptureTick() override;
+
+  // webrtc::MouseCursorMonitor::Callback
+  void OnMouseCursor(webrtc::MouseCursor* cursor) override;
+  void OnMouseCursorPosition(const webrtc::DesktopVector& position) override;
+
  private:
-  void CaptureFrame();
+  // Creates the capturer, and the cursor monitor, for |cursor_mode_|.
+  void CreateCapturer();
+  // Reports the capture to the scheduler and schedules the next tick.
+  void FinishCapture(bool changed);
+  // Converts |crop_rect| of |frame| at |output_size| and sends it, on
+  // |convert_thread_|. Returns true if a new frame was sent.
+  bool ConvertFrame(std::unique_ptr<webrtc::DesktopFrame> frame,
+                    const webrtc::DesktopRect& crop_rect,
+                    const webrtc::DesktopSize& output_size,
+                    bool full);
+  void CaptureCursor();
+  void NotifyCursorShape();
+  void UpdateSinkWants();
+  // The part of a frame of |frame_size| that is sent.
+  webrtc::DesktopRect CropRect(const webrtc::DesktopSize& frame_size) const;
+  // The size |crop_rect| is sent at.
+  webrtc::DesktopSize OutputSize(const webrtc::DesktopRect& crop_rect) const;
+  // Maps |rect|, in output coordinates, to whole chroma blocks of an output
+  // of |size|.
+  bool AlignRect(const webrtc::DesktopRect& rect,
+                 const webrtc::DesktopSize& size,
+                 webrtc::DesktopRect* aligned) const;
+  // Scales the |crop_rect| of |frame| into |rect| of scaled_frame_, and
+  // returns the part of scaled_frame_ written.
+  webrtc::DesktopRect ScaleRect(const webrtc::DesktopFrame& frame,
+                                const webrtc::DesktopRect& crop_rect,
+                                const webrtc::DesktopRect& rect);
+  // Converts |rect|, in output coordinates, of the ARGB |frame| at |origin|
+  // into |buffer|.
+  void ConvertRect(const webrtc::DesktopFrame& frame,
+                   const webrtc::DesktopVector& origin,
+                   const webrtc::DesktopRect& rect,
+                   webrtc::I420Buffer* buffer);
+  // Copies |rect|, in output coordinates, of the previous frame |src|.
+  void CopyRect(const webrtc::I420Buffer& src,
+                const webrtc::DesktopRect& rect,
+                webrtc::I420Buffer* buffer);
   webrtc::DesktopCaptureOptions options_;
   std::unique_ptr<webrtc::DesktopCapturer> capturer_;
-  std::unique_ptr<rtc::Thread> thread_;
+  CursorMode cursor_mode_ = CM_COMPOSITED;
+  std::unique_ptr<webrtc::MouseCursorMonitor> cursor_monitor_;
+  DesktopCursorObserver* cursor_observer_ = nullptr;
+  // The last cursor shape.
+  std::unique_ptr<webrtc::MouseCursor> cursor_;
+  // The crop rect and output size of the last frame, to map the cursor.
+  webrtc::DesktopRect cursor_crop_rect_;
+  webrtc::DesktopSize cursor_output_size_;
+  bool cursor_position_sent_ = false;
+  int cursor_x_ = 0;
+  int cursor_y_ = 0;
+  bool cursor_visible_ = false;
+  std::shared_ptr<DesktopCaptureService> service_;
+  // Shared with the other capturers.
+  rtc::Thread* thread_;
+  rtc::Thread* convert_thread_;
+  rtc::scoped_refptr<webrtc::PendingTaskSafetyFlag> safety_flag_;
+  // Cancels the cursor polling of one Start() when it is stopped.
+  rtc::scoped_refptr<webrtc::PendingTaskSafetyFlag> cursor_safety_flag_;
+  // Set once |capturer_| has been started, it cannot be started again.
+  bool capturer_started_ = false;
+  // Set when the next frame must be converted in full.
+  bool full_conversion_ = true;
+  // Set while the last captured frame is being converted.
+  bool converting_ = false;
+  int64_t capture_start_us_ = 0;
+  // Used on |convert_thread_|, one frame at a time.
+  I420BufferPool buffer_pool_;
+  // The crop rect scaled to the output size, when they differ. Kept between
+  // frames so that only the damaged part is scaled again.
+  std::unique_ptr<webrtc::DesktopFrame> scaled_frame_;
+  // The last frame sent, never written again.
   rtc::scoped_refptr<webrtc::I420Buffer> i420_buffer_;
+  // For each pooled buffer, the region written into the frames sent since
+  // it was last written, in output coordinates. A buffer missing here is
+  // copied in full.
+  std::map<const webrtc::I420Buffer*, webrtc::DesktopRegion> stale_regions_;
+  webrtc::DesktopSize last_frame_size_;
+  int64_t last_frame_ms_ = 0;
   CaptureState capture_state_ = CS_STOPPED;
   DesktopType type_;
   webrtc::DesktopCapturer::SourceId source_id_;
   DesktopCapturerObserver* observer_ = nullptr;
-  uint32_t capture_delay_ = 1000;  // 1s
+  DesktopCaptureScheduler scheduler_;
   webrtc::DesktopCapturer::Result result_ =
       webrtc::DesktopCapturer::Result::SUCCESS;
   rtc::Thread* signaling_thread_ = nullptr;
@@ -86,6 +196,9 @@ class RTCDesktopCapturerImpl : public RTCDesktopCapturer,
   uint32_t y_ = 0;
   uint32_t w_ = 0;
   uint32_t h_ = 0;
+  uint32_t output_width_ = 0;
+  uint32_t output_height_ = 0;
+  ScalingPolicy scaling_policy_ = SP_FIT;
 };
 
 }  // namespace libwebrtc
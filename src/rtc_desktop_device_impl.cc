@@ -3,6 +3,7 @@
 #include "rtc_desktop_capturer.h"
 #include "rtc_desktop_media_list.h"
 #include "rtc_video_device_impl.h"
+#include "rtc_virtual_desktop_impl.h"
 
 namespace libwebrtc {
 
@@ -13,6 +14,10 @@ RTCDesktopDeviceImpl::~RTCDesktopDeviceImpl() {}
 
 scoped_refptr<RTCDesktopCapturer> RTCDesktopDeviceImpl::CreateDesktopCapturer(
     scoped_refptr<MediaSource> source) {
+  if (source->type() == kVirtual) {
+    return new RefCountedObject<RTCDesktopCapturerImpl>(
+        kVirtual, -1, signaling_thread_, source);
+  }
   MediaSourceImpl* source_impl = static_cast<MediaSourceImpl*>(source.get());
   return new RefCountedObject<RTCDesktopCapturerImpl>(
       source_impl->type(), source_impl->source_id(), signaling_thread_, source);
@@ -20,6 +25,10 @@ scoped_refptr<RTCDesktopCapturer> RTCDesktopDeviceImpl::CreateDesktopCapturer(
 
 scoped_refptr<RTCDesktopMediaList> RTCDesktopDeviceImpl::GetDesktopMediaList(
     DesktopType type) {
+  // Virtual desktops are created by the application, not enumerated.
+  if (type == kVirtual) {
+    return nullptr;
+  }
   if (desktop_media_lists_.find(type) == desktop_media_lists_.end()) {
     desktop_media_lists_[type] =
         new RefCountedObject<RTCDesktopMediaListImpl>(type, signaling_thread_);
@@ -27,4 +36,21 @@ scoped_refptr<RTCDesktopMediaList> RTCDesktopDeviceImpl::GetDesktopMediaList(
   return desktop_media_lists_[type];
 }
 
+scoped_refptr<RTCVirtualDesktop> RTCDesktopDeviceImpl::CreateVirtualDesktop(
+    int fd,
+    uint64_t offset,
+    int width,
+    int height,
+    int stride) {
+  return RTCVirtualDesktopImpl::CreateFromFd(fd, offset, width, height, stride);
+}
+
+scoped_refptr<RTCVirtualDesktop> RTCDesktopDeviceImpl::CreateVirtualDesktop(
+    const uint8_t* data,
+    int width,
+    int height,
+    int stride) {
+  return RTCVirtualDesktopImpl::CreateFromMemory(data, width, height, stride);
+}
+
 }  // namespace libwebrtc
@@ -26,6 +26,17 @@ class RTCDesktopDeviceImpl : public RTCDesktopDevice {
   scoped_refptr<RTCDesktopMediaList> GetDesktopMediaList(
       DesktopType type) override;
 
+  scoped_refptr<RTCVirtualDesktop> CreateVirtualDesktop(int fd,
+                                                        uint64_t offset,
+                                                        int width,
+                                                        int height,
+                                                        int stride) override;
+
+  scoped_refptr<RTCVirtualDesktop> CreateVirtualDesktop(const uint8_t* data,
+                                                        int width,
+                                                        int height,
+                                                        int stride) override;
+
  private:
   rtc::Thread* signaling_thread_ = nullptr;
   std::map<DesktopType, scoped_refptr<RTCDesktopMediaListImpl>>
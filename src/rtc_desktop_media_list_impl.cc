@@ -15,19 +15,41 @@
  */
 
 #include "rtc_desktop_media_list_impl.h"
-#include "internal/jpeg_util.h"
 #include "rtc_base/checks.h"
+#include "system_wrappers/include/cpu_info.h"
 #include "third_party/libyuv/include/libyuv.h"
 
 #ifdef WEBRTC_WIN
 #include "modules/desktop_capture/win/window_capture_utils.h"
 #endif
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <unordered_map>
 
 namespace libwebrtc {
 
+// Sources are captured one at a time, and their thumbnails are encoded on
+// up to this many threads while the next source is captured.
+const int kMaxThumbnailWorkers = 4;
+
+const int kThumbnailQuality = 75;
+
+namespace {
+
+uint32_t HashFrame(const webrtc::DesktopFrame& frame) {
+  uint32_t hash = 5381;
+  for (int y = 0; y < frame.size().height(); y++) {
+    hash = libyuv::HashDjb2(
+        frame.GetFrameDataAtPos(webrtc::DesktopVector(0, y)),
+        frame.size().width() * webrtc::DesktopFrame::kBytesPerPixel, hash);
+  }
+  return hash;
+}
+
+}  // namespace
+
 RTCDesktopMediaListImpl::RTCDesktopMediaListImpl(DesktopType type,
                                                  rtc::Thread* signaling_thread)
     : thread_(rtc::Thread::Create()),
@@ -35,6 +57,16 @@ RTCDesktopMediaListImpl::RTCDesktopMediaListImpl(DesktopType type,
       signaling_thread_(signaling_thread) {
   RTC_DCHECK(thread_);
   thread_->Start();
+  int cores = static_cast<int>(webrtc::CpuInfo::DetectNumberOfCores());
+  int num_workers = std::max(1, std::min(kMaxThumbnailWorkers, cores - 1));
+  for (int i = 0; i < num_workers; i++) {
+    std::unique_ptr<ThumbnailWorker> worker(new ThumbnailWorker());
+    worker->thread = rtc::Thread::Create();
+    worker->thread->SetName("thumbnail_worker_thread", nullptr);
+    RTC_CHECK(worker->thread->Start()) << "Failed to start thread";
+    idle_workers_.push_back(worker.get());
+    workers_.push_back(std::move(worker));
+  }
   options_ = webrtc::DesktopCaptureOptions::CreateDefault();
   options_.set_detect_updated_region(true);
 #ifdef WEBRTC_WIN
@@ -58,207 +90,330 @@ RTCDesktopMediaListImpl::RTCDesktopMediaListImpl(DesktopType type,
 
 RTCDesktopMediaListImpl::~RTCDesktopMediaListImpl() {
   thread_->Stop();
+  for (auto& worker : workers_) {
+    worker->thread->Stop();
+  }
 }
 
 int32_t RTCDesktopMediaListImpl::UpdateSourceList(bool force_reload,
-                                                  bool get_thumbnail) {
-  if (force_reload) {
-    for (auto source : sources_) {
-      if (observer_) {
-        auto source_ptr = source.get();
-        signaling_thread_->BlockingCall([&, source_ptr]() {
-          observer_->OnMediaSourceRemoved(source_ptr);
-        });
-      }
-    }
-    sources_.clear();
-  }
+                                                  bool get_thumbnail,
+                                                  uint32_t thumbnail_width,
+                                                  uint32_t thumbnail_height) {
+  thumbnail_width_ = thumbnail_width;
+  thumbnail_height_ = thumbnail_height;
 
   webrtc::DesktopCapturer::SourceList new_sources;
   thread_->BlockingCall([this, &new_sources] {
     capturer_->GetSourceList(&new_sources);
   });
 
-  typedef std::set<webrtc::DesktopCapturer::SourceId> SourceSet;
-  SourceSet new_source_set;
+  std::vector<scoped_refptr<MediaSourceImpl>> removed;
+  std::unordered_map<webrtc::DesktopCapturer::SourceId,
+                     scoped_refptr<MediaSourceImpl>>
+      old_sources;
+  if (force_reload) {
+    removed = std::move(sources_);
+    webrtc::MutexLock lock(&cache_mutex_);
+    thumbnail_cache_.clear();
+  } else {
+    old_sources.reserve(sources_.size());
+    for (auto& source : sources_) {
+      old_sources.emplace(source->source_id(), source);
+    }
+  }
+
+  // Keep the sources that are still listed, in the new order.
+  std::vector<scoped_refptr<MediaSourceImpl>> sources;
+  std::vector<scoped_refptr<MediaSourceImpl>> added;
+  std::vector<scoped_refptr<MediaSourceImpl>> renamed;
+  sources.reserve(new_sources.size());
   for (size_t i = 0; i < new_sources.size(); ++i) {
     if (type_ == kScreen && new_sources[i].title.length() == 0) {
       new_sources[i].title = std::string("Screen " + std::to_string(i + 1));
     }
-    new_source_set.insert(new_sources[i].id);
-  }
-  // Iterate through the old sources to find the removed sources.
-  for (size_t i = 0; i < sources_.size(); ++i) {
-    if (new_source_set.find(sources_[i]->source_id()) == new_source_set.end()) {
-      if (observer_) {
-        auto source = (*(sources_.begin() + i)).get();
-        signaling_thread_->BlockingCall([&, source]() {
-          observer_->OnMediaSourceRemoved(source);
-        });
-      }
-      sources_.erase(sources_.begin() + i);
-      --i;
-    }
-  }
-  // Iterate through the new sources to find the added sources.
-  if (new_sources.size() > sources_.size()) {
-    SourceSet old_source_set;
-    for (size_t i = 0; i < sources_.size(); ++i) {
-      old_source_set.insert(sources_[i]->source_id());
+    auto it = old_sources.find(new_sources[i].id);
+    if (it == old_sources.end()) {
+      auto source =
+          new RefCountedObject<MediaSourceImpl>(this, new_sources[i], type_);
+      sources.push_back(source);
+      added.push_back(source);
+      continue;
     }
-    for (size_t i = 0; i < new_sources.size(); ++i) {
-      if (old_source_set.find(new_sources[i].id) == old_source_set.end()) {
-        auto source =
-            new RefCountedObject<MediaSourceImpl>(this, new_sources[i], type_);
-        sources_.insert(sources_.begin() + i, source);
-        GetThumbnail(source, true);
-        if (observer_) {
-          signaling_thread_->BlockingCall([&, source]() {
-            observer_->OnMediaSourceAdded(source);
-          });
-        }
-      }
+    scoped_refptr<MediaSourceImpl> source = it->second;
+    old_sources.erase(it);
+    if (source->source.title != new_sources[i].title) {
+      source->source.title = new_sources[i].title;
+      // A new title usually means new content.
+      InvalidateThumbnail(source->source_id());
+      renamed.push_back(source);
     }
+    sources.push_back(source);
+  }
+  for (auto& it : old_sources) {
+    InvalidateThumbnail(it.first);
+    removed.push_back(it.second);
   }
+  sources_ = std::move(sources);
 
-  RTC_DCHECK_EQ(new_sources.size(), sources_.size());
-
-  // Find the moved/changed sources.
-  size_t pos = 0;
-  while (pos < sources_.size()) {
-    if (!(sources_[pos]->source_id() == new_sources[pos].id)) {
-      // Find the source that should be moved to |pos|, starting from |pos + 1|
-      // of |sources_|, because entries before |pos| should have been sorted.
-      size_t old_pos = pos + 1;
-      for (; old_pos < sources_.size(); ++old_pos) {
-        if (sources_[old_pos]->source_id() == new_sources[pos].id)
-          break;
+  if (observer_ && (!removed.empty() || !added.empty() || !renamed.empty())) {
+    signaling_thread_->BlockingCall([&]() {
+      for (auto& source : removed) {
+        observer_->OnMediaSourceRemoved(source);
       }
-      RTC_DCHECK(sources_[old_pos]->source_id() == new_sources[pos].id);
-
-      // Move the source from |old_pos| to |pos|.
-      auto temp = sources_[old_pos];
-      sources_.erase(sources_.begin() + old_pos);
-      sources_.insert(sources_.begin() + pos, temp);
-      // if(observer_) observer_->OnMediaSourceMoved:old_pos newIndex:pos];
-    }
-
-    if (sources_[pos]->source.title != new_sources[pos].title) {
-      sources_[pos]->source.title = new_sources[pos].title;
-      if (observer_) {
-        auto source = sources_[pos].get();
-        signaling_thread_->BlockingCall([&, source]() {
-          observer_->OnMediaSourceNameChanged(source);
-        });
+      for (auto& source : added) {
+        observer_->OnMediaSourceAdded(source);
       }
-    }
-    ++pos;
+      for (auto& source : renamed) {
+        observer_->OnMediaSourceNameChanged(source);
+      }
+    });
   }
 
   if (get_thumbnail) {
-    for (auto source : sources_) {
-      GetThumbnail(source.get(), true);
+    for (auto& source : sources_) {
+      RequestThumbnail(source, true, thumbnail_width, thumbnail_height,
+                       false);
+    }
+  } else {
+    for (auto& source : added) {
+      RequestThumbnail(source, true, thumbnail_width, thumbnail_height,
+                       false);
     }
   }
   return sources_.size();
 }
 
 bool RTCDesktopMediaListImpl::GetThumbnail(scoped_refptr<MediaSource> source,
-                                           bool notify) {
-  thread_->PostTask([this, source, notify] {
-    MediaSourceImpl* source_impl = static_cast<MediaSourceImpl*>(source.get());
-    if (capturer_->SelectSource(source_impl->source_id())) {
-      callback_->SetCallback([&](webrtc::DesktopCapturer::Result result,
-                                 std::unique_ptr<webrtc::DesktopFrame> frame) {
-        auto old_thumbnail = source_impl->thumbnail();
-        source_impl->SaveCaptureResult(result, std::move(frame));
-        if (observer_ && notify) {
-          signaling_thread_->BlockingCall([&, source_impl]() {
-            observer_->OnMediaSourceThumbnailChanged(source_impl);
-          });
-        }
-      });
-      capturer_->CaptureFrame();
+                                           bool notify,
+                                           uint32_t thumbnail_width,
+                                           uint32_t thumbnail_height) {
+  RequestThumbnail(static_cast<MediaSourceImpl*>(source.get()), notify,
+                   thumbnail_width, thumbnail_height, true);
+  return true;
+}
+
+void RTCDesktopMediaListImpl::RequestThumbnail(
+    scoped_refptr<MediaSourceImpl> source,
+    bool notify,
+    uint32_t thumbnail_width,
+    uint32_t thumbnail_height,
+    bool explicit_request) {
+  thread_->PostTask([this, source, notify, thumbnail_width, thumbnail_height,
+                     explicit_request] {
+    const webrtc::DesktopCapturer::SourceId id = source->source_id();
+    if (!capturer_->SelectSource(id)) {
+      return;
+    }
+    std::unique_ptr<webrtc::DesktopFrame> captured;
+    callback_->SetCallback([&](webrtc::DesktopCapturer::Result result,
+                               std::unique_ptr<webrtc::DesktopFrame> frame) {
+      if (result == webrtc::DesktopCapturer::Result::SUCCESS) {
+        captured = std::move(frame);
+      }
+    });
+    capturer_->CaptureFrame();
+    callback_->SetCallback(nullptr);
+    if (!captured) {
+      return;
     }
+
+    // Capturers may reuse the frame for the next capture, so it is scaled
+    // here and only the small copy is handed to the worker.
+    ThumbnailWorker* worker = AcquireWorker();
+    if (!ScaleThumbnail(id, *captured, thumbnail_width, thumbnail_height,
+                        worker)) {
+      ReleaseWorker(worker);
+      return;
+    }
+
+    // The content hash is the change signal: every refresh captures and
+    // scales the source, but only a changed one is encoded again.
+    const uint32_t hash = HashFrame(*worker->scaled_frame);
+    bool unchanged = false;
+    {
+      webrtc::MutexLock lock(&cache_mutex_);
+      auto it = thumbnail_cache_.find(id);
+      if (it != thumbnail_cache_.end() &&
+          it->second.width == thumbnail_width &&
+          it->second.height == thumbnail_height && it->second.hash == hash &&
+          source->has_thumbnail()) {
+        unchanged = true;
+      }
+    }
+    if (unchanged) {
+      // The source keeps its thumbnail, only an explicit request is
+      // answered.
+      ReleaseWorker(worker);
+      if (observer_ && notify && explicit_request) {
+        signaling_thread_->BlockingCall([&]() {
+          observer_->OnMediaSourceThumbnailChanged(source);
+        });
+      }
+      return;
+    }
+
+    worker->thread->PostTask([this, worker, source, notify, thumbnail_width,
+                              thumbnail_height, hash] {
+      bool encoded = EncodeThumbnail(worker, &worker->jpeg);
+      if (encoded) {
+        // Hand the encoded image over without a copy, the previous thumbnail
+        // becomes the output buffer of the next one.
+        source->swap_thumbnail(&worker->jpeg);
+      }
+      ReleaseWorker(worker);
+      if (!encoded) {
+        return;
+      }
+      {
+        webrtc::MutexLock lock(&cache_mutex_);
+        ThumbnailCacheEntry& entry = thumbnail_cache_[source->source_id()];
+        entry.width = thumbnail_width;
+        entry.height = thumbnail_height;
+        entry.hash = hash;
+      }
+      if (observer_ && notify) {
+        signaling_thread_->BlockingCall([&]() {
+          observer_->OnMediaSourceThumbnailChanged(source);
+        });
+      }
+    });
   });
-  return true;
 }
 
-int RTCDesktopMediaListImpl::GetSourceCount() const {
-  return sources_.size();
+void RTCDesktopMediaListImpl::InvalidateThumbnail(
+    webrtc::DesktopCapturer::SourceId id) {
+  webrtc::MutexLock lock(&cache_mutex_);
+  thumbnail_cache_.erase(id);
 }
 
-scoped_refptr<MediaSource> RTCDesktopMediaListImpl::GetSource(int index) {
-  return sources_[index];
+RTCDesktopMediaListImpl::ThumbnailWorker*
+RTCDesktopMediaListImpl::AcquireWorker() {
+  while (true) {
+    {
+      webrtc::MutexLock lock(&workers_mutex_);
+      if (!idle_workers_.empty()) {
+        ThumbnailWorker* worker = idle_workers_.back();
+        idle_workers_.pop_back();
+        return worker;
+      }
+    }
+    worker_idle_.Wait(rtc::Event::kForever);
+  }
 }
 
-bool MediaSourceImpl::UpdateThumbnail() {
-  return mediaList_->GetThumbnail(this);
+void RTCDesktopMediaListImpl::ReleaseWorker(ThumbnailWorker* worker) {
+  {
+    webrtc::MutexLock lock(&workers_mutex_);
+    idle_workers_.push_back(worker);
+  }
+  worker_idle_.Set();
 }
 
 #ifdef WEBRTC_WIN
 extern int filterException(int code, PEXCEPTION_POINTERS ex);
 #endif
 
-void MediaSourceImpl::SaveCaptureResult(
-    webrtc::DesktopCapturer::Result result,
-    std::unique_ptr<webrtc::DesktopFrame> frame) {
-  if (result != webrtc::DesktopCapturer::Result::SUCCESS) {
-    return;
-  }
-
-  int width = frame->size().width();
-  int height = frame->size().height();
+bool RTCDesktopMediaListImpl::ScaleThumbnail(
+    webrtc::DesktopCapturer::SourceId id,
+    const webrtc::DesktopFrame& frame,
+    uint32_t max_width,
+    uint32_t max_height,
+    ThumbnailWorker* worker) {
+  int64_t src_width = frame.size().width();
+  int64_t src_height = frame.size().height();
 #ifdef WEBRTC_WIN
-  webrtc::DesktopRect rect_ = webrtc::DesktopRect::MakeWH(width, height);
-
   if (type_ != kScreen) {
-    webrtc::GetWindowRect(reinterpret_cast<HWND>(source_id()), &rect_);
+    // Window frames are cropped to the window rect before scaling, as they
+    // are for capture, so the non-client area stays out of the thumbnail.
+    webrtc::DesktopRect rect = webrtc::DesktopRect::MakeSize(frame.size());
+    webrtc::GetWindowRect(reinterpret_cast<HWND>(id), &rect);
+    src_width = std::min<int64_t>(src_width, rect.width());
+    src_height = std::min<int64_t>(src_height, rect.height());
   }
-
-  __try
 #endif
-  {
+  if (src_width <= 0 || src_height <= 0) {
+    return false;
+  }
 
-    if (!i420_buffer_ || !i420_buffer_.get() ||
-        i420_buffer_->width() * i420_buffer_->height() != width * height) {
-      i420_buffer_ = webrtc::I420Buffer::Create(width, height);
+  // Fit within the thumbnail size, keeping the aspect ratio.
+  int64_t width = src_width;
+  int64_t height = src_height;
+  if (max_width > 0 && max_height > 0 &&
+      (width > max_width || height > max_height)) {
+    if (src_width * max_height > src_height * max_width) {
+      width = max_width;
+      height = std::max<int64_t>(1, src_height * max_width / src_width);
+    } else {
+      height = max_height;
+      width = std::max<int64_t>(1, src_width * max_height / src_height);
     }
+  }
+
+  webrtc::DesktopSize size(static_cast<int>(width), static_cast<int>(height));
+  if (!worker->scaled_frame || !worker->scaled_frame->size().equals(size)) {
+    worker->scaled_frame.reset(new webrtc::BasicDesktopFrame(size));
+  }
 
-    libyuv::ConvertToI420(frame->data(), 0, i420_buffer_->MutableDataY(),
-                          i420_buffer_->StrideY(), i420_buffer_->MutableDataU(),
-                          i420_buffer_->StrideU(), i420_buffer_->MutableDataV(),
-                          i420_buffer_->StrideV(), 0, 0,
+  bool scaled = false;
 #ifdef WEBRTC_WIN
-                          rect_.width(), rect_.height(),
-#else
-                          width, height,
+  __try
 #endif
-                          width, height, libyuv::kRotate0, libyuv::FOURCC_ARGB);
-
-    webrtc::VideoFrame input_frame(i420_buffer_, 0, 0,
-                                   webrtc::kVideoRotation_0);
-
-    const int kColorPlanes = 3;  // R, G and B.
-    size_t rgb_len = input_frame.height() * input_frame.width() * kColorPlanes;
-    std::unique_ptr<uint8_t[]> rgb_buf(new uint8_t[rgb_len]);
-
-    // kRGB24 actually corresponds to FourCC 24BG which is 24-bit BGR.
-    if (ConvertFromI420(input_frame, webrtc::VideoType::kRGB24, 0,
-                        rgb_buf.get()) < 0) {
-      RTC_LOG(LS_ERROR) << "Could not convert input frame to RGB.";
-      return;
-    }
-
-    // Create a thumbnail image from the captured frame.
-    thumbnail_ = EncodeRGBToJpeg((const unsigned char*)rgb_buf.get(),
-                                 input_frame.width(), input_frame.height(),
-                                 kColorPlanes, 75);
+  {
+    // Box filtering reads every source pixel once, straight from the
+    // captured ARGB.
+    scaled = libyuv::ARGBScale(frame.data(), frame.stride(),
+                               static_cast<int>(src_width),
+                               static_cast<int>(src_height),
+                               worker->scaled_frame->data(),
+                               worker->scaled_frame->stride(), size.width(),
+                               size.height(), libyuv::kFilterBox) == 0;
   }
 #ifdef WEBRTC_WIN
   __except (filterException(GetExceptionCode(), GetExceptionInformation())) {
   }
 #endif
+  return scaled;
+}
+
+bool RTCDesktopMediaListImpl::EncodeThumbnail(
+    ThumbnailWorker* worker,
+    std::vector<unsigned char>* jpeg) {
+  const webrtc::DesktopFrame& frame = *worker->scaled_frame;
+  const int width = frame.size().width();
+  const int height = frame.size().height();
+  rtc::scoped_refptr<webrtc::I420Buffer> i420_buffer =
+      worker->buffer_pool.CreateBuffer(width, height);
+  libyuv::ARGBToI420(frame.data(), frame.stride(), i420_buffer->MutableDataY(),
+                     i420_buffer->StrideY(), i420_buffer->MutableDataU(),
+                     i420_buffer->StrideU(), i420_buffer->MutableDataV(),
+                     i420_buffer->StrideV(), width, height);
+
+  return worker->encoder.EncodeI420(
+      i420_buffer->DataY(), i420_buffer->StrideY(), i420_buffer->DataU(),
+      i420_buffer->StrideU(), i420_buffer->DataV(), i420_buffer->StrideV(),
+      width, height, kThumbnailQuality, jpeg);
+}
+
+RTCFrameBufferPoolStats RTCDesktopMediaListImpl::buffer_pool_stats() {
+  RTCFrameBufferPoolStats stats;
+  for (auto& worker : workers_) {
+    stats.hits += worker->buffer_pool.hits();
+    stats.misses += worker->buffer_pool.misses();
+  }
+  return stats;
+}
+
+int RTCDesktopMediaListImpl::GetSourceCount() const {
+  return sources_.size();
+}
+
+scoped_refptr<MediaSource> RTCDesktopMediaListImpl::GetSource(int index) {
+  return sources_[index];
+}
+
+bool MediaSourceImpl::UpdateThumbnail() {
+  return mediaList_->GetThumbnail(this, false, mediaList_->thumbnail_width(),
+                                  mediaList_->thumbnail_height());
 }
 
 }  // namespace libwebrtc
@@ -17,12 +17,18 @@
 #ifndef LIBWEBRTC_RTC_DESKTOP_MEDIA_LIST_IMPL_HXX
 #define LIBWEBRTC_RTC_DESKTOP_MEDIA_LIST_IMPL_HXX
 
+#include <unordered_map>
+
 #include "api/video/i420_buffer.h"
 #include "api/video/video_frame.h"
 #include "modules/desktop_capture/desktop_capture_options.h"
 #include "modules/desktop_capture/desktop_capturer.h"
 #include "modules/desktop_capture/desktop_frame.h"
+#include "rtc_base/event.h"
+#include "rtc_base/synchronization/mutex.h"
 #include "rtc_base/thread.h"
+#include "src/internal/i420_buffer_pool.h"
+#include "src/internal/jpeg_util.h"
 
 #include "rtc_desktop_capturer_impl.h"
 #include "rtc_desktop_media_list.h"
@@ -53,6 +59,7 @@ class MediaSourceImpl : public MediaSource {
 
   // Returns the thumbnail of the source, jpeg format.
   portable::vector<unsigned char> thumbnail() const override {
+    webrtc::MutexLock lock(&mutex_);
     return thumbnail_;
   }
 
@@ -60,12 +67,20 @@ class MediaSourceImpl : public MediaSource {
 
   bool UpdateThumbnail() override;
 
-  void SaveCaptureResult(webrtc::DesktopCapturer::Result result,
-                         std::unique_ptr<webrtc::DesktopFrame> frame);
+  bool has_thumbnail() const {
+    webrtc::MutexLock lock(&mutex_);
+    return !thumbnail_.empty();
+  }
+
+  // Replaces the thumbnail with |thumbnail|, which gets the previous one.
+  void swap_thumbnail(std::vector<unsigned char>* thumbnail) {
+    webrtc::MutexLock lock(&mutex_);
+    thumbnail_.swap(*thumbnail);
+  }
 
  private:
-  std::vector<unsigned char> thumbnail_;
-  rtc::scoped_refptr<webrtc::I420Buffer> i420_buffer_;
+  mutable webrtc::Mutex mutex_;
+  std::vector<unsigned char> thumbnail_ RTC_GUARDED_BY(mutex_);
   RTCDesktopMediaListImpl* mediaList_;
   DesktopType type_;
 };
@@ -88,15 +103,69 @@ class RTCDesktopMediaListImpl : public RTCDesktopMediaList {
   DesktopType type() const override { return type_; }
 
   int32_t UpdateSourceList(bool force_reload = false,
-                           bool get_thumbnail = true) override;
+                           bool get_thumbnail = true,
+                           uint32_t thumbnail_width = 320,
+                           uint32_t thumbnail_height = 180) override;
 
   int GetSourceCount() const override;
 
   scoped_refptr<MediaSource> GetSource(int index) override;
 
   bool GetThumbnail(scoped_refptr<MediaSource> source,
-                    bool notify = false) override;
+                    bool notify = false,
+                    uint32_t thumbnail_width = 320,
+                    uint32_t thumbnail_height = 180) override;
+
+  RTCFrameBufferPoolStats buffer_pool_stats() override;
+
+  // The thumbnail size last passed to UpdateSourceList().
+  uint32_t thumbnail_width() const { return thumbnail_width_; }
+  uint32_t thumbnail_height() const { return thumbnail_height_; }
+
  private:
+  // Encodes thumbnails on its own thread, with buffers kept between them.
+  struct ThumbnailWorker {
+    ThumbnailWorker() : buffer_pool(1) {}
+    std::unique_ptr<rtc::Thread> thread;
+    I420BufferPool buffer_pool;
+    JpegEncoder encoder;
+    // The captured frame scaled to the thumbnail size.
+    std::unique_ptr<webrtc::DesktopFrame> scaled_frame;
+    // The encoder output, swapped with the thumbnail of the source.
+    std::vector<unsigned char> jpeg;
+  };
+
+  // What the thumbnail of a source was last encoded from.
+  struct ThumbnailCacheEntry {
+    // The requested bounds.
+    uint32_t width = 0;
+    uint32_t height = 0;
+    // Hash of the scaled frame.
+    uint32_t hash = 0;
+  };
+
+  // Captures a thumbnail of |source|. A source whose content did not change
+  // since its last thumbnail of the same size is not encoded again, and the
+  // observer hears about it only for an |explicit_request|.
+  void RequestThumbnail(scoped_refptr<MediaSourceImpl> source,
+                        bool notify,
+                        uint32_t thumbnail_width,
+                        uint32_t thumbnail_height,
+                        bool explicit_request);
+  void InvalidateThumbnail(webrtc::DesktopCapturer::SourceId id);
+  // Waits until a worker is idle and marks it busy.
+  ThumbnailWorker* AcquireWorker();
+  void ReleaseWorker(ThumbnailWorker* worker);
+  // Scales |frame| of the source |id| into the scaled frame of |worker|.
+  bool ScaleThumbnail(webrtc::DesktopCapturer::SourceId id,
+                      const webrtc::DesktopFrame& frame,
+                      uint32_t max_width,
+                      uint32_t max_height,
+                      ThumbnailWorker* worker);
+  // Encodes the scaled frame of |worker|, on the worker thread.
+  bool EncodeThumbnail(ThumbnailWorker* worker,
+                       std::vector<unsigned char>* jpeg);
+
   class CallbackProxy : public webrtc::DesktopCapturer::Callback {
    public:
     CallbackProxy() {}
@@ -123,6 +192,15 @@ class RTCDesktopMediaListImpl : public RTCDesktopMediaList {
   webrtc::DesktopCaptureOptions options_;
   std::unique_ptr<webrtc::DesktopCapturer> capturer_;
   std::unique_ptr<rtc::Thread> thread_;
+  std::vector<std::unique_ptr<ThumbnailWorker>> workers_;
+  webrtc::Mutex workers_mutex_;
+  std::vector<ThumbnailWorker*> idle_workers_ RTC_GUARDED_BY(workers_mutex_);
+  rtc::Event worker_idle_;
+  uint32_t thumbnail_width_ = 320;
+  uint32_t thumbnail_height_ = 180;
+  webrtc::Mutex cache_mutex_;
+  std::unordered_map<webrtc::DesktopCapturer::SourceId, ThumbnailCacheEntry>
+      thumbnail_cache_ RTC_GUARDED_BY(cache_mutex_);
   std::vector<scoped_refptr<MediaSourceImpl>> sources_;
   MediaListObserver* observer_ = nullptr;
   DesktopType type_;
@@ -49,11 +49,12 @@ RTCFrameCryptorImpl::RTCFrameCryptorImpl(
       impl->rtc_rtp_sender()->track()->kind() == "audio"
           ? webrtc::FrameCryptorTransformer::MediaType::kAudioFrame
           : webrtc::FrameCryptorTransformer::MediaType::kVideoFrame;
-  e2ee_transformer_ = rtc::scoped_refptr<webrtc::FrameCryptorTransformer>(
-      new webrtc::FrameCryptorTransformer(
-          participant_id_.std_string(), mediaType,
-          AlgorithmToFrameCryptorAlgorithm(algorithm),
-          keyImpl->rtc_key_provider()));
+  e2ee_transformer_ = rtc::scoped_refptr<FrameCryptorEngine>(
+      new FrameCryptorEngine(participant_id_.std_string(), mediaType,
+                             AlgorithmToFrameCryptorAlgorithm(algorithm),
+                             keyImpl->rtc_key_provider(),
+                             keyImpl->uncrypted_magic_bytes(),
+                             keyImpl->ratchet_cache()));
   e2ee_transformer_->SetFrameCryptorTransformerObserver(this);
   impl->rtc_rtp_sender()->SetEncoderToPacketizerFrameTransformer(
       e2ee_transformer_);
@@ -76,18 +77,21 @@ RTCFrameCryptorImpl::RTCFrameCryptorImpl(
       impl->rtp_receiver()->track()->kind() == "audio"
           ? webrtc::FrameCryptorTransformer::MediaType::kAudioFrame
           : webrtc::FrameCryptorTransformer::MediaType::kVideoFrame;
-  e2ee_transformer_ = rtc::scoped_refptr<webrtc::FrameCryptorTransformer>(
-      new webrtc::FrameCryptorTransformer(
-          participant_id_.std_string(), mediaType,
-          AlgorithmToFrameCryptorAlgorithm(algorithm),
-          keyImpl->rtc_key_provider()));
+  e2ee_transformer_ = rtc::scoped_refptr<FrameCryptorEngine>(
+      new FrameCryptorEngine(participant_id_.std_string(), mediaType,
+                             AlgorithmToFrameCryptorAlgorithm(algorithm),
+                             keyImpl->rtc_key_provider(),
+                             keyImpl->uncrypted_magic_bytes(),
+                             keyImpl->ratchet_cache()));
   e2ee_transformer_->SetFrameCryptorTransformerObserver(this);
   impl->rtp_receiver()->SetDepacketizerToDecoderFrameTransformer(
       e2ee_transformer_);
   e2ee_transformer_->SetEnabled(false);
 }
 
-RTCFrameCryptorImpl::~RTCFrameCryptorImpl() {}
+RTCFrameCryptorImpl::~RTCFrameCryptorImpl() {
+  e2ee_transformer_->SetFrameCryptorTransformerObserver(nullptr);
+}
 
 bool RTCFrameCryptorImpl::SetEnabled(bool enabled) {
   webrtc::MutexLock lock(&mutex_);
@@ -103,8 +107,11 @@ void RTCFrameCryptorImpl::RegisterRTCFrameCryptorObserver(
 }
 
 void RTCFrameCryptorImpl::DeRegisterRTCFrameCryptorObserver() {
-  webrtc::MutexLock lock(&mutex_);
-  observer_ = nullptr;
+  {
+    webrtc::MutexLock lock(&mutex_);
+    observer_ = nullptr;
+  }
+  // The engine reports under its own lock, which is taken before ours.
   e2ee_transformer_->SetFrameCryptorTransformerObserver(nullptr);
 }
 
@@ -9,10 +9,17 @@
 #include "api/rtp_receiver_interface.h"
 #include "api/rtp_sender_interface.h"
 
+#include <set>
+#include <string>
+
+#include "src/internal/frame_cryptor_engine.h"
+#include "src/internal/key_ratchet_cache.h"
+
 namespace libwebrtc {
 class DefaultKeyProviderImpl : public KeyProvider {
  public:
-  DefaultKeyProviderImpl(KeyProviderOptions* options) {
+  DefaultKeyProviderImpl(KeyProviderOptions* options)
+      : uncrypted_magic_bytes_(options->uncrypted_magic_bytes.std_vector()) {
     webrtc::KeyProviderOptions rtc_options;
     rtc_options.shared_key = options->shared_key;
     rtc_options.ratchet_salt = options->ratchet_salt.std_vector();
@@ -21,17 +28,57 @@ class DefaultKeyProviderImpl : public KeyProvider {
     rtc_options.ratchet_window_size = options->ratchet_window_size;
     impl_ =
         new rtc::RefCountedObject<webrtc::DefaultKeyProviderImpl>(rtc_options);
+    if (rtc_options.ratchet_window_size > 0) {
+      ratchet_cache_ = std::make_shared<KeyRatchetCache>(
+          rtc_options.ratchet_window_size, rtc_options.ratchet_salt);
+    }
   }
   ~DefaultKeyProviderImpl() {}
   /// Set the key at the given index.
   bool SetKey(const string participant_id,
               int index,
               vector<uint8_t> key) override {
+    if (ratchet_cache_) {
+      ratchet_cache_->Invalidate(participant_id.std_string());
+    }
     return impl_->SetKey(participant_id.std_string(), index, key.std_vector());
   }
 
+  int SetKeys(const vector<ParticipantKey> keys) override {
+    // The ring of a participant is dropped once, however many of its key
+    // indices change.
+    std::set<std::string> participants;
+    for (size_t i = 0; i < keys.size(); i++) {
+      participants.insert(keys[i].participant_id.std_string());
+    }
+    if (ratchet_cache_) {
+      for (const std::string& participant_id : participants) {
+        ratchet_cache_->Invalidate(participant_id);
+      }
+    }
+    int count = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+      const ParticipantKey& key = keys[i];
+      if (impl_->SetKey(key.participant_id.std_string(), key.index,
+                        key.key.std_vector())) {
+        count++;
+      }
+    }
+    return count;
+  }
+
   vector<uint8_t> RatchetKey(const string participant_id,
                              int key_index) override {
+    if (ratchet_cache_) {
+      // Takes the next step of the ring, derived ahead by a receiver that
+      // already tried it, and keeps the steps past it.
+      std::shared_ptr<webrtc::ParticipantKeyHandler> handler =
+          impl_->GetKey(participant_id.std_string());
+      if (handler) {
+        return ratchet_cache_->Advance(participant_id.std_string(),
+                                       key_index, handler.get());
+      }
+    }
     return impl_->RatchetKey(participant_id.std_string(), key_index);
   }
 
@@ -42,8 +89,16 @@ class DefaultKeyProviderImpl : public KeyProvider {
 
   rtc::scoped_refptr<webrtc::KeyProvider> rtc_key_provider() { return impl_; }
 
+  const std::vector<uint8_t>& uncrypted_magic_bytes() const {
+    return uncrypted_magic_bytes_;
+  }
+
+  std::shared_ptr<KeyRatchetCache> ratchet_cache() { return ratchet_cache_; }
+
  private:
   rtc::scoped_refptr<webrtc::DefaultKeyProviderImpl> impl_;
+  std::vector<uint8_t> uncrypted_magic_bytes_;
+  std::shared_ptr<KeyRatchetCache> ratchet_cache_;
 };
 
 class RTCFrameCryptorImpl : public RTCFrameCryptor,
@@ -79,7 +134,7 @@ class RTCFrameCryptorImpl : public RTCFrameCryptor,
   mutable webrtc::Mutex mutex_;
   bool enabled_;
   int key_index_;
-  rtc::scoped_refptr<webrtc::FrameCryptorTransformer> e2ee_transformer_;
+  rtc::scoped_refptr<FrameCryptorEngine> e2ee_transformer_;
   scoped_refptr<KeyProvider> key_provider_;
   scoped_refptr<RTCRtpSender> sender_;
   scoped_refptr<RTCRtpReceiver> receiver_;
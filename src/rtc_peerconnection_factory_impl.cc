@@ -3,17 +3,25 @@
 #include "rtc_media_stream_impl.h"
 #include "rtc_mediaconstraints_impl.h"
 #include "rtc_peerconnection_impl.h"
+#include "rtc_peerconnection_pool_impl.h"
 #include "rtc_rtp_capabilities_impl.h"
 #include "rtc_video_device_impl.h"
 #include "rtc_video_source_impl.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "api/audio_codecs/builtin_audio_decoder_factory.h"
 #include "api/audio_codecs/builtin_audio_encoder_factory.h"
 #include "api/create_peerconnection_factory.h"
+#include "api/make_ref_counted.h"
 #include "api/media_stream_interface.h"
 #include "api/video_codecs/builtin_video_decoder_factory.h"
 #include "api/video_codecs/builtin_video_encoder_factory.h"
 #include "modules/audio_device/audio_device_impl.h"
+#include "modules/audio_device/include/test_audio_device.h"
+#include "modules/audio_processing/include/audio_processing.h"
+#include "rtc_base/logging.h"
 #if defined(USE_INTEL_MEDIA_SDK)
 #include "src/win/mediacapabilities.h"
 #include "src/win/msdkvideodecoderfactory.h"
@@ -42,7 +50,13 @@ std::unique_ptr<webrtc::VideoDecoderFactory> CreateIntelVideoDecoderFactory() {
 }
 #endif
 
-RTCPeerConnectionFactoryImpl::RTCPeerConnectionFactoryImpl() {}
+RTCPeerConnectionFactoryImpl::RTCPeerConnectionFactoryImpl()
+    : certificate_cache_(std::make_shared<CertificateCache>()) {}
+
+RTCPeerConnectionFactoryImpl::RTCPeerConnectionFactoryImpl(
+    const RTCAudioDeviceOptions& audio_options)
+    : audio_options_(audio_options),
+      certificate_cache_(std::make_shared<CertificateCache>()) {}
 
 RTCPeerConnectionFactoryImpl::~RTCPeerConnectionFactoryImpl() {}
 
@@ -64,6 +78,13 @@ bool RTCPeerConnectionFactoryImpl::Initialize() {
   }
 
   if (!rtc_peerconnection_factory_) {
+    // The processed microphone, metered for the audio level of senders.
+    capture_level_meter_ = std::make_shared<AudioLevelMeter>();
+    rtc::scoped_refptr<webrtc::AudioProcessing> audio_processing =
+        webrtc::AudioProcessingBuilder()
+            .SetCapturePostProcessing(
+                std::make_unique<CaptureLevelProcessor>(capture_level_meter_))
+            .Create();
     rtc_peerconnection_factory_ = webrtc::CreatePeerConnectionFactory(
         network_thread_.get(), worker_thread_.get(), signaling_thread_.get(),
         audio_device_module_, webrtc::CreateBuiltinAudioEncoderFactory(),
@@ -74,7 +95,7 @@ bool RTCPeerConnectionFactoryImpl::Initialize() {
         webrtc::CreateBuiltinVideoEncoderFactory(),
         webrtc::CreateBuiltinVideoDecoderFactory(),
 #endif
-        nullptr, nullptr);
+        nullptr, audio_processing);
   }
 
   if (!rtc_peerconnection_factory_.get()) {
@@ -86,6 +107,27 @@ bool RTCPeerConnectionFactoryImpl::Initialize() {
 }
 
 bool RTCPeerConnectionFactoryImpl::Terminate() {
+  // Pools stop refilling and hand their idle connections over, to be
+  // closed with the others below. A pool may be released concurrently, so
+  // it is only touched under |pools_mutex_|, and its connections are let go
+  // after the lock is released.
+  std::vector<scoped_refptr<RTCPeerConnection>> pooled;
+  {
+    webrtc::MutexLock lock(&pools_mutex_);
+    for (RTCPeerConnectionPoolImpl* pool : pools_) {
+      pool->TakeIdle(&pooled);
+    }
+  }
+  pooled.clear();
+  std::list<scoped_refptr<RTCPeerConnection>> peerconnections;
+  {
+    webrtc::MutexLock lock(&peerconnections_mutex_);
+    peerconnections.swap(peerconnections_);
+  }
+  for (auto peerconnection : peerconnections) {
+    peerconnection->Close();
+  }
+
   worker_thread_->BlockingCall([&] {
     audio_device_impl_ = nullptr;
     video_device_impl_ = nullptr;
@@ -99,13 +141,70 @@ bool RTCPeerConnectionFactoryImpl::Terminate() {
 }
 
 void RTCPeerConnectionFactoryImpl::CreateAudioDeviceModule_w() {
-  if (!audio_device_module_)
-    audio_device_module_ = webrtc::AudioDeviceModule::Create(
-        webrtc::AudioDeviceModule::kPlatformDefaultAudio,
-        task_queue_factory_.get());
+  if (audio_device_module_)
+    return;
+
+  // The modules move audio in 10 ms chunks of whole samples.
+  const RTCAudioDeviceOptions defaults;
+  int sample_rate = audio_options_.sample_rate;
+  if (sample_rate <= 0 || sample_rate % 100 != 0) {
+    RTC_LOG(LS_WARNING) << "Audio device sample rate " << sample_rate
+                        << " is not a multiple of 100 Hz, using "
+                        << defaults.sample_rate << " Hz";
+    sample_rate = defaults.sample_rate;
+  }
+  int channels = audio_options_.channels;
+  if (channels <= 0) {
+    RTC_LOG(LS_WARNING) << "Audio device with " << channels
+                        << " channels, using " << defaults.channels;
+    channels = defaults.channels;
+  }
+  switch (audio_options_.type) {
+    case RTCAudioDeviceModuleType::kDummy:
+      audio_device_module_ = webrtc::TestAudioDeviceModule::Create(
+          task_queue_factory_.get(),
+          webrtc::TestAudioDeviceModule::CreatePulsedNoiseCapturer(
+              0, sample_rate, channels),
+          webrtc::TestAudioDeviceModule::CreateDiscardRenderer(sample_rate,
+                                                               channels));
+      break;
+    case RTCAudioDeviceModuleType::kFile: {
+      std::string input_file = to_std_string(audio_options_.input_file);
+      std::string output_file = to_std_string(audio_options_.output_file);
+      audio_device_module_ = webrtc::TestAudioDeviceModule::Create(
+          task_queue_factory_.get(),
+          input_file.empty()
+              ? webrtc::TestAudioDeviceModule::CreatePulsedNoiseCapturer(
+                    0, sample_rate, channels)
+              : webrtc::TestAudioDeviceModule::CreateWavFileReader(
+                    input_file, audio_options_.loop_input),
+          output_file.empty()
+              ? webrtc::TestAudioDeviceModule::CreateDiscardRenderer(
+                    sample_rate, channels)
+              : webrtc::TestAudioDeviceModule::CreateWavFileWriter(
+                    output_file, sample_rate, channels));
+      break;
+    }
+    case RTCAudioDeviceModuleType::kPull: {
+      // Whole 10 ms chunks only.
+      int tick_ms = std::max(10, audio_options_.tick_ms / 10 * 10);
+      pull_audio_device_module_ =
+          rtc::make_ref_counted<PullAudioDeviceModule>(sample_rate, channels,
+                                                       tick_ms);
+      audio_device_module_ = pull_audio_device_module_;
+      break;
+    }
+    case RTCAudioDeviceModuleType::kPlatformDefault:
+    default:
+      audio_device_module_ = webrtc::AudioDeviceModule::Create(
+          webrtc::AudioDeviceModule::kPlatformDefaultAudio,
+          task_queue_factory_.get());
+      break;
+  }
 }
 
 void RTCPeerConnectionFactoryImpl::DestroyAudioDeviceModule_w() {
+  pull_audio_device_module_ = nullptr;
   if (audio_device_module_)
     audio_device_module_ = nullptr;
 }
@@ -114,15 +213,58 @@ scoped_refptr<RTCPeerConnection> RTCPeerConnectionFactoryImpl::Create(
     const RTCConfiguration& configuration,
     scoped_refptr<RTCMediaConstraints> constraints) {
   scoped_refptr<RTCPeerConnection> peerconnection =
-      scoped_refptr<RTCPeerConnectionImpl>(
-          new RefCountedObject<RTCPeerConnectionImpl>(
-              configuration, constraints, rtc_peerconnection_factory_));
-  peerconnections_.push_back(peerconnection);
+      CreatePeerConnectionImpl(configuration, constraints);
+  AddPeerConnection(peerconnection);
   return peerconnection;
 }
 
+scoped_refptr<RTCPeerConnectionImpl>
+RTCPeerConnectionFactoryImpl::CreatePeerConnectionImpl(
+    const RTCConfiguration& configuration,
+    scoped_refptr<RTCMediaConstraints> constraints) {
+  if (rtc::Thread::Current() != signaling_thread_.get()) {
+    return signaling_thread_->BlockingCall([this, &configuration, constraints] {
+      return CreatePeerConnectionImpl(configuration, constraints);
+    });
+  }
+
+  // The options are factory wide and read when the connection is created.
+  // Both happen in one signaling task, so a pool refill with options of
+  // its own cannot slip in between.
+  SetFactoryOptions(configuration);
+  return scoped_refptr<RTCPeerConnectionImpl>(
+      new RefCountedObject<RTCPeerConnectionImpl>(
+          configuration, constraints, rtc_peerconnection_factory_,
+          certificate_cache_, signaling_thread_.get(), capture_level_meter_));
+}
+
+void RTCPeerConnectionFactoryImpl::SetFactoryOptions(
+    const RTCConfiguration& configuration) {
+  if (!rtc_peerconnection_factory_) {
+    return;
+  }
+  webrtc::PeerConnectionFactoryInterface::Options options;
+  options.disable_encryption =
+      (configuration.srtp_type == MediaSecurityType::kSRTP_None);
+  // options.network_ignore_mask |= ADAPTER_TYPE_CELLULAR;
+  rtc_peerconnection_factory_->SetOptions(options);
+}
+
+void RTCPeerConnectionFactoryImpl::AddPeerConnection(
+    scoped_refptr<RTCPeerConnection> peerconnection) {
+  webrtc::MutexLock lock(&peerconnections_mutex_);
+  peerconnections_.push_back(peerconnection);
+}
+
+void RTCPeerConnectionFactoryImpl::RemovePool(
+    RTCPeerConnectionPoolImpl* pool) {
+  webrtc::MutexLock lock(&pools_mutex_);
+  pools_.erase(pool);
+}
+
 void RTCPeerConnectionFactoryImpl::Delete(
     scoped_refptr<RTCPeerConnection> peerconnection) {
+  webrtc::MutexLock lock(&peerconnections_mutex_);
   peerconnections_.erase(
       std::remove_if(
           peerconnections_.begin(), peerconnections_.end(),
@@ -132,6 +274,34 @@ void RTCPeerConnectionFactoryImpl::Delete(
       peerconnections_.end());
 }
 
+scoped_refptr<RTCPeerConnectionPool>
+RTCPeerConnectionFactoryImpl::CreatePeerConnectionPool(
+    const RTCConfiguration& configuration,
+    scoped_refptr<RTCMediaConstraints> constraints,
+    const RTCPeerConnectionPoolOptions& options) {
+  scoped_refptr<RTCPeerConnectionPoolImpl> pool =
+      scoped_refptr<RTCPeerConnectionPoolImpl>(
+          new RefCountedObject<RTCPeerConnectionPoolImpl>(
+              this, configuration, constraints, options));
+  {
+    webrtc::MutexLock lock(&pools_mutex_);
+    pools_.insert(pool.get());
+  }
+  pool->Start();
+  return pool;
+}
+
+void RTCPeerConnectionFactoryImpl::EnableCertificateCache(
+    const RTCCertificateCacheOptions& options) {
+  certificate_cache_->Enable(
+      options.use_rsa ? rtc::KeyParams::RSA(2048) : rtc::KeyParams::ECDSA(),
+      options.rotation_period_ms);
+}
+
+void RTCPeerConnectionFactoryImpl::PreGenerateCertificate(const string tenant) {
+  certificate_cache_->PreGenerate(to_std_string(tenant));
+}
+
 scoped_refptr<RTCAudioDevice> RTCPeerConnectionFactoryImpl::GetAudioDevice() {
   if (!audio_device_module_) {
     worker_thread_->BlockingCall([this] { CreateAudioDeviceModule_w(); });
@@ -140,7 +310,8 @@ scoped_refptr<RTCAudioDevice> RTCPeerConnectionFactoryImpl::GetAudioDevice() {
   if (!audio_device_impl_)
     audio_device_impl_ =
         scoped_refptr<AudioDeviceImpl>(new RefCountedObject<AudioDeviceImpl>(
-            audio_device_module_, worker_thread_.get()));
+            audio_device_module_, pull_audio_device_module_,
+            worker_thread_.get()));
 
   return audio_device_impl_;
 }
@@ -155,12 +326,19 @@ scoped_refptr<RTCVideoDevice> RTCPeerConnectionFactoryImpl::GetVideoDevice() {
 }
 
 scoped_refptr<RTCAudioSource> RTCPeerConnectionFactoryImpl::CreateAudioSource(
-    const string audio_source_label) {
+    const string audio_source_label,
+    RTCAudioSource::SourceType source_type) {
+  if (source_type == RTCAudioSource::SourceType::kCustom) {
+    rtc::scoped_refptr<PushAudioSource> push_source = PushAudioSource::Create();
+    return scoped_refptr<RTCAudioSourceImpl>(
+        new RefCountedObject<RTCAudioSourceImpl>(push_source, push_source));
+  }
+
   rtc::scoped_refptr<webrtc::AudioSourceInterface> rtc_source_track =
       rtc_peerconnection_factory_->CreateAudioSource(cricket::AudioOptions());
 
   scoped_refptr<RTCAudioSourceImpl> source = scoped_refptr<RTCAudioSourceImpl>(
-      new RefCountedObject<RTCAudioSourceImpl>(rtc_source_track));
+      new RefCountedObject<RTCAudioSourceImpl>(rtc_source_track, nullptr));
   return source;
 }
 
@@ -7,10 +7,15 @@
 #include "rtc_video_device_impl.h"
 
 #include <memory>
+#include <set>
 #include "api/media_stream_interface.h"
 #include "api/peer_connection_interface.h"
 #include "api/task_queue/task_queue_factory.h"
+#include "rtc_base/synchronization/mutex.h"
 #include "rtc_base/thread.h"
+#include "src/internal/audio_level_meter.h"
+#include "src/internal/certificate_cache.h"
+#include "src/internal/pull_audio_device_module.h"
 
 #ifdef RTC_DESKTOP_DEVICE
 #include "rtc_desktop_capturer_impl.h"
@@ -20,10 +25,16 @@
 
 namespace libwebrtc {
 
+class RTCPeerConnectionImpl;
+class RTCPeerConnectionPoolImpl;
+
 class RTCPeerConnectionFactoryImpl : public RTCPeerConnectionFactory {
  public:
   RTCPeerConnectionFactoryImpl();
 
+  explicit RTCPeerConnectionFactoryImpl(
+      const RTCAudioDeviceOptions& audio_options);
+
   virtual ~RTCPeerConnectionFactoryImpl();
 
   bool Initialize() override;
@@ -41,7 +52,9 @@ class RTCPeerConnectionFactoryImpl : public RTCPeerConnectionFactory {
   scoped_refptr<RTCVideoDevice> GetVideoDevice() override;
 
   virtual scoped_refptr<RTCAudioSource> CreateAudioSource(
-      const string audio_source_label) override;
+      const string audio_source_label,
+      RTCAudioSource::SourceType source_type =
+          RTCAudioSource::SourceType::kMicrophone) override;
 
   virtual scoped_refptr<RTCVideoSource> CreateVideoSource(
       scoped_refptr<RTCVideoCapturer> capturer,
@@ -76,11 +89,39 @@ class RTCPeerConnectionFactoryImpl : public RTCPeerConnectionFactory {
   scoped_refptr<RTCRtpCapabilities> GetRtpReceiverCapabilities(
       RTCMediaType media_type) override;
 
+  scoped_refptr<RTCPeerConnectionPool> CreatePeerConnectionPool(
+      const RTCConfiguration& configuration,
+      scoped_refptr<RTCMediaConstraints> constraints,
+      const RTCPeerConnectionPoolOptions& options) override;
+
+  void EnableCertificateCache(
+      const RTCCertificateCacheOptions& options) override;
+
+  void PreGenerateCertificate(const string tenant) override;
+
+  // For RTCPeerConnectionPoolImpl, which keeps the factory alive.
+  rtc::Thread* signaling_thread() { return signaling_thread_.get(); }
+
+  // Creates a connection with the options of |configuration|, without
+  // tracking it. Thread safe.
+  scoped_refptr<RTCPeerConnectionImpl> CreatePeerConnectionImpl(
+      const RTCConfiguration& configuration,
+      scoped_refptr<RTCMediaConstraints> constraints);
+
+  // Tracks a connection for Delete() and Terminate(). Thread safe.
+  void AddPeerConnection(scoped_refptr<RTCPeerConnection> peerconnection);
+
+  void RemovePool(RTCPeerConnectionPoolImpl* pool);
+
  protected:
   void CreateAudioDeviceModule_w();
 
   void DestroyAudioDeviceModule_w();
 
+  // The options are factory wide, a connection created afterwards picks
+  // them up. Called on the signaling thread only.
+  void SetFactoryOptions(const RTCConfiguration& configuration);
+
   scoped_refptr<RTCVideoSource> CreateVideoSource_s(
       scoped_refptr<RTCVideoCapturer> capturer,
       const char* video_source_label,
@@ -98,12 +139,22 @@ class RTCPeerConnectionFactoryImpl : public RTCPeerConnectionFactory {
   rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface>
       rtc_peerconnection_factory_;
   rtc::scoped_refptr<webrtc::AudioDeviceModule> audio_device_module_;
+  RTCAudioDeviceOptions audio_options_;
+  // Set for RTCAudioDeviceModuleType::kPull, the same module as above.
+  rtc::scoped_refptr<PullAudioDeviceModule> pull_audio_device_module_;
   scoped_refptr<AudioDeviceImpl> audio_device_impl_;
   scoped_refptr<RTCVideoDeviceImpl> video_device_impl_;
 #ifdef RTC_DESKTOP_DEVICE
   scoped_refptr<RTCDesktopDeviceImpl> desktop_device_impl_;
 #endif
-  std::list<scoped_refptr<RTCPeerConnection>> peerconnections_;
+  webrtc::Mutex peerconnections_mutex_;
+  std::list<scoped_refptr<RTCPeerConnection>> peerconnections_
+      RTC_GUARDED_BY(peerconnections_mutex_);
+  // Taken before |peerconnections_mutex_| when both are needed.
+  webrtc::Mutex pools_mutex_;
+  std::set<RTCPeerConnectionPoolImpl*> pools_ RTC_GUARDED_BY(pools_mutex_);
+  std::shared_ptr<CertificateCache> certificate_cache_;
+  std::shared_ptr<AudioLevelMeter> capture_level_meter_;
   std::unique_ptr<webrtc::TaskQueueFactory> task_queue_factory_;
 };
 
@@ -187,10 +187,16 @@ RTCPeerConnectionImpl::RTCPeerConnectionImpl(
     const RTCConfiguration& configuration,
     scoped_refptr<RTCMediaConstraints> constraints,
     rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface>
-        peer_connection_factory)
+        peer_connection_factory,
+    std::shared_ptr<CertificateCache> certificate_cache,
+    rtc::Thread* signaling_thread,
+    std::shared_ptr<AudioLevelMeter> capture_level_meter)
     : rtc_peerconnection_factory_(peer_connection_factory),
       configuration_(configuration),
       constraints_(constraints),
+      certificate_cache_(certificate_cache),
+      signaling_thread_(signaling_thread),
+      capture_level_meter_(capture_level_meter),
       callback_crt_sec_(new webrtc::Mutex()) {
   RTC_LOG(LS_INFO) << __FUNCTION__ << ": ctor";
   Initialize();
@@ -365,6 +371,34 @@ void RTCPeerConnectionImpl::DeRegisterRTCPeerConnectionObserver() {
   observer_ = nullptr;
 }
 
+void RTCPeerConnectionImpl::SetAudioLevelCallback(OnAudioLevels callback,
+                                                  int interval_ms) {
+  StopAudioLevelMonitor();
+  if (!callback || !rtc_peerconnection_.get() || !signaling_thread_) {
+    return;
+  }
+  audio_level_monitor_ = std::make_unique<AudioLevelMonitor>(
+      signaling_thread_, rtc_peerconnection_, capture_level_meter_,
+      std::move(callback), interval_ms);
+}
+
+void RTCPeerConnectionImpl::StopAudioLevelMonitor() {
+  if (!audio_level_monitor_) {
+    return;
+  }
+  if (!signaling_thread_->IsCurrent()) {
+    // Not from the callback, which runs on the signaling thread.
+    audio_level_monitor_ = nullptr;
+    return;
+  }
+  // May be called from the callback, the monitor is deleted once it
+  // returned. Stop() releases the peer connection right away.
+  audio_level_monitor_->Stop();
+  signaling_thread_->PostTask(
+      [monitor = std::shared_ptr<AudioLevelMonitor>(
+           std::move(audio_level_monitor_))] {});
+}
+
 bool RTCPeerConnectionImpl::Initialize() {
   RTC_DCHECK(rtc_peerconnection_factory_.get() != nullptr);
   RTC_DCHECK(rtc_peerconnection_.get() == nullptr);
@@ -396,6 +430,7 @@ bool RTCPeerConnectionImpl::Initialize() {
       tcp_candidate_policy_map[configuration_.tcp_candidate_policy];
   config.type = ice_transport_type_map[configuration_.type];
   config.rtcp_mux_policy = rtcp_mux_policy_map[configuration_.rtcp_mux_policy];
+  config.ice_candidate_pool_size = configuration_.ice_candidate_pool_size;
 
   offer_answer_options_.offer_to_receive_audio =
       configuration_.offer_to_receive_audio;
@@ -413,18 +448,23 @@ bool RTCPeerConnectionImpl::Initialize() {
   if (configuration_.screencast_min_bitrate > 0)
     config.screencast_min_bitrate = configuration_.screencast_min_bitrate;
 
+  if (certificate_cache_) {
+    rtc::scoped_refptr<rtc::RTCCertificate> certificate =
+        certificate_cache_->GetCertificate(
+            to_std_string(configuration_.certificate_tenant));
+    // Without a cached certificate webrtc generates one for this connection.
+    if (certificate)
+      config.certificates.push_back(certificate);
+  }
+
   RTCMediaConstraintsImpl* media_constraints =
       static_cast<RTCMediaConstraintsImpl*>(constraints_.get());
   webrtc::MediaConstraints rtc_constraints(media_constraints->GetMandatory(),
                                            media_constraints->GetOptional());
   CopyConstraintsIntoRtcConfiguration(&rtc_constraints, &config);
 
-  webrtc::PeerConnectionFactoryInterface::Options options;
-  options.disable_encryption =
-      (configuration_.srtp_type == MediaSecurityType::kSRTP_None);
-  // options.network_ignore_mask |= ADAPTER_TYPE_CELLULAR;
-  rtc_peerconnection_factory_->SetOptions(options);
-
+  // RTCConfiguration::srtp_type goes into the factory options, set by the
+  // factory before it creates the connection.
   webrtc::PeerConnectionDependencies dependencies(this);
   auto result = rtc_peerconnection_factory_->CreatePeerConnectionOrError(
       config, std::move(dependencies));
@@ -616,6 +656,7 @@ void RTCPeerConnectionImpl::RestartIce() {
 void RTCPeerConnectionImpl::Close() {
   RTC_LOG(LS_INFO) << __FUNCTION__;
   if (rtc_peerconnection_.get()) {
+    StopAudioLevelMonitor();
     rtc_peerconnection_ = nullptr;
     data_channel_ = nullptr;
     local_streams_.clear();
@@ -19,6 +19,8 @@
 #include "rtc_video_source.h"
 #include "rtc_video_source_impl.h"
 #include "rtc_video_track_impl.h"
+#include "src/internal/audio_level_monitor.h"
+#include "src/internal/certificate_cache.h"
 #include "src/internal/video_capturer.h"
 
 namespace webrtc {
@@ -75,6 +77,9 @@ class RTCPeerConnectionImpl : public RTCPeerConnection,
 
   virtual void DeRegisterRTCPeerConnectionObserver() override;
 
+  virtual void SetAudioLevelCallback(OnAudioLevels callback,
+                                     int interval_ms) override;
+
   virtual scoped_refptr<RTCRtpTransceiver> AddTransceiver(
       scoped_refptr<RTCMediaTrack> track,
       scoped_refptr<RTCRtpTransceiverInit> init) override;
@@ -147,11 +152,20 @@ class RTCPeerConnectionImpl : public RTCPeerConnection,
       const RTCConfiguration& configuration,
       scoped_refptr<RTCMediaConstraints> constraints,
       rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface>
-          peer_connection_factory);
+          peer_connection_factory,
+      std::shared_ptr<CertificateCache> certificate_cache = nullptr,
+      rtc::Thread* signaling_thread = nullptr,
+      std::shared_ptr<AudioLevelMeter> capture_level_meter = nullptr);
+
+  rtc::scoped_refptr<webrtc::PeerConnectionInterface> rtc_peerconnection() {
+    return rtc_peerconnection_;
+  }
 
  protected:
   ~RTCPeerConnectionImpl();
 
+  void StopAudioLevelMonitor();
+
   virtual void OnAddTrack(
       rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver,
       const std::vector<rtc::scoped_refptr<webrtc::MediaStreamInterface>>&
@@ -193,8 +207,12 @@ class RTCPeerConnectionImpl : public RTCPeerConnection,
   rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface>
       rtc_peerconnection_factory_;
   rtc::scoped_refptr<webrtc::PeerConnectionInterface> rtc_peerconnection_;
-  const RTCConfiguration& configuration_;
+  const RTCConfiguration configuration_;
   scoped_refptr<RTCMediaConstraints> constraints_;
+  std::shared_ptr<CertificateCache> certificate_cache_;
+  rtc::Thread* signaling_thread_ = nullptr;
+  std::shared_ptr<AudioLevelMeter> capture_level_meter_;
+  std::unique_ptr<AudioLevelMonitor> audio_level_monitor_;
   webrtc::PeerConnectionInterface::RTCOfferAnswerOptions offer_answer_options_;
   RTCPeerConnectionObserver* observer_ = nullptr;
   std::unique_ptr<webrtc::Mutex> callback_crt_sec_;
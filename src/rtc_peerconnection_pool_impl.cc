@@ -0,0 +1,216 @@
+#include "rtc_peerconnection_pool_impl.h"
+
+#include <algorithm>
+
+#include "rtc_base/logging.h"
+#include "rtc_peerconnection_factory_impl.h"
+#include "rtc_base/time_utils.h"
+
+namespace libwebrtc {
+
+namespace {
+
+// Backoff of the refill after CreatePeerConnection failed.
+const int kMinRetryDelayMs = 100;
+const int kMaxRetryDelayMs = 10000;
+
+}  // namespace
+
+RTCPeerConnectionPoolImpl::RTCPeerConnectionPoolImpl(
+    RTCPeerConnectionFactoryImpl* factory,
+    const RTCConfiguration& configuration,
+    scoped_refptr<RTCMediaConstraints> constraints,
+    const RTCPeerConnectionPoolOptions& options)
+    : factory_(factory),
+      configuration_(configuration),
+      constraints_(constraints),
+      options_(options),
+      signaling_thread_(factory->signaling_thread()) {
+  RTC_LOG(LS_INFO) << __FUNCTION__ << ": ctor, size " << options_.size
+                   << ", idle ttl " << options_.idle_ttl_ms << "ms";
+}
+
+void RTCPeerConnectionPoolImpl::Start() {
+  // The safety flag is bound to the thread that creates it.
+  signaling_thread_->BlockingCall([this] {
+    safety_flag_ = webrtc::PendingTaskSafetyFlag::Create();
+    if (options_.idle_ttl_ms > 0) {
+      signaling_thread_->PostDelayedTask(
+          webrtc::SafeTask(safety_flag_, [this] { ExpireIdle_s(); }),
+          webrtc::TimeDelta::Millis(options_.idle_ttl_ms / 2 + 1));
+    }
+  });
+  ScheduleRefill();
+}
+
+RTCPeerConnectionPoolImpl::~RTCPeerConnectionPoolImpl() {
+  factory_->RemovePool(this);
+  signaling_thread_->BlockingCall([this] { safety_flag_->SetNotAlive(); });
+  Drain();
+  RTC_LOG(LS_INFO) << __FUNCTION__ << ": dtor";
+}
+
+scoped_refptr<RTCPeerConnection> RTCPeerConnectionPoolImpl::Acquire() {
+  scoped_refptr<RTCPeerConnectionImpl> peerconnection;
+  {
+    webrtc::MutexLock lock(&mutex_);
+    if (drained_) {
+      RTC_LOG(LS_WARNING) << __FUNCTION__ << ": pool drained";
+      return nullptr;
+    }
+    if (!idle_.empty()) {
+      peerconnection = idle_.front().peerconnection;
+      idle_.pop_front();
+    }
+  }
+
+  if (!peerconnection) {
+    RTC_LOG(LS_INFO) << __FUNCTION__ << ": pool empty, creating on demand";
+    peerconnection = CreatePeerConnection();
+  }
+
+  ScheduleRefill();
+  return peerconnection;
+}
+
+uint32_t RTCPeerConnectionPoolImpl::ready_count() {
+  webrtc::MutexLock lock(&mutex_);
+  return static_cast<uint32_t>(idle_.size());
+}
+
+void RTCPeerConnectionPoolImpl::Drain() {
+  std::deque<PooledPeerConnection> idle;
+  {
+    webrtc::MutexLock lock(&mutex_);
+    drained_ = true;
+    idle.swap(idle_);
+  }
+  // Closing happens when the last references go away, outside the lock.
+  Release(&idle);
+}
+
+void RTCPeerConnectionPoolImpl::TakeIdle(
+    std::vector<scoped_refptr<RTCPeerConnection>>* peerconnections) {
+  webrtc::MutexLock lock(&mutex_);
+  drained_ = true;
+  for (auto& pooled : idle_) {
+    peerconnections->push_back(pooled.peerconnection);
+  }
+  idle_.clear();
+}
+
+void RTCPeerConnectionPoolImpl::Release(
+    std::deque<PooledPeerConnection>* peerconnections) {
+  for (auto& pooled : *peerconnections) {
+    factory_->Delete(pooled.peerconnection);
+  }
+  peerconnections->clear();
+}
+
+scoped_refptr<RTCPeerConnectionImpl>
+RTCPeerConnectionPoolImpl::CreatePeerConnection() {
+  // Created with the pool's own options, whatever connection the factory
+  // created last.
+  scoped_refptr<RTCPeerConnectionImpl> peerconnection =
+      factory_->CreatePeerConnectionImpl(configuration_, constraints_);
+  if (!peerconnection->rtc_peerconnection()) {
+    return nullptr;
+  }
+  factory_->AddPeerConnection(peerconnection);
+
+  for (uint32_t i = 0; i < options_.audio_transceivers; i++) {
+    peerconnection->AddTransceiver(RTCMediaType::AUDIO);
+  }
+  for (uint32_t i = 0; i < options_.video_transceivers; i++) {
+    peerconnection->AddTransceiver(RTCMediaType::VIDEO);
+  }
+  return peerconnection;
+}
+
+void RTCPeerConnectionPoolImpl::ScheduleRefill() {
+  {
+    webrtc::MutexLock lock(&mutex_);
+    if (drained_ || refill_pending_ || idle_.size() >= options_.size) {
+      return;
+    }
+    refill_pending_ = true;
+  }
+  signaling_thread_->PostTask(
+      webrtc::SafeTask(safety_flag_, [this] { Refill_s(); }));
+}
+
+void RTCPeerConnectionPoolImpl::Refill_s() {
+  RTC_DCHECK_RUN_ON(signaling_thread_);
+  {
+    webrtc::MutexLock lock(&mutex_);
+    refill_pending_ = false;
+    if (drained_ || idle_.size() >= options_.size) {
+      return;
+    }
+  }
+
+  // One connection per task, so that other signaling work can interleave
+  // with a large refill.
+  scoped_refptr<RTCPeerConnectionImpl> peerconnection = CreatePeerConnection();
+  if (!peerconnection) {
+    retry_delay_ms_ = retry_delay_ms_ == 0
+                          ? kMinRetryDelayMs
+                          : std::min(retry_delay_ms_ * 2, kMaxRetryDelayMs);
+    RTC_LOG(LS_WARNING) << __FUNCTION__
+                        << ": CreatePeerConnection failed, retrying in "
+                        << retry_delay_ms_ << "ms";
+    {
+      webrtc::MutexLock lock(&mutex_);
+      refill_pending_ = true;
+    }
+    signaling_thread_->PostDelayedTask(
+        webrtc::SafeTask(safety_flag_, [this] { Refill_s(); }),
+        webrtc::TimeDelta::Millis(retry_delay_ms_));
+    return;
+  }
+  retry_delay_ms_ = 0;
+
+  bool drained = false;
+  {
+    webrtc::MutexLock lock(&mutex_);
+    drained = drained_;
+    if (!drained) {
+      idle_.push_back({peerconnection, rtc::TimeMillis()});
+    }
+  }
+  if (drained) {
+    factory_->Delete(peerconnection);
+    return;
+  }
+  ScheduleRefill();
+}
+
+void RTCPeerConnectionPoolImpl::ExpireIdle_s() {
+  RTC_DCHECK_RUN_ON(signaling_thread_);
+  std::deque<PooledPeerConnection> expired;
+  {
+    webrtc::MutexLock lock(&mutex_);
+    if (drained_) {
+      return;
+    }
+    int64_t now_ms = rtc::TimeMillis();
+    while (!idle_.empty() &&
+           now_ms - idle_.front().created_ms >= options_.idle_ttl_ms) {
+      expired.push_back(idle_.front());
+      idle_.pop_front();
+    }
+  }
+
+  if (!expired.empty()) {
+    RTC_LOG(LS_INFO) << __FUNCTION__ << ": closing " << expired.size()
+                     << " idle peerconnections";
+    Release(&expired);
+    ScheduleRefill();
+  }
+
+  signaling_thread_->PostDelayedTask(
+      webrtc::SafeTask(safety_flag_, [this] { ExpireIdle_s(); }),
+      webrtc::TimeDelta::Millis(options_.idle_ttl_ms / 2 + 1));
+}
+
+}  // namespace libwebrtc
@@ -0,0 +1,77 @@
+#ifndef LIB_WEBRTC_RTC_PEERCONNECTION_POOL_IMPL_HXX
+#define LIB_WEBRTC_RTC_PEERCONNECTION_POOL_IMPL_HXX
+
+#include <deque>
+#include <vector>
+
+#include "rtc_peerconnection_impl.h"
+#include "rtc_peerconnection_pool.h"
+
+#include "api/peer_connection_interface.h"
+#include "api/task_queue/pending_task_safety_flag.h"
+#include "rtc_base/synchronization/mutex.h"
+#include "rtc_base/thread.h"
+
+namespace libwebrtc {
+
+class RTCPeerConnectionFactoryImpl;
+
+class RTCPeerConnectionPoolImpl : public RTCPeerConnectionPool {
+ public:
+  // Keeps |factory| alive, with the threads and caches it owns.
+  RTCPeerConnectionPoolImpl(RTCPeerConnectionFactoryImpl* factory,
+                            const RTCConfiguration& configuration,
+                            scoped_refptr<RTCMediaConstraints> constraints,
+                            const RTCPeerConnectionPoolOptions& options);
+
+  ~RTCPeerConnectionPoolImpl();
+
+  // Starts filling the pool.
+  void Start();
+
+  scoped_refptr<RTCPeerConnection> Acquire() override;
+
+  uint32_t ready_count() override;
+
+  void Drain() override;
+
+  // Stops refilling and appends the idle connections to |peerconnections|,
+  // without releasing any. For the factory, which holds its pool lock.
+  void TakeIdle(
+      std::vector<scoped_refptr<RTCPeerConnection>>* peerconnections);
+
+ private:
+  struct PooledPeerConnection {
+    scoped_refptr<RTCPeerConnectionImpl> peerconnection;
+    int64_t created_ms;
+  };
+
+  scoped_refptr<RTCPeerConnectionImpl> CreatePeerConnection();
+
+  void ScheduleRefill();
+
+  void Refill_s();
+
+  void ExpireIdle_s();
+
+  // Hands the connections back to the factory, which stops tracking them.
+  void Release(std::deque<PooledPeerConnection>* peerconnections);
+
+ private:
+  const scoped_refptr<RTCPeerConnectionFactoryImpl> factory_;
+  const RTCConfiguration configuration_;
+  scoped_refptr<RTCMediaConstraints> constraints_;
+  const RTCPeerConnectionPoolOptions options_;
+  rtc::Thread* const signaling_thread_;
+  rtc::scoped_refptr<webrtc::PendingTaskSafetyFlag> safety_flag_;
+  // Delay of the next refill after a failed one, 0 while refills succeed.
+  int retry_delay_ms_ = 0;
+  webrtc::Mutex mutex_;
+  std::deque<PooledPeerConnection> idle_;
+  bool refill_pending_ = false;
+  bool drained_ = false;
+};
+
+}  // namespace libwebrtc
+
+#endif  // LIB_WEBRTC_RTC_PEERCONNECTION_POOL_IMPL_HXX
@@ -1,20 +1,142 @@
 #include "rtc_video_device_impl.h"
 
+#include <string.h>
+
+#include <algorithm>
+
+#include "api/task_queue/pending_task_safety_flag.h"
 #include "modules/video_capture/video_capture_factory.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/time_utils.h"
 
 namespace libwebrtc {
 
+// How long the device list is trusted where device changes are not
+// reported.
+const int64_t kDeviceListTtlMs = 2000;
+
+namespace {
+
+const char* VideoTypeName(webrtc::VideoType type) {
+  switch (type) {
+    case webrtc::VideoType::kI420:
+      return "I420";
+    case webrtc::VideoType::kIYUV:
+      return "IYUV";
+    case webrtc::VideoType::kRGB24:
+      return "RGB24";
+    case webrtc::VideoType::kARGB:
+      return "ARGB";
+    case webrtc::VideoType::kRGB565:
+      return "RGB565";
+    case webrtc::VideoType::kYUY2:
+      return "YUY2";
+    case webrtc::VideoType::kYV12:
+      return "YV12";
+    case webrtc::VideoType::kUYVY:
+      return "UYVY";
+    case webrtc::VideoType::kMJPEG:
+      return "MJPEG";
+    case webrtc::VideoType::kNV21:
+      return "NV21";
+    case webrtc::VideoType::kNV12:
+      return "NV12";
+    case webrtc::VideoType::kBGRA:
+      return "BGRA";
+    default:
+      return "Unknown";
+  }
+}
+
+// Copies |src| into |dst|, truncated to |length| - 1 characters.
+void CopyName(const std::string& src, char* dst, uint32_t length) {
+  if (!dst || length == 0) {
+    return;
+  }
+  size_t size = std::min<size_t>(src.size(), length - 1);
+  memcpy(dst, src.data(), size);
+  dst[size] = '\0';
+}
+
+}  // namespace
+
 RTCVideoDeviceImpl::RTCVideoDeviceImpl(rtc::Thread* signaling_thread,
                                        rtc::Thread* worker_thread)
-    : device_info_(webrtc::VideoCaptureFactory::CreateDeviceInfo()),
-      signaling_thread_(signaling_thread),
-      worker_thread_(worker_thread) {}
+    : signaling_thread_(signaling_thread),
+      worker_thread_(worker_thread),
+      open_thread_(rtc::Thread::Create()),
+      device_info_(webrtc::VideoCaptureFactory::CreateDeviceInfo()) {
+  open_thread_->SetName("video_device_open", nullptr);
+  open_thread_->Start();
+  // The safety flag is bound to the thread that creates it.
+  signaling_thread_->BlockingCall(
+      [this] { safety_flag_ = webrtc::PendingTaskSafetyFlag::Create(); });
+  monitor_ =
+      std::make_unique<VideoDeviceMonitor>([this] { OnDevicesChanged(); });
+  monitoring_ = monitor_->Start();
+  if (!monitoring_) {
+    monitor_.reset();
+  }
+}
 
-uint32_t RTCVideoDeviceImpl::NumberOfDevices() {
+RTCVideoDeviceImpl::~RTCVideoDeviceImpl() {
+  // Joins the monitor thread, nothing is posted afterwards.
+  monitor_.reset();
+  signaling_thread_->BlockingCall([this] { safety_flag_->SetNotAlive(); });
+  open_thread_->Stop();
+}
+
+void RTCVideoDeviceImpl::UpdateDeviceList() {
+  int64_t now_ms = rtc::TimeMillis();
+  if (devices_valid_ &&
+      (monitoring_ || now_ms - devices_updated_ms_ < kDeviceListTtlMs)) {
+    return;
+  }
+  devices_valid_ = true;
+  devices_updated_ms_ = now_ms;
+  devices_.clear();
   if (!device_info_) {
-    return 0;
+    return;
+  }
+  uint32_t count = device_info_->NumberOfDevices();
+  devices_.resize(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    char name[256] = {0};
+    char unique_id[256] = {0};
+    char product_id[256] = {0};
+    // Failed entries stay in the list, Create() takes the same indices.
+    if (device_info_->GetDeviceName(i, name, sizeof(name), unique_id,
+                                    sizeof(unique_id), product_id,
+                                    sizeof(product_id)) != 0) {
+      RTC_LOG(LS_WARNING) << "Failed to get the name of video device " << i;
+      continue;
+    }
+    devices_[i].name = name;
+    devices_[i].unique_id = unique_id;
+    devices_[i].product_id = product_id;
+  }
+}
+
+void RTCVideoDeviceImpl::OnDevicesChanged() {
+  {
+    webrtc::MutexLock lock(&mutex_);
+    devices_valid_ = false;
   }
-  return device_info_->NumberOfDevices();
+  signaling_thread_->PostTask(webrtc::SafeTask(safety_flag_, [this] {
+    OnDeviceChangeCallback listener;
+    {
+      webrtc::MutexLock lock(&mutex_);
+      listener = listener_;
+    }
+    if (listener)
+      listener();
+  }));
+}
+
+uint32_t RTCVideoDeviceImpl::NumberOfDevices() {
+  webrtc::MutexLock lock(&mutex_);
+  UpdateDeviceList();
+  return static_cast<uint32_t>(devices_.size());
 }
 
 int32_t RTCVideoDeviceImpl::GetDeviceName(
@@ -25,15 +147,50 @@ int32_t RTCVideoDeviceImpl::GetDeviceName(
     uint32_t deviceUniqueIdUTF8Length,
     char* productUniqueIdUTF8 /*= 0*/,
     uint32_t productUniqueIdUTF8Length /*= 0*/) {
-  if (!device_info_) {
+  webrtc::MutexLock lock(&mutex_);
+  UpdateDeviceList();
+  if (deviceNumber >= devices_.size() ||
+      devices_[deviceNumber].unique_id.empty()) {
     return -1;
   }
+  const Device& device = devices_[deviceNumber];
+  CopyName(device.name, deviceNameUTF8, deviceNameLength);
+  CopyName(device.unique_id, deviceUniqueIdUTF8, deviceUniqueIdUTF8Length);
+  CopyName(device.product_id, productUniqueIdUTF8, productUniqueIdUTF8Length);
+  return 0;
+}
 
-  if (device_info_->GetDeviceName(deviceNumber, deviceNameUTF8,
-                                  deviceNameLength, deviceUniqueIdUTF8,
-                                  deviceUniqueIdUTF8Length) != -1) {
-    return 0;
+vector<RTCVideoCapability> RTCVideoDeviceImpl::GetCapabilities(
+    uint32_t index) {
+  webrtc::MutexLock lock(&mutex_);
+  UpdateDeviceList();
+  if (index >= devices_.size() || devices_[index].unique_id.empty()) {
+    return vector<RTCVideoCapability>();
+  }
+  Device& device = devices_[index];
+  if (!device.capabilities_loaded) {
+    device.capabilities_loaded = true;
+    const char* unique_id = device.unique_id.c_str();
+    int32_t count = device_info_->NumberOfCapabilities(unique_id);
+    for (int32_t i = 0; i < count; ++i) {
+      webrtc::VideoCaptureCapability capability;
+      if (device_info_->GetCapability(unique_id, i, capability) != 0) {
+        continue;
+      }
+      RTCVideoCapability result;
+      result.width = capability.width;
+      result.height = capability.height;
+      result.max_fps = capability.maxFPS;
+      result.format = VideoTypeName(capability.videoType);
+      device.capabilities.push_back(result);
+    }
   }
+  return device.capabilities;
+}
+
+int32_t RTCVideoDeviceImpl::OnDeviceChange(OnDeviceChangeCallback listener) {
+  webrtc::MutexLock lock(&mutex_);
+  listener_ = listener;
   return 0;
 }
 
@@ -55,4 +212,58 @@ scoped_refptr<RTCVideoCapturer> RTCVideoDeviceImpl::Create(const char* name,
       });
 }
 
+scoped_refptr<RTCVideoCapturer> RTCVideoDeviceImpl::CreateFileCapturer(
+    const char* path,
+    RTCVideoFileFormat format,
+    size_t width,
+    size_t height,
+    size_t target_fps,
+    bool loop) {
+  if (!path) {
+    return nullptr;
+  }
+  VideoFileReader::Format reader_format = VideoFileReader::kY4M;
+  if (format == RTCVideoFileFormat::kI420) {
+    reader_format = VideoFileReader::kI420;
+  } else if (format == RTCVideoFileFormat::kNV12) {
+    reader_format = VideoFileReader::kNV12;
+  }
+  auto capturer = webrtc::internal::FileCapturer::Create(
+      VideoFileReader::Open(path, reader_format, static_cast<int>(width),
+                            static_cast<int>(height)),
+      target_fps, loop);
+
+  if (capturer == nullptr) {
+    return nullptr;
+  }
+
+  return signaling_thread_->BlockingCall([capturer] {
+    return scoped_refptr<RTCVideoCapturerImpl>(
+        new RefCountedObject<RTCVideoCapturerImpl>(capturer));
+  });
+}
+
+void RTCVideoDeviceImpl::CreateAsync(const char* name,
+                                     uint32_t index,
+                                     size_t width,
+                                     size_t height,
+                                     size_t target_fps,
+                                     OnCapturerCreated callback) {
+  // The task does not use |this|, which may be gone before it runs.
+  rtc::Thread* signaling_thread = signaling_thread_;
+  rtc::Thread* worker_thread = worker_thread_;
+  open_thread_->PostTask([signaling_thread, worker_thread, index, width,
+                          height, target_fps, callback] {
+    auto vcm = webrtc::internal::VcmCapturer::Create(
+        worker_thread, width, height, target_fps, index);
+    signaling_thread->PostTask([vcm, callback]() mutable {
+      scoped_refptr<RTCVideoCapturer> capturer;
+      if (vcm) {
+        capturer = new RefCountedObject<RTCVideoCapturerImpl>(vcm);
+      }
+      callback(capturer);
+    });
+  });
+}
+
 }  // namespace libwebrtc
@@ -3,12 +3,18 @@
 
 #include "rtc_video_device.h"
 
+#include "api/task_queue/pending_task_safety_flag.h"
 #include "modules/video_capture/video_capture.h"
+#include "rtc_base/synchronization/mutex.h"
 #include "rtc_base/thread.h"
+#include "src/internal/file_capturer.h"
 #include "src/internal/vcm_capturer.h"
 #include "src/internal/video_capturer.h"
+#include "src/internal/video_device_monitor.h"
 
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace libwebrtc {
 
@@ -41,6 +47,7 @@ class RTCVideoCapturerImpl : public RTCVideoCapturer {
 class RTCVideoDeviceImpl : public RTCVideoDevice {
  public:
   RTCVideoDeviceImpl(rtc::Thread* signaling_thread, rtc::Thread* worker_thread);
+  ~RTCVideoDeviceImpl();
 
  public:
   uint32_t NumberOfDevices() override;
@@ -59,10 +66,53 @@ class RTCVideoDeviceImpl : public RTCVideoDevice {
                                          size_t height,
                                          size_t target_fps) override;
 
+  void CreateAsync(const char* name,
+                   uint32_t index,
+                   size_t width,
+                   size_t height,
+                   size_t target_fps,
+                   OnCapturerCreated callback) override;
+
+  scoped_refptr<RTCVideoCapturer> CreateFileCapturer(const char* path,
+                                                     RTCVideoFileFormat format,
+                                                     size_t width,
+                                                     size_t height,
+                                                     size_t target_fps,
+                                                     bool loop) override;
+
+  vector<RTCVideoCapability> GetCapabilities(uint32_t index) override;
+
+  int32_t OnDeviceChange(OnDeviceChangeCallback listener) override;
+
  private:
-  std::unique_ptr<webrtc::VideoCaptureModule::DeviceInfo> device_info_;
+  struct Device {
+    std::string name;
+    std::string unique_id;
+    std::string product_id;
+    // Queried on first use, opening a device for it is slow.
+    bool capabilities_loaded = false;
+    std::vector<RTCVideoCapability> capabilities;
+  };
+
+  // Re-enumerates the devices if the list is stale.
+  void UpdateDeviceList() RTC_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void OnDevicesChanged();
+
   rtc::Thread* signaling_thread_ = nullptr;
   rtc::Thread* worker_thread_ = nullptr;
+  // Opens devices for CreateAsync().
+  std::unique_ptr<rtc::Thread> open_thread_;
+  std::unique_ptr<VideoDeviceMonitor> monitor_;
+  bool monitoring_ = false;
+  rtc::scoped_refptr<webrtc::PendingTaskSafetyFlag> safety_flag_;
+
+  webrtc::Mutex mutex_;
+  std::unique_ptr<webrtc::VideoCaptureModule::DeviceInfo> device_info_
+      RTC_GUARDED_BY(mutex_);
+  std::vector<Device> devices_ RTC_GUARDED_BY(mutex_);
+  bool devices_valid_ RTC_GUARDED_BY(mutex_) = false;
+  int64_t devices_updated_ms_ RTC_GUARDED_BY(mutex_) = 0;
+  OnDeviceChangeCallback listener_ RTC_GUARDED_BY(mutex_);
 };
 
 }  // namespace libwebrtc
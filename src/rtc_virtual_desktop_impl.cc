@@ -0,0 +1,113 @@
+#include "rtc_virtual_desktop_impl.h"
+
+#if defined(WEBRTC_POSIX)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "rtc_base/logging.h"
+
+namespace libwebrtc {
+
+namespace {
+
+bool IsValidLayout(int width, int height, int stride) {
+  return width > 0 && height > 0 &&
+         static_cast<int64_t>(stride) >= static_cast<int64_t>(width) * 4;
+}
+
+}  // namespace
+
+scoped_refptr<RTCVirtualDesktopImpl> RTCVirtualDesktopImpl::CreateFromFd(
+    int fd,
+    uint64_t offset,
+    int width,
+    int height,
+    int stride) {
+  if (!IsValidLayout(width, height, stride)) {
+    RTC_LOG(LS_ERROR) << __FUNCTION__ << ": invalid framebuffer layout "
+                      << width << "x" << height << ", stride " << stride;
+    return nullptr;
+  }
+#if defined(WEBRTC_POSIX)
+  // mmap() wants a page aligned offset.
+  const uint64_t page_size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+  const uint64_t map_offset = offset - offset % page_size;
+  const size_t mapping_size = static_cast<size_t>(
+      offset - map_offset + static_cast<uint64_t>(stride) * height);
+  void* mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, fd,
+                       static_cast<off_t>(map_offset));
+  if (mapping == MAP_FAILED) {
+    RTC_LOG_ERRNO(LS_ERROR) << __FUNCTION__ << ": mmap failed";
+    return nullptr;
+  }
+  const uint8_t* data =
+      static_cast<const uint8_t*>(mapping) + (offset - map_offset);
+  return new RefCountedObject<RTCVirtualDesktopImpl>(
+      data, width, height, stride, mapping, mapping_size);
+#else
+  RTC_LOG(LS_ERROR) << __FUNCTION__
+                    << ": mapping a descriptor is not supported here";
+  return nullptr;
+#endif
+}
+
+scoped_refptr<RTCVirtualDesktopImpl> RTCVirtualDesktopImpl::CreateFromMemory(
+    const uint8_t* data,
+    int width,
+    int height,
+    int stride) {
+  if (!data || !IsValidLayout(width, height, stride)) {
+    RTC_LOG(LS_ERROR) << __FUNCTION__ << ": invalid framebuffer";
+    return nullptr;
+  }
+  return new RefCountedObject<RTCVirtualDesktopImpl>(data, width, height,
+                                                     stride, nullptr, 0);
+}
+
+RTCVirtualDesktopImpl::RTCVirtualDesktopImpl(const uint8_t* data,
+                                             int width,
+                                             int height,
+                                             int stride,
+                                             void* mapping,
+                                             size_t mapping_size)
+    : data_(data),
+      width_(width),
+      height_(height),
+      stride_(stride),
+      mapping_(mapping),
+      mapping_size_(mapping_size) {
+  // The first capture sends the whole framebuffer.
+  dirty_region_.SetRect(webrtc::DesktopRect::MakeWH(width_, height_));
+}
+
+RTCVirtualDesktopImpl::~RTCVirtualDesktopImpl() {
+#if defined(WEBRTC_POSIX)
+  if (mapping_) {
+    munmap(mapping_, mapping_size_);
+  }
+#endif
+}
+
+void RTCVirtualDesktopImpl::AddDirtyRect(int x, int y, int width, int height) {
+  webrtc::DesktopRect rect = webrtc::DesktopRect::MakeXYWH(x, y, width, height);
+  rect.IntersectWith(webrtc::DesktopRect::MakeWH(width_, height_));
+  if (rect.is_empty()) {
+    return;
+  }
+  webrtc::MutexLock lock(&mutex_);
+  dirty_region_.AddRect(rect);
+}
+
+void RTCVirtualDesktopImpl::SetDirty() {
+  webrtc::MutexLock lock(&mutex_);
+  dirty_region_.SetRect(webrtc::DesktopRect::MakeWH(width_, height_));
+}
+
+void RTCVirtualDesktopImpl::TakeDirtyRegion(webrtc::DesktopRegion* region) {
+  webrtc::MutexLock lock(&mutex_);
+  region->Swap(&dirty_region_);
+  dirty_region_.Clear();
+}
+
+}  // namespace libwebrtc
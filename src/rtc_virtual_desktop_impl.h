@@ -0,0 +1,70 @@
+#ifndef LIB_WEBRTC_RTC_VIRTUAL_DESKTOP_IMPL_HXX
+#define LIB_WEBRTC_RTC_VIRTUAL_DESKTOP_IMPL_HXX
+
+#include "rtc_virtual_desktop.h"
+
+#include "modules/desktop_capture/desktop_region.h"
+#include "rtc_base/synchronization/mutex.h"
+
+namespace libwebrtc {
+
+class RTCVirtualDesktopImpl : public RTCVirtualDesktop {
+ public:
+  // Maps |fd| read only, returns null on failure.
+  static scoped_refptr<RTCVirtualDesktopImpl> CreateFromFd(int fd,
+                                                           uint64_t offset,
+                                                           int width,
+                                                           int height,
+                                                           int stride);
+
+  static scoped_refptr<RTCVirtualDesktopImpl> CreateFromMemory(
+      const uint8_t* data,
+      int width,
+      int height,
+      int stride);
+
+  RTCVirtualDesktopImpl(const uint8_t* data,
+                        int width,
+                        int height,
+                        int stride,
+                        void* mapping,
+                        size_t mapping_size);
+  ~RTCVirtualDesktopImpl();
+
+  // MediaSource
+  string id() const override { return "virtual"; }
+  string name() const override { return "Virtual desktop"; }
+  portable::vector<unsigned char> thumbnail() const override {
+    return portable::vector<unsigned char>();
+  }
+  DesktopType type() const override { return kVirtual; }
+  bool UpdateThumbnail() override { return false; }
+
+  // RTCVirtualDesktop
+  void AddDirtyRect(int x, int y, int width, int height) override;
+  void SetDirty() override;
+  int width() const override { return width_; }
+  int height() const override { return height_; }
+
+  const uint8_t* data() const { return data_; }
+  int stride() const { return stride_; }
+
+  // Moves the rects marked dirty since the last call into |region|.
+  void TakeDirtyRegion(webrtc::DesktopRegion* region);
+
+ private:
+  const uint8_t* const data_;
+  const int width_;
+  const int height_;
+  const int stride_;
+  // The mmap()ed range that holds |data_|, if any.
+  void* const mapping_;
+  const size_t mapping_size_;
+
+  webrtc::Mutex mutex_;
+  webrtc::DesktopRegion dirty_region_ RTC_GUARDED_BY(mutex_);
+};
+
+}  // namespace libwebrtc
+
+#endif  // LIB_WEBRTC_RTC_VIRTUAL_DESKTOP_IMPL_HXX
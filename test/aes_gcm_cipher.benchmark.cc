@@ -0,0 +1,104 @@
+#include <thread>
+#include <vector>
+
+#include "api/crypto/frame_crypto_transformer.h"
+#include "benchmark.h"
+#include "rtc_base/buffer.h"
+#include "src/internal/aes_gcm_cipher.h"
+
+namespace libwebrtc {
+namespace test {
+
+namespace {
+
+const char kParticipant[] = "participant";
+
+struct FrameType {
+  const char* name;
+  size_t header_size;
+  size_t frame_size;
+  int iterations;
+};
+
+// Opus at 20 ms, a VP8 delta frame and a VP8 key frame at 720p.
+const FrameType kFrameTypes[] = {
+    {"audio 120 B", 1, 120, 200000},
+    {"video delta 1200 B", 3, 1200, 100000},
+    {"video key 40 KB", 10, 40 * 1024, 5000},
+};
+
+rtc::scoped_refptr<webrtc::KeyProvider> CreateKeyProvider() {
+  webrtc::KeyProviderOptions options;
+  options.shared_key = false;
+  options.ratchet_window_size = 0;
+  rtc::scoped_refptr<webrtc::DefaultKeyProviderImpl> key_provider(
+      new rtc::RefCountedObject<webrtc::DefaultKeyProviderImpl>(options));
+  key_provider->SetKey(kParticipant, 0, std::vector<uint8_t>(16, 0x42));
+  return key_provider;
+}
+
+void Seal(AesGcmCipher* cipher,
+          const FrameType& type,
+          const std::vector<uint8_t>& frame,
+          int iterations,
+          rtc::Buffer* sealed) {
+  uint8_t iv[AesGcmCipher::kIvSize] = {0};
+  rtc::ArrayView<const uint8_t> data(frame);
+  for (int i = 0; i < iterations; i++) {
+    iv[0] = static_cast<uint8_t>(i);
+    cipher->Seal(0, data.subview(0, type.header_size),
+                 data.subview(type.header_size), iv, sealed);
+  }
+}
+
+}  // namespace
+
+void RunAesGcmCipherBenchmark() {
+  rtc::scoped_refptr<webrtc::KeyProvider> key_provider = CreateKeyProvider();
+  AesGcmCipher cipher(kParticipant, key_provider, nullptr);
+  char name[64];
+
+  for (const FrameType& type : kFrameTypes) {
+    std::vector<uint8_t> frame(type.frame_size, 0x5a);
+    rtc::Buffer sealed;
+    rtc::Buffer opened;
+
+    Stopwatch seal;
+    Seal(&cipher, type, frame, type.iterations, &sealed);
+    snprintf(name, sizeof(name), "seal %s", type.name);
+    Report(name, type.iterations, seal.seconds(),
+           static_cast<int64_t>(type.iterations) * type.frame_size);
+
+    Stopwatch open;
+    for (int i = 0; i < type.iterations; i++) {
+      cipher.Open(sealed, type.header_size, &opened);
+    }
+    snprintf(name, sizeof(name), "open %s", type.name);
+    Report(name, type.iterations, open.seconds(),
+           static_cast<int64_t>(type.iterations) * type.frame_size);
+  }
+
+  // Streams of one participant seal concurrently, only the context lookup
+  // is shared.
+  const int kThreads = 4;
+  const FrameType& type = kFrameTypes[1];
+  std::vector<uint8_t> frame(type.frame_size, 0x5a);
+  Stopwatch parallel;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&] {
+      rtc::Buffer sealed;
+      Seal(&cipher, type, frame, type.iterations, &sealed);
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  snprintf(name, sizeof(name), "seal %s, %d threads", type.name, kThreads);
+  Report(name, static_cast<int64_t>(kThreads) * type.iterations,
+         parallel.seconds(),
+         static_cast<int64_t>(kThreads) * type.iterations * type.frame_size);
+}
+
+}  // namespace test
+}  // namespace libwebrtc
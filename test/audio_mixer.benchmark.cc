@@ -0,0 +1,114 @@
+#include <math.h>
+
+#include <vector>
+
+#include "benchmark.h"
+#include "rtc_audio_frame.h"
+#include "rtc_audio_mixer.h"
+
+namespace libwebrtc {
+namespace test {
+
+namespace {
+
+const int kSampleRate = 48000;
+const size_t kSamplesPerChannel = kSampleRate / 100;
+const size_t kMaxSpeakers = 3;
+const double kPi = 3.14159265358979323846;
+
+const int kInputCounts[] = {10, 25, 50, 100};
+
+// 10 ms per input: a tone of its own pitch and loudness, or silence for
+// every fourth input, as some participants of a conference are muted.
+std::vector<scoped_refptr<RTCAudioFrame>> CreateFrames(int inputs,
+                                                       size_t channels) {
+  std::vector<scoped_refptr<RTCAudioFrame>> frames;
+  std::vector<int16_t> samples(kSamplesPerChannel * channels);
+  for (int i = 0; i < inputs; i++) {
+    const double amplitude = 500 + 250 * (i % 40);
+    const double step = 2 * kPi * (200 + 10 * i) / kSampleRate;
+    for (size_t s = 0; s < kSamplesPerChannel; s++) {
+      for (size_t c = 0; c < channels; c++) {
+        samples[s * channels + c] =
+            static_cast<int16_t>(amplitude * sin(step * s));
+      }
+    }
+    scoped_refptr<RTCAudioFrame> frame =
+        RTCAudioFrame::Create(i, 0, samples.data(), kSamplesPerChannel,
+                              kSampleRate, channels);
+    if (i % 4 == 3) {
+      frame->Mute();
+    }
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
+// One round of the mixer: every input pushes 10 ms, then every participant
+// gets its N-1 mix.
+void RunMixer(int inputs, size_t channels, int rounds) {
+  scoped_refptr<RTCAudioMixer> mixer =
+      RTCAudioMixer::Create(kSampleRate, channels, kMaxSpeakers);
+  for (int i = 0; i < inputs; i++) {
+    mixer->AddInput(i);
+  }
+  std::vector<scoped_refptr<RTCAudioFrame>> frames =
+      CreateFrames(inputs, channels);
+  scoped_refptr<RTCAudioFrame> out = RTCAudioFrame::Create();
+
+  Stopwatch stopwatch;
+  for (int round = 0; round < rounds; round++) {
+    for (int i = 0; i < inputs; i++) {
+      mixer->PushAudio(i, frames[i]);
+    }
+    mixer->Mix();
+    for (int i = 0; i < inputs; i++) {
+      mixer->GetMix(i, out);
+    }
+  }
+  char name[64];
+  snprintf(name, sizeof(name), "mixer, %d inputs, %zu ch", inputs, channels);
+  Report(name, rounds, stopwatch.seconds(),
+         static_cast<int64_t>(rounds) * inputs * kSamplesPerChannel *
+             channels * sizeof(int16_t));
+}
+
+// The same N-1 mixes summed with RTCAudioFrame::Add() for every listener,
+// without speaker selection: what the mixer saves.
+void RunNaive(int inputs, size_t channels, int rounds) {
+  std::vector<scoped_refptr<RTCAudioFrame>> frames =
+      CreateFrames(inputs, channels);
+  scoped_refptr<RTCAudioFrame> out = RTCAudioFrame::Create();
+
+  Stopwatch stopwatch;
+  for (int round = 0; round < rounds; round++) {
+    for (int listener = 0; listener < inputs; listener++) {
+      out->CopyFrom(*frames[listener == 0 ? 1 : 0]);
+      for (int i = listener == 0 ? 2 : 1; i < inputs; i++) {
+        if (i != listener) {
+          out->Add(*frames[i]);
+        }
+      }
+    }
+  }
+  char name[64];
+  snprintf(name, sizeof(name), "naive N-1, %d inputs, %zu ch", inputs,
+           channels);
+  Report(name, rounds, stopwatch.seconds(),
+         static_cast<int64_t>(rounds) * inputs * kSamplesPerChannel *
+             channels * sizeof(int16_t));
+}
+
+}  // namespace
+
+void RunAudioMixerBenchmark() {
+  for (int inputs : kInputCounts) {
+    RunMixer(inputs, 1, 2000);
+    RunNaive(inputs, 1, 20000 / inputs);
+  }
+  RunMixer(100, 2, 2000);
+  RunNaive(100, 2, 100);
+}
+
+}  // namespace test
+}  // namespace libwebrtc
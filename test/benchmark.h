@@ -0,0 +1,68 @@
+#ifndef LIB_WEBRTC_TEST_BENCHMARK_H_
+#define LIB_WEBRTC_TEST_BENCHMARK_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <ctime>
+
+namespace libwebrtc {
+namespace test {
+
+// Wall clock of a benchmark run.
+class Stopwatch {
+ public:
+  Stopwatch() : start_(std::chrono::steady_clock::now()) {}
+
+  double seconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start_)
+        .count();
+  }
+
+ private:
+  std::chrono::steady_clock::time_point start_;
+};
+
+// CPU time of the whole process, for work paced by other threads.
+class CpuStopwatch {
+ public:
+  CpuStopwatch() : start_(std::clock()) {}
+
+  double seconds() const {
+    return static_cast<double>(std::clock() - start_) / CLOCKS_PER_SEC;
+  }
+
+ private:
+  std::clock_t start_;
+};
+
+// Prints one result line: iterations per second, and MB/s when |bytes|
+// were processed in total.
+inline void Report(const char* name,
+                   int64_t iterations,
+                   double seconds,
+                   int64_t bytes = 0) {
+  printf("%-48s %10.0f /s", name, iterations / seconds);
+  if (bytes > 0) {
+    printf(" %10.1f MB/s", bytes / seconds / (1024 * 1024));
+  }
+  printf(" %10.3f us each\n", seconds * 1e6 / iterations);
+}
+
+// Benchmarks, each in its own file. Those of internal classes are built
+// only when test/CMakeLists.txt is given the webrtc build to link them with.
+#ifdef LIB_WEBRTC_INTERNAL_BENCHMARKS
+void RunAesGcmCipherBenchmark();
+#endif
+void RunAudioMixerBenchmark();
+void RunDataChannelCryptorBenchmark();
+#ifdef RTC_DESKTOP_DEVICE
+void RunDesktopCapturerBenchmark();
+#endif
+
+}  // namespace test
+}  // namespace libwebrtc
+
+#endif  // LIB_WEBRTC_TEST_BENCHMARK_H_
@@ -0,0 +1,305 @@
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "libwebrtc.h"
+#include "rtc_data_channel.h"
+#include "rtc_frame_cryptor.h"
+#include "rtc_peerconnection.h"
+#include "rtc_peerconnection_factory.h"
+
+namespace libwebrtc {
+namespace test {
+
+namespace {
+
+const char kParticipant[] = "participant";
+
+// Bytes sent and not yet received, kept well below the 16 MB a data
+// channel buffers before it closes.
+const int64_t kWindowBytes = 1024 * 1024;
+
+struct Workload {
+  const char* name;
+  uint32_t message_size;
+  int messages;
+  bool encrypted;
+  // RTCDataChannelCryptorOptions::batch_max_bytes.
+  uint32_t batch_max_bytes;
+};
+
+// Chat and game state updates, and file transfer chunks, sent in the clear,
+// encrypted one by one and encrypted in batches.
+const Workload kWorkloads[] = {
+    {"plain, 64 B", 64, 50000, false, 0},
+    {"encrypted, 64 B", 64, 50000, true, 0},
+    {"encrypted batched, 64 B", 64, 50000, true, 16 * 1024},
+    {"plain, 1 KB", 1024, 20000, false, 0},
+    {"encrypted, 1 KB", 1024, 20000, true, 0},
+    {"encrypted batched, 1 KB", 1024, 20000, true, 16 * 1024},
+    {"plain, 16 KB", 16 * 1024, 2000, false, 0},
+    {"encrypted, 16 KB", 16 * 1024, 2000, true, 0},
+};
+
+// Counts the messages received on a channel, or waits for it to open.
+class ChannelObserver : public RTCDataChannelObserver {
+ public:
+  void OnStateChange(RTCDataChannelState state) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    open_ = state == RTCDataChannelOpen;
+    cv_.notify_all();
+  }
+
+  void OnMessage(const char* buffer, int length, bool binary) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    messages_++;
+    bytes_ += length;
+    cv_.notify_all();
+  }
+
+  bool WaitForOpen() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, std::chrono::seconds(10),
+                        [this] { return open_; });
+  }
+
+  // Waits until |bytes| were received, or 5 s without any message.
+  bool WaitForBytes(int64_t bytes) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (bytes_ < bytes) {
+      if (cv_.wait_for(lock, std::chrono::seconds(5)) ==
+          std::cv_status::timeout) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  int messages() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return messages_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool open_ = false;
+  int messages_ = 0;
+  int64_t bytes_ = 0;
+};
+
+// One end of the loopback connection, with a negotiated channel per
+// workload, so that no workload sees the messages of another.
+class Peer : public RTCPeerConnectionObserver {
+ public:
+  explicit Peer(scoped_refptr<RTCPeerConnectionFactory> factory)
+      : factory_(factory) {
+    RTCConfiguration configuration;
+    configuration.offer_to_receive_audio = false;
+    configuration.offer_to_receive_video = false;
+    pc_ = factory_->Create(configuration, RTCMediaConstraints::Create());
+    pc_->RegisterRTCPeerConnectionObserver(this);
+    for (size_t i = 0; i < sizeof(kWorkloads) / sizeof(kWorkloads[0]); i++) {
+      RTCDataChannelInit init;
+      init.negotiated = true;
+      init.id = static_cast<int>(i);
+      channels_.push_back(
+          pc_->CreateDataChannel("data_channel_cryptor_benchmark", &init));
+      observers_.emplace_back(new ChannelObserver());
+      channels_.back()->RegisterObserver(observers_.back().get());
+    }
+  }
+
+  ~Peer() override {
+    for (scoped_refptr<RTCDataChannel>& channel : channels_) {
+      channel->UnregisterObserver();
+      channel->Close();
+    }
+    channels_.clear();
+    pc_->DeRegisterRTCPeerConnectionObserver();
+    pc_->Close();
+    factory_->Delete(pc_);
+    pc_ = nullptr;
+  }
+
+  RTCPeerConnection* pc() { return pc_.get(); }
+
+  scoped_refptr<RTCDataChannel> channel(size_t i) { return channels_[i]; }
+
+  ChannelObserver* observer(size_t i) { return observers_[i].get(); }
+
+  // Creates the offer or answer and waits for its candidates, so that the
+  // description carries them and no candidates are exchanged on their own.
+  bool CreateDescription(bool offer, std::string* sdp, std::string* type) {
+    std::promise<bool> created;
+    auto success = [&created, sdp, type](const string s, const string t) {
+      *sdp = s.std_string();
+      *type = t.std_string();
+      created.set_value(true);
+    };
+    auto failure = [&created](const char* error) { created.set_value(false); };
+    if (offer) {
+      pc_->CreateOffer(success, failure, RTCMediaConstraints::Create());
+    } else {
+      pc_->CreateAnswer(success, failure, RTCMediaConstraints::Create());
+    }
+    if (!created.get_future().get() || !SetDescription(true, *sdp, *type)) {
+      return false;
+    }
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (!cv_.wait_for(lock, std::chrono::seconds(10),
+                        [this] { return gathered_; })) {
+        return false;
+      }
+      gathered_ = false;
+    }
+    std::promise<bool> got;
+    pc_->GetLocalDescription(
+        [&got, sdp, type](const char* s, const char* t) {
+          *sdp = s;
+          *type = t;
+          got.set_value(true);
+        },
+        [&got](const char* error) { got.set_value(false); });
+    return got.get_future().get();
+  }
+
+  bool SetDescription(bool local,
+                      const std::string& sdp,
+                      const std::string& type) {
+    std::promise<bool> set;
+    auto success = [&set]() { set.set_value(true); };
+    auto failure = [&set](const char* error) { set.set_value(false); };
+    if (local) {
+      pc_->SetLocalDescription(sdp, type, success, failure);
+    } else {
+      pc_->SetRemoteDescription(sdp, type, success, failure);
+    }
+    return set.get_future().get();
+  }
+
+  // RTCPeerConnectionObserver implementation.
+  void OnSignalingState(RTCSignalingState state) override {}
+  void OnPeerConnectionState(RTCPeerConnectionState state) override {}
+  void OnIceGatheringState(RTCIceGatheringState state) override {
+    if (state == RTCIceGatheringStateComplete) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      gathered_ = true;
+      cv_.notify_all();
+    }
+  }
+  void OnIceConnectionState(RTCIceConnectionState state) override {}
+  void OnIceCandidate(scoped_refptr<RTCIceCandidate> candidate) override {}
+  void OnAddStream(scoped_refptr<RTCMediaStream> stream) override {}
+  void OnRemoveStream(scoped_refptr<RTCMediaStream> stream) override {}
+  void OnDataChannel(scoped_refptr<RTCDataChannel> data_channel) override {}
+  void OnRenegotiationNeeded() override {}
+  void OnTrack(scoped_refptr<RTCRtpTransceiver> transceiver) override {}
+  void OnAddTrack(vector<scoped_refptr<RTCMediaStream>> streams,
+                  scoped_refptr<RTCRtpReceiver> receiver) override {}
+  void OnRemoveTrack(scoped_refptr<RTCRtpReceiver> receiver) override {}
+
+ private:
+  scoped_refptr<RTCPeerConnectionFactory> factory_;
+  scoped_refptr<RTCPeerConnection> pc_;
+  std::vector<scoped_refptr<RTCDataChannel>> channels_;
+  std::vector<std::unique_ptr<ChannelObserver>> observers_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool gathered_ = false;
+};
+
+bool Connect(Peer* offerer, Peer* answerer) {
+  std::string sdp;
+  std::string type;
+  return offerer->CreateDescription(true, &sdp, &type) &&
+         answerer->SetDescription(false, sdp, type) &&
+         answerer->CreateDescription(false, &sdp, &type) &&
+         offerer->SetDescription(false, sdp, type);
+}
+
+// Sends the messages of |workload| from |sender| to |receiver| as fast as
+// the window allows, and measures until the last one is received.
+void Run(Peer* sender,
+         Peer* receiver,
+         size_t index,
+         scoped_refptr<KeyProvider> key_provider) {
+  const Workload& workload = kWorkloads[index];
+  scoped_refptr<RTCDataChannel> channel = sender->channel(index);
+  ChannelObserver* received = receiver->observer(index);
+  if (!sender->observer(index)->WaitForOpen()) {
+    return;
+  }
+
+  scoped_refptr<RTCFrameCryptor> send_cryptor;
+  scoped_refptr<RTCFrameCryptor> receive_cryptor;
+  if (workload.encrypted) {
+    RTCDataChannelCryptorOptions options;
+    options.batch_max_bytes = workload.batch_max_bytes;
+    send_cryptor = FrameCryptorFactory::frameCryptorFromDataChannel(
+        kParticipant, channel, Algorithm::kAesGcm, key_provider, options);
+    receive_cryptor = FrameCryptorFactory::frameCryptorFromDataChannel(
+        kParticipant, receiver->channel(index), Algorithm::kAesGcm,
+        key_provider, options);
+    send_cryptor->SetEnabled(true);
+    receive_cryptor->SetEnabled(true);
+  }
+
+  std::vector<uint8_t> message(workload.message_size, 0x42);
+  const int64_t total =
+      static_cast<int64_t>(workload.messages) * workload.message_size;
+  Stopwatch stopwatch;
+  int64_t sent = 0;
+  for (int i = 0; i < workload.messages; i++) {
+    if (!received->WaitForBytes(sent - kWindowBytes)) {
+      break;
+    }
+    channel->Send(message.data(), workload.message_size, true);
+    sent += workload.message_size;
+  }
+  received->WaitForBytes(total);
+  const double seconds = stopwatch.seconds();
+
+  const int messages = received->messages();
+  if (messages > 0) {
+    Report(workload.name, messages, seconds,
+           static_cast<int64_t>(messages) * workload.message_size);
+  }
+}
+
+}  // namespace
+
+void RunDataChannelCryptorBenchmark() {
+  LibWebRTC::Initialize();
+  scoped_refptr<RTCPeerConnectionFactory> factory =
+      LibWebRTC::CreateRTCPeerConnectionFactory();
+  {
+    KeyProviderOptions options;
+    options.shared_key = true;
+    scoped_refptr<KeyProvider> key_provider = KeyProvider::Create(&options);
+    key_provider->SetKey(kParticipant, 0, std::vector<uint8_t>(16, 0x42));
+
+    Peer sender(factory);
+    Peer receiver(factory);
+    if (Connect(&sender, &receiver)) {
+      for (size_t i = 0; i < sizeof(kWorkloads) / sizeof(kWorkloads[0]);
+           i++) {
+        Run(&sender, &receiver, i, key_provider);
+      }
+    } else {
+      printf("could not connect the peer connections\n");
+    }
+  }
+  factory->Terminate();
+  factory = nullptr;
+  LibWebRTC::Terminate();
+}
+
+}  // namespace test
+}  // namespace libwebrtc
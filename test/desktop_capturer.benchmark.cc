@@ -0,0 +1,252 @@
+#include <string.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "benchmark.h"
+#include "libwebrtc.h"
+#include "rtc_desktop_capturer.h"
+#include "rtc_desktop_device.h"
+#include "rtc_peerconnection_factory.h"
+#include "rtc_video_frame.h"
+#include "rtc_video_renderer.h"
+#include "rtc_video_track.h"
+#include "rtc_virtual_desktop.h"
+
+namespace libwebrtc {
+namespace test {
+
+namespace {
+
+struct Scenario {
+  const char* name;
+  int width;
+  int height;
+  // The output size, or 0 to send the desktop at its own size.
+  int output_width;
+  int output_height;
+  // The rect redrawn before each frame, 0 to redraw the whole desktop or
+  // -1 to leave it unchanged.
+  int damage_size;
+  // Frames sent, or captures made at 60 fps when the desktop is unchanged.
+  int frames;
+  // Read from a memfd, as a headless compositor shares its framebuffer.
+  bool memfd;
+};
+
+// An idle screen, a text cursor blinking, a window redrawn and video
+// playing, on a 1080p screen, a 4K screen sent at 720p and a 5K screen sent
+// at 720p.
+const Scenario kScenarios[] = {
+    {"1080p, no damage", 1920, 1080, 0, 0, -1, 300, false},
+    {"1080p, 64x64 damage", 1920, 1080, 0, 0, 64, 300, false},
+    {"1080p, 640x480 damage", 1920, 1080, 0, 0, 640, 300, false},
+    {"1080p, full damage", 1920, 1080, 0, 0, 0, 120, false},
+    {"4K to 720p, 640x480 damage", 3840, 2160, 1280, 720, 640, 200, false},
+    {"4K to 720p, full damage", 3840, 2160, 1280, 720, 0, 60, false},
+    {"5K to 720p, full damage", 5120, 2880, 1280, 720, 0, 60, false},
+#ifdef __linux__
+    {"1080p memfd, 64x64 damage", 1920, 1080, 0, 0, 64, 300, true},
+    {"1080p memfd, full damage", 1920, 1080, 0, 0, 0, 120, true},
+#endif
+};
+
+// Fills |width| x |height| pixels at |x|, |y| with a new shade.
+void Draw(uint8_t* framebuffer,
+          int stride,
+          int x,
+          int y,
+          int width,
+          int height,
+          uint8_t shade) {
+  for (int row = y; row < y + height; row++) {
+    memset(framebuffer + row * stride + x * 4, shade, width * 4);
+  }
+}
+
+// Counts the frames and draws the damage of the next one. It is called on
+// the conversion thread of the capturer once a frame is converted, and the
+// next capture waits for that, so the framebuffer is never drawn while the
+// capturer reads it.
+class DamageRenderer : public RTCVideoRenderer<scoped_refptr<RTCVideoFrame>> {
+ public:
+  DamageRenderer(RTCVirtualDesktop* desktop,
+                 uint8_t* framebuffer,
+                 int stride,
+                 int damage_width,
+                 int damage_height)
+      : desktop_(desktop),
+        framebuffer_(framebuffer),
+        stride_(stride),
+        damage_width_(damage_width),
+        damage_height_(damage_height) {}
+
+  void OnFrame(scoped_refptr<RTCVideoFrame> frame) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (damage_width_ > 0) {
+      // Move the damage around, so that the pooled buffers miss different
+      // parts of the frame.
+      const int x = (frames_ * 97) % (desktop_->width() - damage_width_ + 1);
+      const int y =
+          (frames_ * 61) % (desktop_->height() - damage_height_ + 1);
+      Draw(framebuffer_, stride_, x, y, damage_width_, damage_height_,
+           static_cast<uint8_t>(frames_));
+      desktop_->AddDirtyRect(x, y, damage_width_, damage_height_);
+    }
+    frames_++;
+    cv_.notify_one();
+  }
+
+  // Waits until |frames| frames were rendered, or 5 s without any.
+  bool WaitFor(int frames) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (frames_ < frames) {
+      if (cv_.wait_for(lock, std::chrono::seconds(5)) ==
+          std::cv_status::timeout) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  int frames() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return frames_;
+  }
+
+ private:
+  RTCVirtualDesktop* desktop_;
+  uint8_t* framebuffer_;
+  int stride_;
+  int damage_width_;
+  int damage_height_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int frames_ = 0;
+};
+
+void Run(scoped_refptr<RTCPeerConnectionFactory> factory,
+         const Scenario& scenario) {
+  scoped_refptr<RTCDesktopDevice> device = factory->GetDesktopDevice();
+  const int stride = scenario.width * 4;
+  const size_t size = static_cast<size_t>(stride) * scenario.height;
+  std::vector<uint8_t> memory;
+  uint8_t* framebuffer = nullptr;
+  scoped_refptr<RTCVirtualDesktop> desktop;
+#ifdef __linux__
+  if (scenario.memfd) {
+    // The desktop maps the memfd on its own, read only.
+    int fd = memfd_create("desktop_capturer_benchmark", 0);
+    if (fd < 0 || ftruncate(fd, size) != 0) {
+      return;
+    }
+    void* mapped =
+        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    desktop = device->CreateVirtualDesktop(fd, 0, scenario.width,
+                                           scenario.height, stride);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+      return;
+    }
+    if (!desktop) {
+      munmap(mapped, size);
+      return;
+    }
+    framebuffer = static_cast<uint8_t*>(mapped);
+  }
+#endif
+  if (!framebuffer) {
+    memory.resize(size);
+    framebuffer = memory.data();
+    desktop = device->CreateVirtualDesktop(framebuffer, scenario.width,
+                                           scenario.height, stride);
+  }
+  memset(framebuffer, 0x80, size);
+  scoped_refptr<RTCDesktopCapturer> capturer =
+      device->CreateDesktopCapturer(desktop);
+  if (scenario.output_width) {
+    capturer->SetOutputSize(scenario.output_width, scenario.output_height,
+                            RTCDesktopCapturer::SP_FIT);
+  }
+  // Static content is captured at the full rate rather than backed off,
+  // to measure what each capture of it costs.
+  capturer->SetFramerateRange(60, 60);
+
+  int damage_width = 0;
+  int damage_height = 0;
+  if (scenario.damage_size > 0) {
+    damage_width = scenario.damage_size;
+    damage_height = scenario.damage_size * 3 / 4;
+  } else if (scenario.damage_size == 0) {
+    damage_width = scenario.width;
+    damage_height = scenario.height;
+  }
+  // Frames reach the renderer the way they reach an encoder, through the
+  // source and track of the capturer.
+  scoped_refptr<RTCVideoTrack> track = factory->CreateVideoTrack(
+      factory->CreateDesktopSource(capturer, "desktop_capturer_benchmark",
+                                   RTCMediaConstraints::Create()),
+      "desktop_capturer_benchmark");
+  DamageRenderer renderer(desktop.get(), framebuffer, stride, damage_width,
+                          damage_height);
+  track->AddRenderer(&renderer);
+  capturer->Start(60);
+  // The first frame is converted in full.
+  renderer.WaitFor(1);
+
+  // Capture is paced, so the CPU time of the pipeline is measured rather
+  // than the wall clock.
+  CpuStopwatch cpu;
+  int frames = 0;
+  if (damage_width > 0) {
+    frames = renderer.WaitFor(1 + scenario.frames) ? scenario.frames
+                                                   : renderer.frames() - 1;
+  } else {
+    // Nothing is converted and only a repeat frame is sent each second, so
+    // the captures are counted from the rate they are made at.
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(scenario.frames * 1000 / 60));
+    frames = scenario.frames;
+  }
+  const double seconds = cpu.seconds();
+
+  capturer->Stop();
+  track->RemoveRenderer(&renderer);
+  track = nullptr;
+  capturer = nullptr;
+  desktop = nullptr;
+#ifdef __linux__
+  if (memory.empty()) {
+    munmap(framebuffer, size);
+  }
+#endif
+  if (frames > 0) {
+    Report(scenario.name, frames, seconds,
+           static_cast<int64_t>(frames) * damage_width * damage_height * 4);
+  }
+}
+
+}  // namespace
+
+void RunDesktopCapturerBenchmark() {
+  LibWebRTC::Initialize();
+  scoped_refptr<RTCPeerConnectionFactory> factory =
+      LibWebRTC::CreateRTCPeerConnectionFactory();
+  for (const Scenario& scenario : kScenarios) {
+    Run(factory, scenario);
+  }
+  factory->Terminate();
+  factory = nullptr;
+  LibWebRTC::Terminate();
+}
+
+}  // namespace test
+}  // namespace libwebrtc
@@ -0,0 +1,36 @@
+#include <string.h>
+
+#include "benchmark.h"
+
+using namespace libwebrtc::test;
+
+struct Benchmark {
+  const char* name;
+  void (*run)();
+};
+
+static const Benchmark kBenchmarks[] = {
+#ifdef LIB_WEBRTC_INTERNAL_BENCHMARKS
+    {"aes_gcm_cipher", RunAesGcmCipherBenchmark},
+#endif
+    {"audio_mixer", RunAudioMixerBenchmark},
+    {"data_channel_cryptor", RunDataChannelCryptorBenchmark},
+#ifdef RTC_DESKTOP_DEVICE
+    {"desktop_capturer", RunDesktopCapturerBenchmark},
+#endif
+};
+
+// Runs every benchmark, or the ones named on the command line.
+int main(int argc, char** argv) {
+  for (const Benchmark& benchmark : kBenchmarks) {
+    bool selected = argc < 2;
+    for (int i = 1; i < argc; i++) {
+      selected |= strcmp(argv[i], benchmark.name) == 0;
+    }
+    if (selected) {
+      printf("== %s\n", benchmark.name);
+      benchmark.run();
+    }
+  }
+  return 0;
+}